@@ -1,612 +1,4400 @@
-/* wfc.h - v0.3 - public domain data structures - nickscha 2025
-
-A C89 standard compliant, single header, nostdlib (no C Standard Library) Wave Function Collapse (WFC).
-
-This Test class defines cases to verify that we don't break the excepted behaviours in the future upon changes.
-
-LICENSE
-
-  Placed in the public domain and also MIT licensed.
-  See end of file for detailed license information.
-
-*/
-#include "../wfc.h"         /* Wave Function Collapse      */
-#include "../deps/test.h"   /* Simple Testing framework    */
-#include "../deps/perf.h"   /* Simple Performance profiler */
-#include "wfc_visualizer.h" /* Export grid as ppm file     */
-
-static void wfc_test_socket(void)
-{
-  wfc_socket_8x07 socket = wfc_socket_pack_8(0, 1, 2, 3, 4, 5, 6, 7);
-  wfc_socket_8x07 reversed;
-
-  assert(wfc_socket_unpack(socket, 0) == 0);
-  assert(wfc_socket_unpack(socket, 1) == 1);
-  assert(wfc_socket_unpack(socket, 2) == 2);
-  assert(wfc_socket_unpack(socket, 3) == 3);
-  assert(wfc_socket_unpack(socket, 4) == 4);
-  assert(wfc_socket_unpack(socket, 5) == 5);
-  assert(wfc_socket_unpack(socket, 6) == 6);
-  assert(wfc_socket_unpack(socket, 7) == 7);
-
-  /* Reverse hole socket */
-  reversed = wfc_socket_reverse(socket, 8);
-
-  assert(wfc_socket_unpack(reversed, 0) == 7);
-  assert(wfc_socket_unpack(reversed, 1) == 6);
-  assert(wfc_socket_unpack(reversed, 2) == 5);
-  assert(wfc_socket_unpack(reversed, 3) == 4);
-  assert(wfc_socket_unpack(reversed, 4) == 3);
-  assert(wfc_socket_unpack(reversed, 5) == 2);
-  assert(wfc_socket_unpack(reversed, 6) == 1);
-  assert(wfc_socket_unpack(reversed, 7) == 0);
-
-  /* Reverse only the first three entries */
-  reversed = wfc_socket_reverse(socket, 3);
-
-  assert(wfc_socket_unpack(reversed, 0) == 2);
-  assert(wfc_socket_unpack(reversed, 1) == 1);
-  assert(wfc_socket_unpack(reversed, 2) == 0);
-
-  socket = wfc_socket_pack(socket, 2, 0);
-
-  assert(wfc_socket_unpack(socket, 2) == 0);
-}
-
-static void wfc_test_grid_incides(void)
-{
-  int x = 0;
-  int y = 0;
-  int cols = 4;
-  int cell_index = wfc_grid_index_at(2, 2, cols);
-
-  /* base */
-  wfc_grid_coords_at(cell_index, cols, &x, &y);
-  assert(x == 2 && y == 2);
-
-  /* top */
-  wfc_grid_coords_at(cell_index - cols, cols, &x, &y);
-  assert(x == 2 && y == 1);
-
-  /* bottom */
-  wfc_grid_coords_at(cell_index + cols, cols, &x, &y);
-  assert(x == 2 && y == 3);
-
-  /* left */
-  wfc_grid_coords_at(cell_index - 1, cols, &x, &y);
-  assert(x == 1 && y == 2);
-
-  /* right */
-  wfc_grid_coords_at(cell_index + 1, cols, &x, &y);
-  assert(x == 3 && y == 2);
-}
-
-static void wfc_test_tile_stack_alloc(void)
-{
-#define TILES_CAPACTIY 128
-#define TILES_DIRECTION_COUNT 4
-
-  unsigned char tiles_memory[WFC_TILES_MEMORY_SIZE(TILES_CAPACTIY, TILES_DIRECTION_COUNT)];
-
-  wfc_tiles tiles = {0};
-  tiles.tile_capacity = TILES_CAPACTIY;               /* 5 tiles */
-  tiles.tile_direction_count = TILES_DIRECTION_COUNT; /* 4 directions */
-  tiles.tile_direction_socket_count = 3;              /* 3 values per direction */
-
-  assert(wfc_tiles_initialize(&tiles, tiles_memory, (unsigned int)(sizeof(tiles_memory) / sizeof(tiles_memory[0]))));
-}
-
-static void wfc_test_tile_rotation_symmetrical_sockets(void)
-{
-  unsigned char *tiles_memory;
-  unsigned int tiles_memory_size = 0;
-  wfc_socket_8x07 socket_buffer[4];
-
-  wfc_tiles tiles = {0};
-  tiles.tile_capacity = 5;               /* 5 tiles */
-  tiles.tile_direction_count = 4;        /* 4 directions */
-  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
-
-  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
-  tiles_memory = malloc(tiles_memory_size);
-
-  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
-
-  /* Setup tile sockets */
-
-  /* Tile 0 (empty, no rotation required):
-     "   "
-     "   "
-     "   "
-  */
-  socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
-  socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
-  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
-  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
-
-  /* Add tile without additional rotations */
-  wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
-
-  /* Tile 1 (cross, rotate 3 times for each direction):
-     " # "
-     "###"
-     "   "
-  */
-  socket_buffer[0] = wfc_socket_pack_4(0, 1, 0, 0); /* Top    */
-  socket_buffer[1] = wfc_socket_pack_4(0, 1, 0, 0); /* Right  */
-  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
-  socket_buffer[3] = wfc_socket_pack_4(0, 1, 0, 0); /* Left   */
-
-  /* Add tile with three rotations */
-  wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
-
-  assert(tiles.tile_count == 5);
-  assert(tiles.tile_asset_ids[0] == 0);
-  assert(tiles.tile_asset_ids[1] == 1);
-  assert(tiles.tile_asset_ids[2] == 1);
-  assert(tiles.tile_asset_ids[3] == 1);
-  assert(tiles.tile_asset_ids[4] == 1);
-  assert(tiles.tile_rotations[0] == 0);
-  assert(tiles.tile_rotations[1] == 0);
-  assert(tiles.tile_rotations[2] == 1);
-  assert(tiles.tile_rotations[3] == 2);
-  assert(tiles.tile_rotations[4] == 3);
-
-  /* Check original tile 1 sockets
-     " # "
-     "###"
-     "   "
-  */
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 0, 0, 0));
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 0, 0));
-
-  /* Check first rotated tile 1 sockets
-     " # "
-     " ##"
-     " # "
-   */
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 0, 0, 0));
-
-  /* Check second rotated tile 1 sockets
-     "   "
-     "###"
-     " # "
-   */
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 0, 0, 0));
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 0, 0));
-
-  /* Check third rotated tile 1 sockets
-     " # "
-     "## "
-     " # "
-   */
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 0, 0, 0));
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 0, 0));
-
-  free(tiles_memory);
-}
-
-static void wfc_test_tile_rotation_asymmetrical_sockets(void)
-{
-  unsigned char *tiles_memory;
-  unsigned int tiles_memory_size = 0;
-  wfc_socket_8x07 socket_buffer[4];
-
-  wfc_tiles tiles = {0};
-  tiles.tile_capacity = 5;               /* 5 tiles */
-  tiles.tile_direction_count = 4;        /* 4 directions */
-  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
-
-  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
-  tiles_memory = malloc(tiles_memory_size);
-
-  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
-
-  /* Setup tile sockets */
-
-  /* Tile 0 (empty, no rotation required):
-     "   "
-     "   "
-     "   "
-  */
-  socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
-  socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
-  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
-  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
-
-  /* Add tile without additional rotations */
-  wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
-
-  /* Tile 1 (uneven, rotate 3 times for each direction):
-     "## "
-     "## "
-     "  #"
-  */
-  socket_buffer[0] = wfc_socket_pack_4(1, 1, 0, 0); /* Top    */
-  socket_buffer[1] = wfc_socket_pack_4(0, 0, 1, 0); /* Right  */
-  socket_buffer[2] = wfc_socket_pack_4(1, 0, 0, 0); /* Bottom */
-  socket_buffer[3] = wfc_socket_pack_4(0, 1, 1, 0); /* Left   */
-
-  /* Add tile with three rotations */
-  wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
-
-  assert(tiles.tile_count == 5);
-  assert(tiles.tile_asset_ids[0] == 0);
-  assert(tiles.tile_asset_ids[1] == 1);
-  assert(tiles.tile_asset_ids[2] == 1);
-  assert(tiles.tile_asset_ids[3] == 1);
-  assert(tiles.tile_asset_ids[4] == 1);
-  assert(tiles.tile_rotations[0] == 0);
-  assert(tiles.tile_rotations[1] == 0);
-  assert(tiles.tile_rotations[2] == 1);
-  assert(tiles.tile_rotations[3] == 2);
-  assert(tiles.tile_rotations[4] == 3);
-
-  /* Check original tile 1 sockets
-     "## "
-     "## "
-     "  #"
-  */
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(1, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 0, 1, 0));
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(1, 0, 0, 0));
-  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 1, 0));
-
-  /* Check first rotated tile 1 sockets
-     " ##"
-     " ##"
-     "#  "
-   */
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 1, 0));
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(1, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 0, 1, 0));
-  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(1, 0, 0, 0));
-
-  /* Check second rotated tile 1 sockets
-     "#  "
-     " ##"
-     " ##"
-   */
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(1, 0, 0, 0));
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 1, 0));
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(1, 1, 0, 0));
-  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 0, 1, 0));
-
-  /* Check third rotated tile 1 sockets
-     "  #"
-     "## "
-     "## "
-   */
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 0, 1, 0));
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(1, 0, 0, 0));
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 1, 0));
-  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(1, 1, 0, 0));
-
-  free(tiles_memory);
-}
-
-static void wfc_test_tile_compute_compatible_tiles(void)
-{
-  unsigned char *tiles_memory;
-  unsigned int tiles_memory_size = 0;
-  wfc_socket_8x07 socket_buffer[4];
-
-  wfc_tiles tiles = {0};
-  tiles.tile_capacity = 5;               /* 5 tiles */
-  tiles.tile_direction_count = 4;        /* 4 directions */
-  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
-
-  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
-  tiles_memory = malloc(tiles_memory_size);
-
-  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
-
-  /* Setup tile sockets */
-
-  /* Tile 0 (empty, no rotation required):
-     "   "
-     "   "
-     "   "
-  */
-  socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
-  socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
-  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
-  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
-
-  /* Add tile without additional rotations */
-  wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
-
-  /* Tile 1 (uneven, rotate 3 times for each direction):
-     " # "
-     " ##"
-     " # "
-  */
-  socket_buffer[0] = wfc_socket_pack_4(0, 1, 0, 0); /* Top    */
-  socket_buffer[1] = wfc_socket_pack_4(0, 1, 0, 0); /* Right  */
-  socket_buffer[2] = wfc_socket_pack_4(0, 1, 0, 0); /* Bottom */
-  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
-
-  /* Add tile with three rotations */
-  wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
-
-  assert(tiles.tile_count == 5);
-
-  /* Compute possible adjacent tiles for each direction of each current tile */
-  assert(wfc_tiles_compute_compatible_tiles(&tiles));
-
-  {
-    /* Tile 0. Direction top (0). Two compatible tiles expected:
-     "   "
-     "   "
-     "   "
-    */
-    /* Top */
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 0, 0)); /* Tile is compatible with itself */
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 0, 1));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 0, 2));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 0, 3));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 0, 4));
-
-    /* Right */
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 1, 0)); /* Tile is compatible with itself */
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 1, 1));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 1, 2));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 1, 3));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 1, 4));
-
-    /* Bottom */
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 2, 0)); /* Tile is compatible with itself */
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 2, 1));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 2, 2));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 2, 3));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 2, 4));
-
-    /* Left */
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 3, 0)); /* Tile is compatible with itself */
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 3, 1));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 3, 2));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 3, 3));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 3, 4));
-
-    /* Tile 1. Direction top (0). Three compatible tiles expected:
-       " # "
-       " ##"
-       " # "
-    */
-    /* Top */
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 0, 0));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 0, 1)); /* Tile is compatible with itself */
-    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 0, 2));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 0, 3));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 0, 4));
-
-    /* Right */
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 1, 0));
-    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 1, 1));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 1, 2));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 1, 3));
-    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 1, 4));
-  }
-
-  free(tiles_memory);
-}
-
-static void wfc_test_simple_tiles(void)
-{
-  unsigned char *tiles_memory;
-  unsigned int tiles_memory_size = 0;
-
-  wfc_tiles tiles = {0};
-  tiles.tile_capacity = 5;               /* 5 tiles */
-  tiles.tile_direction_count = 4;        /* 4 directions */
-  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
-
-  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
-  tiles_memory = malloc(tiles_memory_size);
-
-  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
-
-  /* Setup tile sockets */
-  {
-    wfc_socket_8x07 socket_buffer[4];
-
-    /* Tile 0 (empty, no rotation required):
-       "   "
-       "   "
-       "   "
-    */
-    socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
-    socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
-    socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
-    socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
-
-    /* Add tile without additional rotations */
-    wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
-
-    /* Tile 1 (cross, rotate 3 times for each direction):
-       " # "
-       "###"
-       "   "
-    */
-    socket_buffer[0] = wfc_socket_pack_4(0, 1, 0, 0); /* Top    */
-    socket_buffer[1] = wfc_socket_pack_4(0, 1, 0, 0); /* Right  */
-    socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
-    socket_buffer[3] = wfc_socket_pack_4(0, 1, 0, 0); /* Left   */
-
-    /* Add tile with three rotations */
-    wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
-
-    assert(tiles.tile_count == 5);
-    assert(wfc_tiles_compute_compatible_tiles(&tiles));
-  }
-
-  {
-    unsigned int retries = 0;
-    unsigned char *grid_memory;
-    unsigned int grid_memory_size = 0;
-
-    wfc_grid grid = {0};
-    grid.cols = 128;
-    grid.rows = 128;
-
-    grid_memory_size = WFC_GRID_MEMORY_SIZE(grid.rows, grid.cols, tiles.tile_count);
-
-    printf("[wfc] tiles_memory_size (mb): %10.6f\n", (double)tiles_memory_size / 1024.0 / 1024.0);
-    printf("[wfc]  grid_memory_size (mb): %10.6f\n", (double)grid_memory_size / 1024.0 / 1024.0);
-    printf("[wfc]        total_size (mb): %10.6f\n", ((double)tiles_memory_size / 1024.0 / 1024.0) + ((double)grid_memory_size / 1024.0 / 1024.0));
-
-    grid_memory = malloc(grid_memory_size);
-
-    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
-    assert(grid.cell_collapsed[0] == 0);
-    assert(grid.cell_entropy_count[0] == tiles.tile_count);
-    assert(grid.cell_collapsed[grid.rows * grid.cols - 1] == 0);
-    assert(grid.cell_entropy_count[grid.rows * grid.cols - 1] == tiles.tile_count);
-
-    /* Run WFC */
-    wfc_seed_lcg = 1337;
-
-    PERF_PROFILE_WITH_NAME({
-    while (!wfc(&grid, &tiles))
-    {
-      printf("[wfc] retry\n");
-
-      wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size);
-      wfc_seed_lcg += 1;
-      retries++;
-    } }, "wfc_solve_5_tiles_128x128_grid");
-
-    {
-      int idx;
-      int uncollapsed_cells = 0;
-      int unsolvable_cells = 0;
-      int unfinished_cells = 0;
-
-      for (idx = 0; idx < (int)(grid.cols * grid.rows); ++idx)
-      {
-        if (!grid.cell_collapsed[idx])
-        {
-          uncollapsed_cells++;
-        }
-        else if (grid.cell_entropy_count[idx] == 0)
-        {
-          unsolvable_cells++;
-        }
-        else if (grid.cell_entropy_count[idx] > 1)
-        {
-          unfinished_cells++;
-        }
-      }
-
-      assert(uncollapsed_cells == 0);
-      assert(unsolvable_cells == 0);
-      assert(unfinished_cells == 0);
-    }
-
-    printf("[wfc] solved grid after %d retries\n", retries);
-
-    /* Export WFC to PPM */
-    {
-      /* These represent the tiles for visualization purposes */
-      char *tile_0 =
-          "   " /*   */
-          "   " /*   */
-          "   " /*   */;
-
-      char *tile_1 =
-          " # " /*   */
-          "###" /*   */
-          "   " /*   */;
-
-      char *tile_2 =
-          " # " /*   */
-          " ##" /*   */
-          " # " /*   */;
-
-      char *tile_3 =
-          "   " /*   */
-          "###" /*   */
-          " # " /*   */;
-
-      char *tile_4 =
-          " # " /*   */
-          "## " /*   */
-          " # " /*   */;
-
-      char *tile_chars[5];
-      tile_chars[0] = tile_0;
-      tile_chars[1] = tile_1;
-      tile_chars[2] = tile_2;
-      tile_chars[3] = tile_3;
-      tile_chars[4] = tile_4;
-
-      wfc_export_ppm(&grid, &tiles, tile_chars, (int)(sizeof(tile_chars) / sizeof(tile_chars[0])), "wfc.ppm", 2, 1, 0, 3, 3);
-    }
-  }
-
-  free(tiles_memory);
-}
-
-int main(void)
-{
-  wfc_test_socket();
-  wfc_test_grid_incides();
-  wfc_test_tile_stack_alloc();
-  wfc_test_tile_rotation_symmetrical_sockets();
-  wfc_test_tile_rotation_asymmetrical_sockets();
-  wfc_test_tile_compute_compatible_tiles();
-  wfc_test_simple_tiles();
-
-  return 0;
-}
-
-/*
-   -----------------------------------------------------------------------------
-   This software is available under 2 licenses -- choose whichever you prefer.
-   ------------------------------------------------------------------------------
-   ALTERNATIVE A - MIT License
-   Copyright (c) 2025 nickscha
-   Permission is hereby granted, free of charge, to any person obtaining a copy of
-   this software and associated documentation files (the "Software"), to deal in
-   the Software without restriction, including without limitation the rights to
-   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
-   of the Software, and to permit persons to whom the Software is furnished to do
-   so, subject to the following conditions:
-   The above copyright notice and this permission notice shall be included in all
-   copies or substantial portions of the Software.
-   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-   SOFTWARE.
-   ------------------------------------------------------------------------------
-   ALTERNATIVE B - Public Domain (www.unlicense.org)
-   This is free and unencumbered software released into the public domain.
-   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
-   software, either in source code form or as a compiled binary, for any purpose,
-   commercial or non-commercial, and by any means.
-   In jurisdictions that recognize copyright laws, the author or authors of this
-   software dedicate any and all copyright interest in the software to the public
-   domain. We make this dedication for the benefit of the public at large and to
-   the detriment of our heirs and successors. We intend this dedication to be an
-   overt act of relinquishment in perpetuity of all present and future rights to
-   this software under copyright law.
-   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
-   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
-   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-   ------------------------------------------------------------------------------
-*/
+/* wfc.h - v0.3 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) Wave Function Collapse (WFC).
+
+This Test class defines cases to verify that we don't break the excepted behaviours in the future upon changes.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#define WFC_THREADS                 /* Enable the thread shim      */
+#include "../wfc.h"         /* Wave Function Collapse      */
+#include "../deps/test.h"   /* Simple Testing framework    */
+#if defined(__linux__) && defined(_STRUCT_TIMESPEC)
+/* glibc's pthread.h (pulled in by WFC_THREADS) defines struct timespec behind _STRUCT_TIMESPEC, while the
+   vendored perf.h only checks __timespec_defined. Kept here so that refreshing deps/ can not undo it */
+#define __timespec_defined
+#endif
+#include "../deps/perf.h"   /* Simple Performance profiler */
+#include "wfc_visualizer.h" /* Export grid as ppm file     */
+#include "wfc_test_tiles_simple.h" /* Generated tile set  */
+
+static void wfc_test_socket(void)
+{
+  wfc_socket_8x07 socket = wfc_socket_pack_8(0, 1, 2, 3, 4, 5, 6, 7);
+  wfc_socket_8x07 reversed;
+
+  assert(wfc_socket_unpack(socket, 0) == 0);
+  assert(wfc_socket_unpack(socket, 1) == 1);
+  assert(wfc_socket_unpack(socket, 2) == 2);
+  assert(wfc_socket_unpack(socket, 3) == 3);
+  assert(wfc_socket_unpack(socket, 4) == 4);
+  assert(wfc_socket_unpack(socket, 5) == 5);
+  assert(wfc_socket_unpack(socket, 6) == 6);
+  assert(wfc_socket_unpack(socket, 7) == 7);
+
+  /* Reverse hole socket */
+  reversed = wfc_socket_reverse(socket, 8);
+
+  assert(wfc_socket_unpack(reversed, 0) == 7);
+  assert(wfc_socket_unpack(reversed, 1) == 6);
+  assert(wfc_socket_unpack(reversed, 2) == 5);
+  assert(wfc_socket_unpack(reversed, 3) == 4);
+  assert(wfc_socket_unpack(reversed, 4) == 3);
+  assert(wfc_socket_unpack(reversed, 5) == 2);
+  assert(wfc_socket_unpack(reversed, 6) == 1);
+  assert(wfc_socket_unpack(reversed, 7) == 0);
+
+  /* Reverse only the first three entries */
+  reversed = wfc_socket_reverse(socket, 3);
+
+  assert(wfc_socket_unpack(reversed, 0) == 2);
+  assert(wfc_socket_unpack(reversed, 1) == 1);
+  assert(wfc_socket_unpack(reversed, 2) == 0);
+
+  socket = wfc_socket_pack(socket, 2, 0);
+
+  assert(wfc_socket_unpack(socket, 2) == 0);
+}
+
+static void wfc_test_grid_incides(void)
+{
+  int x = 0;
+  int y = 0;
+  int cols = 4;
+  int cell_index = wfc_grid_index_at(2, 2, cols);
+
+  /* base */
+  wfc_grid_coords_at(cell_index, cols, &x, &y);
+  assert(x == 2 && y == 2);
+
+  /* top */
+  wfc_grid_coords_at(cell_index - cols, cols, &x, &y);
+  assert(x == 2 && y == 1);
+
+  /* bottom */
+  wfc_grid_coords_at(cell_index + cols, cols, &x, &y);
+  assert(x == 2 && y == 3);
+
+  /* left */
+  wfc_grid_coords_at(cell_index - 1, cols, &x, &y);
+  assert(x == 1 && y == 2);
+
+  /* right */
+  wfc_grid_coords_at(cell_index + 1, cols, &x, &y);
+  assert(x == 3 && y == 2);
+}
+
+static void wfc_test_tile_stack_alloc(void)
+{
+#define TILES_CAPACTIY 128
+#define TILES_DIRECTION_COUNT 4
+
+  unsigned char tiles_memory[WFC_TILES_MEMORY_SIZE(TILES_CAPACTIY, TILES_DIRECTION_COUNT)];
+
+  wfc_tiles tiles = {0};
+  tiles.tile_capacity = TILES_CAPACTIY;               /* 5 tiles */
+  tiles.tile_direction_count = TILES_DIRECTION_COUNT; /* 4 directions */
+  tiles.tile_direction_socket_count = 3;              /* 3 values per direction */
+
+  assert(wfc_tiles_initialize(&tiles, tiles_memory, (unsigned int)(sizeof(tiles_memory) / sizeof(tiles_memory[0]))));
+}
+
+static void wfc_test_tile_rotation_symmetrical_sockets(void)
+{
+  unsigned char *tiles_memory;
+  unsigned int tiles_memory_size = 0;
+  wfc_socket_8x07 socket_buffer[4];
+
+  wfc_tiles tiles = {0};
+  tiles.tile_capacity = 5;               /* 5 tiles */
+  tiles.tile_direction_count = 4;        /* 4 directions */
+  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
+
+  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
+  tiles_memory = malloc(tiles_memory_size);
+
+  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
+
+  /* Setup tile sockets */
+
+  /* Tile 0 (empty, no rotation required):
+     "   "
+     "   "
+     "   "
+  */
+  socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
+  socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
+  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
+  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
+
+  /* Add tile without additional rotations */
+  wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
+
+  /* Tile 1 (cross, rotate 3 times for each direction):
+     " # "
+     "###"
+     "   "
+  */
+  socket_buffer[0] = wfc_socket_pack_4(0, 1, 0, 0); /* Top    */
+  socket_buffer[1] = wfc_socket_pack_4(0, 1, 0, 0); /* Right  */
+  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
+  socket_buffer[3] = wfc_socket_pack_4(0, 1, 0, 0); /* Left   */
+
+  /* Add tile with three rotations */
+  wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
+
+  assert(tiles.tile_count == 5);
+  assert(tiles.tile_asset_ids[0] == 0);
+  assert(tiles.tile_asset_ids[1] == 1);
+  assert(tiles.tile_asset_ids[2] == 1);
+  assert(tiles.tile_asset_ids[3] == 1);
+  assert(tiles.tile_asset_ids[4] == 1);
+  assert(tiles.tile_rotations[0] == 0);
+  assert(tiles.tile_rotations[1] == 0);
+  assert(tiles.tile_rotations[2] == 1);
+  assert(tiles.tile_rotations[3] == 2);
+  assert(tiles.tile_rotations[4] == 3);
+
+  /* Check original tile 1 sockets
+     " # "
+     "###"
+     "   "
+  */
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 0, 0, 0));
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 0, 0));
+
+  /* Check first rotated tile 1 sockets
+     " # "
+     " ##"
+     " # "
+   */
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 0, 0, 0));
+
+  /* Check second rotated tile 1 sockets
+     "   "
+     "###"
+     " # "
+   */
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 0, 0, 0));
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 0, 0));
+
+  /* Check third rotated tile 1 sockets
+     " # "
+     "## "
+     " # "
+   */
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 0, 0, 0));
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 0, 0));
+
+  free(tiles_memory);
+}
+
+static void wfc_test_tile_rotation_asymmetrical_sockets(void)
+{
+  unsigned char *tiles_memory;
+  unsigned int tiles_memory_size = 0;
+  wfc_socket_8x07 socket_buffer[4];
+
+  wfc_tiles tiles = {0};
+  tiles.tile_capacity = 5;               /* 5 tiles */
+  tiles.tile_direction_count = 4;        /* 4 directions */
+  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
+
+  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
+  tiles_memory = malloc(tiles_memory_size);
+
+  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
+
+  /* Setup tile sockets */
+
+  /* Tile 0 (empty, no rotation required):
+     "   "
+     "   "
+     "   "
+  */
+  socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
+  socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
+  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
+  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
+
+  /* Add tile without additional rotations */
+  wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
+
+  /* Tile 1 (uneven, rotate 3 times for each direction):
+     "## "
+     "## "
+     "  #"
+  */
+  socket_buffer[0] = wfc_socket_pack_4(1, 1, 0, 0); /* Top    */
+  socket_buffer[1] = wfc_socket_pack_4(0, 0, 1, 0); /* Right  */
+  socket_buffer[2] = wfc_socket_pack_4(1, 0, 0, 0); /* Bottom */
+  socket_buffer[3] = wfc_socket_pack_4(0, 1, 1, 0); /* Left   */
+
+  /* Add tile with three rotations */
+  wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
+
+  assert(tiles.tile_count == 5);
+  assert(tiles.tile_asset_ids[0] == 0);
+  assert(tiles.tile_asset_ids[1] == 1);
+  assert(tiles.tile_asset_ids[2] == 1);
+  assert(tiles.tile_asset_ids[3] == 1);
+  assert(tiles.tile_asset_ids[4] == 1);
+  assert(tiles.tile_rotations[0] == 0);
+  assert(tiles.tile_rotations[1] == 0);
+  assert(tiles.tile_rotations[2] == 1);
+  assert(tiles.tile_rotations[3] == 2);
+  assert(tiles.tile_rotations[4] == 3);
+
+  /* Check original tile 1 sockets
+     "## "
+     "## "
+     "  #"
+  */
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(1, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 0, 1, 0));
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(1, 0, 0, 0));
+  assert(tiles.tile_direction_sockets[(1 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 1, 1, 0));
+
+  /* Check first rotated tile 1 sockets
+     " ##"
+     " ##"
+     "#  "
+   */
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 1, 1, 0));
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(1, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 0, 1, 0));
+  assert(tiles.tile_direction_sockets[(2 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(1, 0, 0, 0));
+
+  /* Check second rotated tile 1 sockets
+     "#  "
+     " ##"
+     " ##"
+   */
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(1, 0, 0, 0));
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(0, 1, 1, 0));
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(1, 1, 0, 0));
+  assert(tiles.tile_direction_sockets[(3 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(0, 0, 1, 0));
+
+  /* Check third rotated tile 1 sockets
+     "  #"
+     "## "
+     "## "
+   */
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 0] == wfc_socket_pack_4(0, 0, 1, 0));
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 1] == wfc_socket_pack_4(1, 0, 0, 0));
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 2] == wfc_socket_pack_4(0, 1, 1, 0));
+  assert(tiles.tile_direction_sockets[(4 * tiles.tile_direction_count) + 3] == wfc_socket_pack_4(1, 1, 0, 0));
+
+  free(tiles_memory);
+}
+
+static void wfc_test_tile_compute_compatible_tiles(void)
+{
+  unsigned char *tiles_memory;
+  unsigned int tiles_memory_size = 0;
+  wfc_socket_8x07 socket_buffer[4];
+
+  wfc_tiles tiles = {0};
+  tiles.tile_capacity = 5;               /* 5 tiles */
+  tiles.tile_direction_count = 4;        /* 4 directions */
+  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
+
+  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
+  tiles_memory = malloc(tiles_memory_size);
+
+  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
+
+  /* Setup tile sockets */
+
+  /* Tile 0 (empty, no rotation required):
+     "   "
+     "   "
+     "   "
+  */
+  socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
+  socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
+  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
+  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
+
+  /* Add tile without additional rotations */
+  wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
+
+  /* Tile 1 (uneven, rotate 3 times for each direction):
+     " # "
+     " ##"
+     " # "
+  */
+  socket_buffer[0] = wfc_socket_pack_4(0, 1, 0, 0); /* Top    */
+  socket_buffer[1] = wfc_socket_pack_4(0, 1, 0, 0); /* Right  */
+  socket_buffer[2] = wfc_socket_pack_4(0, 1, 0, 0); /* Bottom */
+  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
+
+  /* Add tile with three rotations */
+  wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
+
+  assert(tiles.tile_count == 5);
+
+  /* Compute possible adjacent tiles for each direction of each current tile */
+  assert(wfc_tiles_compute_compatible_tiles(&tiles));
+
+  {
+    /* Tile 0. Direction top (0). Two compatible tiles expected:
+     "   "
+     "   "
+     "   "
+    */
+    /* Top */
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 0, 0)); /* Tile is compatible with itself */
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 0, 1));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 0, 2));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 0, 3));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 0, 4));
+
+    /* Right */
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 1, 0)); /* Tile is compatible with itself */
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 1, 1));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 1, 2));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 1, 3));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 1, 4));
+
+    /* Bottom */
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 2, 0)); /* Tile is compatible with itself */
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 2, 1));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 2, 2));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 2, 3));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 2, 4));
+
+    /* Left */
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 3, 0)); /* Tile is compatible with itself */
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 3, 1));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 3, 2));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 0, 3, 3));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 0, 3, 4));
+
+    /* Tile 1. Direction top (0). Three compatible tiles expected:
+       " # "
+       " ##"
+       " # "
+    */
+    /* Top */
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 0, 0));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 0, 1)); /* Tile is compatible with itself */
+    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 0, 2));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 0, 3));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 0, 4));
+
+    /* Right */
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 1, 0));
+    assert(!wfc_tiles_is_compatible_tile(&tiles, 1, 1, 1));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 1, 2));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 1, 3));
+    assert(wfc_tiles_is_compatible_tile(&tiles, 1, 1, 4));
+  }
+
+  free(tiles_memory);
+}
+
+static void wfc_test_simple_tiles(void)
+{
+  unsigned char *tiles_memory;
+  unsigned int tiles_memory_size = 0;
+
+  wfc_tiles tiles = {0};
+  tiles.tile_capacity = 5;               /* 5 tiles */
+  tiles.tile_direction_count = 4;        /* 4 directions */
+  tiles.tile_direction_socket_count = 3; /* 3 values per direction */
+
+  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles.tile_capacity, tiles.tile_direction_count);
+  tiles_memory = malloc(tiles_memory_size);
+
+  assert(wfc_tiles_initialize(&tiles, tiles_memory, tiles_memory_size));
+
+  /* Setup tile sockets */
+  {
+    wfc_socket_8x07 socket_buffer[4];
+
+    /* Tile 0 (empty, no rotation required):
+       "   "
+       "   "
+       "   "
+    */
+    socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0); /* Top    */
+    socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0); /* Right  */
+    socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
+    socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0); /* Left   */
+
+    /* Add tile without additional rotations */
+    wfc_tiles_add_tile(&tiles, 0, socket_buffer, 0);
+
+    /* Tile 1 (cross, rotate 3 times for each direction):
+       " # "
+       "###"
+       "   "
+    */
+    socket_buffer[0] = wfc_socket_pack_4(0, 1, 0, 0); /* Top    */
+    socket_buffer[1] = wfc_socket_pack_4(0, 1, 0, 0); /* Right  */
+    socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0); /* Bottom */
+    socket_buffer[3] = wfc_socket_pack_4(0, 1, 0, 0); /* Left   */
+
+    /* Add tile with three rotations */
+    wfc_tiles_add_tile(&tiles, 1, socket_buffer, 3);
+
+    assert(tiles.tile_count == 5);
+    assert(wfc_tiles_compute_compatible_tiles(&tiles));
+  }
+
+  {
+    unsigned int retries = 0;
+    unsigned char *grid_memory;
+    unsigned int grid_memory_size = 0;
+
+    wfc_grid grid = {0};
+    grid.cols = 128;
+    grid.rows = 128;
+
+    grid_memory_size = WFC_GRID_MEMORY_SIZE(grid.rows, grid.cols, tiles.tile_count);
+
+    printf("[wfc] tiles_memory_size (mb): %10.6f\n", (double)tiles_memory_size / 1024.0 / 1024.0);
+    printf("[wfc]  grid_memory_size (mb): %10.6f\n", (double)grid_memory_size / 1024.0 / 1024.0);
+    printf("[wfc]        total_size (mb): %10.6f\n", ((double)tiles_memory_size / 1024.0 / 1024.0) + ((double)grid_memory_size / 1024.0 / 1024.0));
+
+    grid_memory = malloc(grid_memory_size);
+
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(grid.cell_collapsed[0] == 0);
+    assert(grid.cell_entropy_count[0] == tiles.tile_count);
+    assert(grid.cell_collapsed[grid.rows * grid.cols - 1] == 0);
+    assert(grid.cell_entropy_count[grid.rows * grid.cols - 1] == tiles.tile_count);
+
+    /* Run WFC */
+    wfc_seed_lcg = 1337;
+
+    PERF_PROFILE_WITH_NAME({
+    while (!wfc(&grid, &tiles))
+    {
+      printf("[wfc] retry\n");
+
+      wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size);
+      wfc_seed_lcg += 1;
+      retries++;
+    } }, "wfc_solve_5_tiles_128x128_grid");
+
+    {
+      int idx;
+      int uncollapsed_cells = 0;
+      int unsolvable_cells = 0;
+      int unfinished_cells = 0;
+
+      for (idx = 0; idx < (int)(grid.cols * grid.rows); ++idx)
+      {
+        if (!grid.cell_collapsed[idx])
+        {
+          uncollapsed_cells++;
+        }
+        else if (grid.cell_entropy_count[idx] == 0)
+        {
+          unsolvable_cells++;
+        }
+        else if (grid.cell_entropy_count[idx] > 1)
+        {
+          unfinished_cells++;
+        }
+      }
+
+      assert(uncollapsed_cells == 0);
+      assert(unsolvable_cells == 0);
+      assert(unfinished_cells == 0);
+    }
+
+    printf("[wfc] solved grid after %d retries\n", retries);
+
+    /* Export WFC to PPM */
+    {
+      /* These represent the tiles for visualization purposes */
+      char *tile_0 =
+          "   " /*   */
+          "   " /*   */
+          "   " /*   */;
+
+      char *tile_1 =
+          " # " /*   */
+          "###" /*   */
+          "   " /*   */;
+
+      char *tile_2 =
+          " # " /*   */
+          " ##" /*   */
+          " # " /*   */;
+
+      char *tile_3 =
+          "   " /*   */
+          "###" /*   */
+          " # " /*   */;
+
+      char *tile_4 =
+          " # " /*   */
+          "## " /*   */
+          " # " /*   */;
+
+      char *tile_chars[5];
+      tile_chars[0] = tile_0;
+      tile_chars[1] = tile_1;
+      tile_chars[2] = tile_2;
+      tile_chars[3] = tile_3;
+      tile_chars[4] = tile_4;
+
+      wfc_export_ppm(&grid, &tiles, tile_chars, (int)(sizeof(tile_chars) / sizeof(tile_chars[0])), "wfc.ppm", 2, 1, 0, 3, 3);
+    }
+  }
+
+  free(tiles_memory);
+}
+
+/* Builds the 5 tile set (empty tile + "T" tile with three rotations) used by the solver tests */
+static void wfc_test_setup_simple_tiles(wfc_tiles *tiles, unsigned char **tiles_memory)
+{
+  wfc_socket_8x07 socket_buffer[4];
+  unsigned int tiles_memory_size;
+
+  tiles->tile_capacity = 5;               /* 5 tiles */
+  tiles->tile_direction_count = 4;        /* 4 directions */
+  tiles->tile_direction_socket_count = 3; /* 3 values per direction */
+
+  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles->tile_capacity, tiles->tile_direction_count);
+  *tiles_memory = malloc(tiles_memory_size);
+
+  assert(wfc_tiles_initialize(tiles, *tiles_memory, tiles_memory_size));
+
+  socket_buffer[0] = wfc_socket_pack_4(0, 0, 0, 0);
+  socket_buffer[1] = wfc_socket_pack_4(0, 0, 0, 0);
+  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0);
+  socket_buffer[3] = wfc_socket_pack_4(0, 0, 0, 0);
+  wfc_tiles_add_tile(tiles, 0, socket_buffer, 0);
+
+  socket_buffer[0] = wfc_socket_pack_4(0, 1, 0, 0);
+  socket_buffer[1] = wfc_socket_pack_4(0, 1, 0, 0);
+  socket_buffer[2] = wfc_socket_pack_4(0, 0, 0, 0);
+  socket_buffer[3] = wfc_socket_pack_4(0, 1, 0, 0);
+  wfc_tiles_add_tile(tiles, 1, socket_buffer, 3);
+
+  assert(wfc_tiles_compute_compatible_tiles(tiles));
+}
+
+/* Returns 1 if every cell is collapsed to a single tile that is compatible with its right and bottom neighbour */
+static int wfc_test_grid_is_solved(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int i, d;
+
+  for (i = 0; i < grid->rows * grid->cols; ++i)
+  {
+    unsigned int tile;
+
+    if (!grid->cell_collapsed[i] || grid->cell_entropy_count[i] != 1)
+    {
+      return 0;
+    }
+
+    tile = wfc_grid_find_nth_tile_in_mask(grid, i, 0);
+
+    /* Check every direction against the neighbour derived from the coordinates */
+    for (d = 0; d < tiles->tile_direction_count; ++d)
+    {
+      int neighbour_index = wfc_grid_neighbour_index(grid, (int)i, d, tiles->tile_direction_count);
+
+      if (neighbour_index >= 0 && !wfc_tiles_is_compatible_tile(tiles, tile, d, wfc_grid_find_nth_tile_in_mask(grid, (unsigned int)neighbour_index, 0)))
+      {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* Solves the grid restarting with the next seed on contradictions. Returns the number of retries */
+static unsigned int wfc_test_solve(wfc_grid *grid, wfc_tiles *tiles, unsigned char *grid_memory, unsigned int grid_memory_size, unsigned int seed)
+{
+  unsigned int retries = 0;
+
+  wfc_seed_lcg = seed;
+
+  assert(wfc_grid_initialize(grid, tiles, grid_memory, grid_memory_size));
+
+  while (!wfc(grid, tiles))
+  {
+    wfc_grid_initialize(grid, tiles, grid_memory, grid_memory_size);
+    wfc_seed_lcg = ++seed;
+    retries++;
+  }
+
+  return retries;
+}
+
+/* Solves a size x size grid of the simple tile set and prints the throughput in cells per second */
+static void wfc_test_benchmark_selection(wfc_tiles *tiles, unsigned int selection, unsigned int size, char *name, unsigned int *cell_tiles)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int retries = 0;
+  unsigned int i;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = selection;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ retries = wfc_test_solve(&grid, tiles, grid_memory, grid_memory_size, 1337); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved(&grid, tiles));
+
+  printf("[wfc] %-40s %12.0f cells/sec (%u retries)\n", name, (double)(size * size) / (time_ms / 1000.0), retries);
+
+  if (cell_tiles)
+  {
+    for (i = 0; i < size * size; ++i)
+    {
+      cell_tiles[i] = wfc_grid_find_nth_tile_in_mask(&grid, i, 0);
+    }
+  }
+
+  free(grid_memory);
+}
+
+static void wfc_test_selection_min_heap(void)
+{
+  unsigned char *tiles_memory;
+  unsigned int *linear_scan_tiles;
+  unsigned int *min_heap_tiles;
+  unsigned int i;
+  int identical = 1;
+  wfc_tiles tiles = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+
+  linear_scan_tiles = malloc(sizeof(unsigned int) * 128 * 128);
+  min_heap_tiles = malloc(sizeof(unsigned int) * 128 * 128);
+
+  /* The heap picks cells in exactly the same order as the linear scan */
+  wfc_test_benchmark_selection(&tiles, WFC_SELECTION_LINEAR_SCAN, 128, "wfc_selection_linear_scan_128x128", linear_scan_tiles);
+  wfc_test_benchmark_selection(&tiles, WFC_SELECTION_MIN_HEAP, 128, "wfc_selection_min_heap_128x128", min_heap_tiles);
+
+  for (i = 0; i < 128 * 128; ++i)
+  {
+    identical &= linear_scan_tiles[i] == min_heap_tiles[i];
+  }
+
+  assert(identical);
+
+  wfc_test_benchmark_selection(&tiles, WFC_SELECTION_MIN_HEAP, 512, "wfc_selection_min_heap_512x512", 0);
+  wfc_test_benchmark_selection(&tiles, WFC_SELECTION_MIN_HEAP, 2048, "wfc_selection_min_heap_2048x2048", 0);
+
+  free(linear_scan_tiles);
+  free(min_heap_tiles);
+  free(tiles_memory);
+}
+
+/* Builds tile_count tiles with socket_count random values (0 .. socket_values - 1) per direction and computes their masks */
+static void wfc_test_setup_random_tiles(wfc_tiles *tiles, unsigned char **tiles_memory, unsigned int tile_count, unsigned int direction_count, unsigned int socket_count, unsigned int socket_values, unsigned int seed)
+{
+  wfc_socket_8x07 socket_buffer[8];
+  unsigned int tiles_memory_size;
+  unsigned int i, d, v;
+
+  tiles->tile_capacity = tile_count;
+  tiles->tile_direction_count = direction_count;
+  tiles->tile_direction_socket_count = socket_count;
+
+  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles->tile_capacity, tiles->tile_direction_count);
+  *tiles_memory = malloc(tiles_memory_size);
+
+  assert(wfc_tiles_initialize(tiles, *tiles_memory, tiles_memory_size));
+
+  for (i = 0; i < tile_count; ++i)
+  {
+    for (d = 0; d < direction_count; ++d)
+    {
+      socket_buffer[d] = 0;
+
+      for (v = 0; v < socket_count; ++v)
+      {
+        seed = seed * 1103515245U + 12345U;
+        socket_buffer[d] = wfc_socket_pack(socket_buffer[d], (int)v, (seed >> 16) % socket_values);
+      }
+    }
+
+    assert(wfc_tiles_add_tile(tiles, i, socket_buffer, 0));
+  }
+
+  assert(wfc_tiles_compute_compatible_tiles(tiles));
+}
+
+/* Solves `solves` grids with consecutive seeds and prints the average retries and time per solved grid */
+static void wfc_test_benchmark_propagation(wfc_tiles *tiles, unsigned int propagation, unsigned int size, unsigned int solves, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int retries = 0;
+  unsigned int solved = 0;
+  unsigned int seed = 1;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = propagation;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+
+  /* Give up after 100 attempts per grid so hopeless rule sets still terminate */
+  while (solved < solves && retries < solves * 100)
+  {
+    wfc_seed_lcg = seed++;
+    wfc_grid_initialize(&grid, tiles, grid_memory, grid_memory_size);
+
+    if (wfc(&grid, tiles))
+    {
+      assert(wfc_test_grid_is_solved(&grid, tiles));
+      solved++;
+    }
+    else
+    {
+      retries++;
+    }
+  }
+
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  printf("[wfc] %-44s %4u/%u solved, %8.2f retries/grid, %10.3f ms/grid\n", name, solved, solves,
+         solved ? (double)retries / (double)solved : (double)retries, solved ? time_ms / (double)solved : time_ms);
+
+  free(grid_memory);
+}
+
+static void wfc_test_propagation_worklist(void)
+{
+  unsigned char *tiles_memory;
+  wfc_tiles tiles = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+  wfc_test_benchmark_propagation(&tiles, WFC_PROPAGATION_NEIGHBOURS, 128, 10, "wfc_neighbours_5_tiles_128x128");
+  wfc_test_benchmark_propagation(&tiles, WFC_PROPAGATION_WORKLIST, 128, 10, "wfc_worklist_5_tiles_128x128");
+  free(tiles_memory);
+
+  {
+    wfc_tiles random_tiles = {0};
+
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, 24, 4, 1, 3, 42);
+    wfc_test_benchmark_propagation(&random_tiles, WFC_PROPAGATION_NEIGHBOURS, 32, 10, "wfc_neighbours_24_random_tiles_32x32");
+    wfc_test_benchmark_propagation(&random_tiles, WFC_PROPAGATION_WORKLIST, 32, 10, "wfc_worklist_24_random_tiles_32x32");
+    free(tiles_memory);
+  }
+
+  {
+    wfc_tiles random_tiles = {0};
+
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, 128, 4, 1, 6, 42);
+    wfc_test_benchmark_propagation(&random_tiles, WFC_PROPAGATION_NEIGHBOURS, 32, 10, "wfc_neighbours_128_random_tiles_32x32");
+    wfc_test_benchmark_propagation(&random_tiles, WFC_PROPAGATION_WORKLIST, 32, 10, "wfc_worklist_128_random_tiles_32x32");
+    free(tiles_memory);
+  }
+
+  /* A tile that nothing fits right of is a contradiction as soon as a cell is left with it (two mask words) */
+  {
+    wfc_tiles dead_end_tiles = {0};
+    wfc_grid grid = {0};
+    wfc_socket_8x07 socket_buffer[4] = {0};
+    unsigned int tiles_memory_size;
+    unsigned char *grid_memory;
+    unsigned int grid_memory_size;
+    unsigned int i;
+
+    dead_end_tiles.tile_capacity = 40;
+    dead_end_tiles.tile_direction_count = 4;
+    dead_end_tiles.tile_direction_socket_count = 1;
+    tiles_memory_size = WFC_TILES_MEMORY_SIZE(dead_end_tiles.tile_capacity, dead_end_tiles.tile_direction_count);
+    tiles_memory = malloc(tiles_memory_size);
+    assert(wfc_tiles_initialize(&dead_end_tiles, tiles_memory, tiles_memory_size));
+
+    for (i = 0; i < 40; ++i)
+    {
+      socket_buffer[1] = wfc_socket_pack(0, 0, i == 39 ? 1u : 0u);
+      assert(wfc_tiles_add_tile(&dead_end_tiles, i, socket_buffer, 0));
+    }
+
+    assert(wfc_tiles_compute_compatible_tiles(&dead_end_tiles));
+    assert(wfc_mask_is_empty(&dead_end_tiles.tile_direction_compatible_masks[(39 * 4 + 1) * 2], 2));
+
+    grid.cols = 4;
+    grid.rows = 4;
+    grid.propagation = WFC_PROPAGATION_WORKLIST;
+    grid_memory_size = wfc_grid_memory_size(&grid, &dead_end_tiles);
+    grid_memory = malloc(grid_memory_size);
+
+    assert(wfc_grid_initialize(&grid, &dead_end_tiles, grid_memory, grid_memory_size));
+    assert(wfc_grid_pin_tile(&grid, 5, 39) == 1);
+    assert(!wfc_grid_propagate_constraints(&grid, &dead_end_tiles));
+
+    /* On the right edge there is no neighbour to contradict */
+    assert(wfc_grid_initialize(&grid, &dead_end_tiles, grid_memory, grid_memory_size));
+    assert(wfc_grid_pin_tile(&grid, 7, 39) == 1);
+    assert(wfc_grid_propagate_constraints(&grid, &dead_end_tiles));
+
+    free(grid_memory);
+    free(tiles_memory);
+  }
+}
+
+static void wfc_test_propagation_support(void)
+{
+  unsigned char *tiles_memory;
+  wfc_tiles tiles = {0};
+
+  /* Worklist and support counters reach the same fixpoint, so the same seed yields the same grid */
+  {
+    wfc_tiles random_tiles = {0};
+    wfc_grid grid_worklist = {0};
+    wfc_grid grid_support = {0};
+    unsigned char *grid_worklist_memory;
+    unsigned char *grid_support_memory;
+    unsigned int grid_worklist_memory_size;
+    unsigned int grid_support_memory_size;
+    unsigned int i;
+    int identical = 1;
+
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, 24, 4, 1, 3, 42);
+
+    grid_worklist.cols = grid_support.cols = 32;
+    grid_worklist.rows = grid_support.rows = 32;
+    grid_worklist.selection = grid_support.selection = WFC_SELECTION_MIN_HEAP;
+    grid_worklist.propagation = WFC_PROPAGATION_WORKLIST;
+    grid_support.propagation = WFC_PROPAGATION_SUPPORT;
+
+    grid_worklist_memory_size = wfc_grid_memory_size(&grid_worklist, &random_tiles);
+    grid_support_memory_size = wfc_grid_memory_size(&grid_support, &random_tiles);
+    assert(grid_support_memory_size == WFC_GRID_MEMORY_SIZE(32, 32, 24) + WFC_GRID_HEAP_MEMORY_SIZE(32, 32) + WFC_GRID_SUPPORT_MEMORY_SIZE(32, 32, 24, 4));
+
+    grid_worklist_memory = malloc(grid_worklist_memory_size);
+    grid_support_memory = malloc(grid_support_memory_size);
+
+    assert(wfc_test_solve(&grid_worklist, &random_tiles, grid_worklist_memory, grid_worklist_memory_size, 7) ==
+           wfc_test_solve(&grid_support, &random_tiles, grid_support_memory, grid_support_memory_size, 7));
+    assert(wfc_test_grid_is_solved(&grid_support, &random_tiles));
+
+    for (i = 0; i < 32 * 32; ++i)
+    {
+      identical &= grid_worklist.cell_entropy_masks[i] == grid_support.cell_entropy_masks[i];
+    }
+
+    assert(identical);
+
+    free(grid_worklist_memory);
+    free(grid_support_memory);
+    free(tiles_memory);
+  }
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+  wfc_test_benchmark_propagation(&tiles, WFC_PROPAGATION_SUPPORT, 128, 10, "wfc_support_5_tiles_128x128");
+  free(tiles_memory);
+
+  {
+    wfc_tiles random_tiles = {0};
+
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, 24, 4, 1, 3, 42);
+    wfc_test_benchmark_propagation(&random_tiles, WFC_PROPAGATION_SUPPORT, 32, 10, "wfc_support_24_random_tiles_32x32");
+    free(tiles_memory);
+  }
+
+  {
+    wfc_tiles random_tiles = {0};
+
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, 240, 4, 1, 8, 42);
+    wfc_test_benchmark_propagation(&random_tiles, WFC_PROPAGATION_WORKLIST, 32, 10, "wfc_worklist_240_random_tiles_32x32");
+    wfc_test_benchmark_propagation(&random_tiles, WFC_PROPAGATION_SUPPORT, 32, 10, "wfc_support_240_random_tiles_32x32");
+    free(tiles_memory);
+  }
+}
+
+static void wfc_test_benchmark_backtracking(wfc_tiles *tiles, unsigned int propagation, unsigned int trail_capacity, unsigned int size, unsigned int solves, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int restarts = 0;
+  unsigned int backtracks = 0;
+  unsigned int trail_high_water = 0;
+  unsigned int solved = 0;
+  unsigned int seed = 1;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = propagation;
+  grid.trail_capacity = trail_capacity;
+  grid.backtrack_budget = 1000;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+
+  while (solved < solves && restarts < solves * 100)
+  {
+    wfc_seed_lcg = seed++;
+    wfc_grid_initialize(&grid, tiles, grid_memory, grid_memory_size);
+
+    if (wfc(&grid, tiles))
+    {
+      assert(wfc_test_grid_is_solved(&grid, tiles));
+      solved++;
+    }
+    else
+    {
+      restarts++;
+    }
+
+    backtracks += grid.backtracks;
+
+    if (grid.trail_high_water > trail_high_water)
+    {
+      trail_high_water = grid.trail_high_water;
+    }
+  }
+
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  printf("[wfc] %-44s %4u/%u solved, %8.2f restarts/grid, %8.2f backtracks/grid, trail %7u, %10.3f ms/grid\n", name, solved, solves,
+         solved ? (double)restarts / (double)solved : (double)restarts, solved ? (double)backtracks / (double)solved : (double)backtracks,
+         trail_high_water, solved ? time_ms / (double)solved : time_ms);
+
+  free(grid_memory);
+}
+
+static void wfc_test_backtracking(void)
+{
+  unsigned char *tiles_memory;
+  wfc_tiles tiles = {0};
+
+  wfc_test_setup_random_tiles(&tiles, &tiles_memory, 32, 4, 1, 4, 42);
+
+  /* The undo trail restores the exact masks and support counters, so both engines take the same decisions */
+  {
+    wfc_grid grid_worklist = {0};
+    wfc_grid grid_support = {0};
+    unsigned char *grid_worklist_memory;
+    unsigned char *grid_support_memory;
+    unsigned int grid_worklist_memory_size;
+    unsigned int grid_support_memory_size;
+    unsigned int i;
+    int identical = 1;
+
+    grid_worklist.cols = grid_support.cols = 32;
+    grid_worklist.rows = grid_support.rows = 32;
+    grid_worklist.selection = grid_support.selection = WFC_SELECTION_MIN_HEAP;
+    grid_worklist.trail_capacity = grid_support.trail_capacity = 1u << 16;
+    grid_worklist.propagation = WFC_PROPAGATION_WORKLIST;
+    grid_support.propagation = WFC_PROPAGATION_SUPPORT;
+
+    grid_worklist_memory_size = wfc_grid_memory_size(&grid_worklist, &tiles);
+    grid_support_memory_size = wfc_grid_memory_size(&grid_support, &tiles);
+    assert(grid_worklist_memory_size == WFC_GRID_MEMORY_SIZE(32, 32, 32) + WFC_GRID_HEAP_MEMORY_SIZE(32, 32) + WFC_GRID_WORKLIST_MEMORY_SIZE(32, 32, 32) + WFC_GRID_TRAIL_MEMORY_SIZE(32, 32, 1u << 16));
+
+    grid_worklist_memory = malloc(grid_worklist_memory_size);
+    grid_support_memory = malloc(grid_support_memory_size);
+
+    /* Without the trail this rule set needs hundreds of restarts for a single 32x32 grid */
+    assert(wfc_test_solve(&grid_worklist, &tiles, grid_worklist_memory, grid_worklist_memory_size, 3) == 0);
+    assert(wfc_test_solve(&grid_support, &tiles, grid_support_memory, grid_support_memory_size, 3) == 0);
+    assert(wfc_test_grid_is_solved(&grid_worklist, &tiles));
+    assert(wfc_test_grid_is_solved(&grid_support, &tiles));
+    assert(grid_worklist.backtracks > 0);
+    assert(grid_worklist.backtracks == grid_support.backtracks);
+    assert(grid_worklist.decisions == grid_support.decisions);
+    assert(grid_worklist.trail_high_water > 0 && grid_worklist.trail_high_water <= grid_worklist.trail_capacity);
+
+    for (i = 0; i < 32 * 32; ++i)
+    {
+      identical &= grid_worklist.cell_entropy_masks[i] == grid_support.cell_entropy_masks[i];
+    }
+
+    assert(identical);
+
+    /* A spent budget falls back to the caller's restart */
+    wfc_seed_lcg = 3;
+    grid_worklist.backtrack_budget = 1;
+    assert(wfc_grid_initialize(&grid_worklist, &tiles, grid_worklist_memory, grid_worklist_memory_size));
+    assert(!wfc(&grid_worklist, &tiles));
+    assert(grid_worklist.backtracks == 1);
+
+    free(grid_worklist_memory);
+    free(grid_support_memory);
+  }
+
+  /* A trail that is too small gives up instead of writing past the buffer */
+  {
+    wfc_grid grid = {0};
+    unsigned char *grid_memory;
+    unsigned int grid_memory_size;
+
+    grid.cols = 32;
+    grid.rows = 32;
+    grid.selection = WFC_SELECTION_MIN_HEAP;
+    grid.propagation = WFC_PROPAGATION_WORKLIST;
+    grid.trail_capacity = 16;
+
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    grid_memory = malloc(grid_memory_size);
+
+    wfc_seed_lcg = 3;
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(!wfc(&grid, &tiles));
+    assert(grid.trail_overflow == 1);
+    assert(grid.trail_high_water == 16);
+
+    free(grid_memory);
+  }
+
+  wfc_test_benchmark_backtracking(&tiles, WFC_PROPAGATION_WORKLIST, 0, 32, 10, "wfc_restart_32_random_tiles_32x32");
+  wfc_test_benchmark_backtracking(&tiles, WFC_PROPAGATION_WORKLIST, 1u << 20, 32, 10, "wfc_backtrack_32_random_tiles_32x32");
+  wfc_test_benchmark_backtracking(&tiles, WFC_PROPAGATION_WORKLIST, 0, 64, 10, "wfc_restart_32_random_tiles_64x64");
+  wfc_test_benchmark_backtracking(&tiles, WFC_PROPAGATION_WORKLIST, 1u << 20, 64, 10, "wfc_backtrack_32_random_tiles_64x64");
+  wfc_test_benchmark_backtracking(&tiles, WFC_PROPAGATION_SUPPORT, 1u << 20, 64, 10, "wfc_backtrack_support_32_random_tiles_64x64");
+  free(tiles_memory);
+}
+
+/* Runs expr for every test word (w, n set per word) and prints the average cycles per call */
+#define WFC_TEST_BENCHMARK_BIT_OP(expr, name)                                                          \
+  do                                                                                                   \
+  {                                                                                                    \
+    unsigned long cycles_start = perf_platform_current_cycle_count();                                  \
+    PERF_PROFILE_WITH_NAME({                                                                           \
+      for (round = 0; round < rounds; ++round)                                                         \
+      {                                                                                                \
+        for (i = 0; i < word_count; ++i)                                                               \
+        {                                                                                              \
+          unsigned int w = words[i];                                                                   \
+          unsigned int n = select_indices[i];                                                          \
+          (void)n;                                                                                     \
+          sink += (expr);                                                                              \
+        }                                                                                              \
+      } }, name);                                                                                      \
+    printf("[wfc] %-44s %6.2f cycles/call\n", name,                                                   \
+           (double)(perf_platform_current_cycle_count() - cycles_start) / (double)(rounds * word_count)); \
+  } while (0)
+
+/* Builds without -mpopcnt / -mbmi2 (like CI and build.bat) compile wfc_popcount() and wfc_select_bit() to the portable
+   code, so timing them would compare the portable code with itself. On x86 GCC/clang the instructions are timed in
+   loops compiled for them instead, which only run if the CPU has them */
+#if !defined(WFC_NO_INTRINSICS) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define WFC_TEST_HARDWARE_BITS
+#endif
+
+#if defined(WFC_TEST_HARDWARE_BITS) && (!defined(WFC_INTRINSIC_POPCOUNT) || !defined(WFC_INTRINSIC_PDEP))
+/* Runs loop, which goes over all test words rounds times itself, and prints the average cycles per call */
+#define WFC_TEST_BENCHMARK_BIT_LOOP(loop, name)                                                       \
+  do                                                                                                   \
+  {                                                                                                    \
+    unsigned long cycles_start = perf_platform_current_cycle_count();                                  \
+    PERF_PROFILE_WITH_NAME({ sink += (loop); }, name);                                                 \
+    printf("[wfc] %-44s %6.2f cycles/call\n", name,                                                   \
+           (double)(perf_platform_current_cycle_count() - cycles_start) / (double)(rounds * word_count)); \
+  } while (0)
+#endif
+
+#if defined(WFC_TEST_HARDWARE_BITS) && !defined(WFC_INTRINSIC_POPCOUNT)
+__attribute__((target("popcnt"))) static unsigned int wfc_test_popcount_hardware(unsigned int *words, unsigned int word_count, unsigned int rounds)
+{
+  unsigned int sum = 0;
+  unsigned int round, i;
+
+  for (round = 0; round < rounds; ++round)
+  {
+    for (i = 0; i < word_count; ++i)
+    {
+      sum += (unsigned int)__builtin_popcount(words[i]);
+    }
+  }
+
+  return sum;
+}
+#endif
+
+#if defined(WFC_TEST_HARDWARE_BITS) && !defined(WFC_INTRINSIC_PDEP)
+__attribute__((target("bmi2"))) static unsigned int wfc_test_select_bit_hardware(unsigned int *words, unsigned int *select_indices, unsigned int word_count, unsigned int rounds)
+{
+  unsigned int sum = 0;
+  unsigned int round, i;
+
+  for (round = 0; round < rounds; ++round)
+  {
+    for (i = 0; i < word_count; ++i)
+    {
+      sum += (unsigned int)__builtin_ctz(__builtin_ia32_pdep_si(1u << select_indices[i], words[i]));
+    }
+  }
+
+  return sum;
+}
+#endif
+
+static void wfc_test_bit_intrinsics(void)
+{
+  unsigned int word_count = 4096;
+  unsigned int rounds = 256;
+  unsigned int seed = 42;
+  unsigned int *words = malloc(sizeof(unsigned int) * word_count);
+  unsigned int *select_indices = malloc(sizeof(unsigned int) * word_count);
+  volatile unsigned int sink = 0;
+  unsigned int round, i, n;
+  int identical = 1;
+
+  for (i = 0; i < word_count; ++i)
+  {
+    seed = seed * 1103515245U + 12345U;
+    words[i] = (seed >> 8) | 1u | (i << 31); /* never 0 */
+    select_indices[i] = (seed >> 3) % wfc_popcount_portable(words[i]);
+  }
+
+  /* The intrinsic paths must match the portable C89 code bit for bit */
+  for (i = 0; i < word_count; ++i)
+  {
+    identical &= wfc_popcount(words[i]) == wfc_popcount_portable(words[i]);
+    identical &= wfc_bit_scan_forward(words[i]) == wfc_bit_scan_forward_portable(words[i]);
+
+    for (n = 0; n < wfc_popcount_portable(words[i]); ++n)
+    {
+      identical &= wfc_select_bit(words[i], n) == wfc_select_bit_portable(words[i], n);
+    }
+  }
+
+  assert(identical);
+  assert(wfc_popcount(0xFFFFFFFF) == 32);
+  assert(wfc_bit_scan_forward(0x80000000) == 31);
+  assert(wfc_select_bit(0x80000001, 1) == 31);
+
+  WFC_TEST_BENCHMARK_BIT_OP(wfc_popcount_portable(w), "wfc_popcount_portable");
+#if defined(WFC_INTRINSIC_POPCOUNT)
+  WFC_TEST_BENCHMARK_BIT_OP(wfc_popcount(w), "wfc_popcount");
+#elif defined(WFC_TEST_HARDWARE_BITS)
+  if (__builtin_cpu_supports("popcnt"))
+  {
+    for (i = 0; i < word_count; ++i)
+    {
+      identical &= wfc_test_popcount_hardware(&words[i], 1, 1) == wfc_popcount_portable(words[i]);
+    }
+
+    assert(identical);
+    WFC_TEST_BENCHMARK_BIT_LOOP(wfc_test_popcount_hardware(words, word_count, rounds), "wfc_popcount_popcnt (not in this build)");
+  }
+  else
+  {
+    printf("[wfc] %-44s disabled, the CPU has no popcnt\n", "wfc_popcount");
+  }
+#else
+  printf("[wfc] %-44s disabled in this build, wfc_popcount() is the portable code\n", "wfc_popcount");
+#endif
+  WFC_TEST_BENCHMARK_BIT_OP(wfc_bit_scan_forward_portable(w), "wfc_bit_scan_forward_portable");
+  WFC_TEST_BENCHMARK_BIT_OP(wfc_bit_scan_forward(w), "wfc_bit_scan_forward");
+  WFC_TEST_BENCHMARK_BIT_OP(wfc_select_bit_portable(w, n), "wfc_select_bit_portable");
+#if defined(WFC_INTRINSIC_PDEP)
+  WFC_TEST_BENCHMARK_BIT_OP(wfc_select_bit(w, n), "wfc_select_bit");
+#elif defined(WFC_TEST_HARDWARE_BITS)
+  if (__builtin_cpu_supports("bmi2"))
+  {
+    for (i = 0; i < word_count; ++i)
+    {
+      identical &= wfc_test_select_bit_hardware(&words[i], &select_indices[i], 1, 1) == wfc_select_bit_portable(words[i], select_indices[i]);
+    }
+
+    assert(identical);
+    WFC_TEST_BENCHMARK_BIT_LOOP(wfc_test_select_bit_hardware(words, select_indices, word_count, rounds), "wfc_select_bit_pdep (not in this build)");
+  }
+  else
+  {
+    printf("[wfc] %-44s disabled, the CPU has no bmi2\n", "wfc_select_bit");
+  }
+#else
+  printf("[wfc] %-44s disabled in this build, wfc_select_bit() is the portable code\n", "wfc_select_bit");
+#endif
+
+  (void)sink;
+
+  free(words);
+  free(select_indices);
+}
+
+/* Prints the cycles per call of the portable and the SIMD mask kernels for masks of tile_count tiles */
+static void wfc_test_benchmark_mask_kernels(unsigned int tile_count)
+{
+  unsigned int mask_words = (tile_count + 31) / 32;
+  unsigned int mask_count = 64;
+  unsigned int rounds = 262144 / mask_words;
+  unsigned int *dst = malloc(sizeof(unsigned int) * mask_words * mask_count);
+  unsigned int *src = malloc(sizeof(unsigned int) * mask_words * mask_count);
+  volatile unsigned int sink = 0;
+  unsigned long cycles[6];
+  unsigned long cycles_start;
+  unsigned int seed = tile_count;
+  unsigned int round, i, kernel, run;
+  char name[64];
+
+  for (i = 0; i < mask_words * mask_count; ++i)
+  {
+    seed = seed * 1103515245U + 12345U;
+    dst[i] = seed;
+    seed = seed * 1103515245U + 12345U;
+    src[i] = seed | (seed << 7); /* mostly ones, so dst does not run empty */
+  }
+
+  /* Best of 5 runs per kernel to filter out scheduling noise */
+  for (kernel = 0; kernel < 6 * 5; ++kernel)
+  {
+    run = kernel / 6;
+    cycles_start = perf_platform_current_cycle_count();
+
+    for (round = 0; round < rounds; ++round)
+    {
+      for (i = 0; i < mask_count; ++i)
+      {
+        unsigned int *d = &dst[i * mask_words];
+        unsigned int *s = &src[i * mask_words];
+
+        switch (kernel % 6)
+        {
+        case 0:
+          sink += wfc_mask_and_count_portable(d, s, mask_words);
+          break;
+        case 1:
+          sink += wfc_mask_and_count(d, s, mask_words);
+          break;
+        case 2:
+          sink += (unsigned int)wfc_mask_is_empty_portable(d, mask_words);
+          break;
+        case 3:
+          sink += (unsigned int)wfc_mask_is_empty(d, mask_words);
+          break;
+        case 4:
+          wfc_mask_or_portable(d, s, mask_words);
+          break;
+        default:
+          wfc_mask_or(d, s, mask_words);
+          break;
+        }
+      }
+    }
+
+    cycles_start = perf_platform_current_cycle_count() - cycles_start;
+
+    if (run == 0 || cycles_start < cycles[kernel % 6])
+    {
+      cycles[kernel % 6] = cycles_start;
+    }
+  }
+
+  for (kernel = 0; kernel < 6; kernel += 2)
+  {
+    sprintf(name, "%s_%u_tiles", kernel == 0 ? "wfc_mask_and_count" : (kernel == 2 ? "wfc_mask_is_empty" : "wfc_mask_or"), tile_count);
+    printf("[wfc] %-44s %8.2f -> %8.2f cycles/call (%.2fx)\n", name,
+           (double)cycles[kernel] / (double)(rounds * mask_count), (double)cycles[kernel + 1] / (double)(rounds * mask_count),
+           (double)cycles[kernel] / (double)cycles[kernel + 1]);
+  }
+
+  (void)sink;
+
+  free(dst);
+  free(src);
+}
+
+static void wfc_test_mask_kernels(void)
+{
+  unsigned int dst_simd[130];
+  unsigned int dst_portable[130];
+  unsigned int src[130];
+  unsigned int seed = 7;
+  unsigned int words, i;
+  int identical = 1;
+
+  /* Every length up to 130 words covers full vectors and all scalar tails */
+  for (words = 0; words <= 130; ++words)
+  {
+    for (i = 0; i < words; ++i)
+    {
+      seed = seed * 1103515245U + 12345U;
+      dst_simd[i] = dst_portable[i] = seed;
+      seed = seed * 1103515245U + 12345U;
+      src[i] = seed;
+    }
+
+    identical &= wfc_mask_and_count(dst_simd, src, words) == wfc_mask_and_count_portable(dst_portable, src, words);
+    identical &= wfc_mask_is_empty(dst_simd, words) == wfc_mask_is_empty_portable(dst_portable, words);
+
+    wfc_mask_or(dst_simd, src, words);
+    wfc_mask_or_portable(dst_portable, src, words);
+
+    for (i = 0; i < words; ++i)
+    {
+      identical &= dst_simd[i] == dst_portable[i];
+      dst_simd[i] = dst_portable[i] = 0;
+    }
+
+    identical &= wfc_mask_is_empty(dst_simd, words) == 1;
+
+    if (words > 0)
+    {
+      dst_simd[words - 1] = 1;
+      identical &= wfc_mask_is_empty(dst_simd, words) == 0;
+    }
+  }
+
+  assert(identical);
+
+  wfc_test_benchmark_mask_kernels(64);
+  wfc_test_benchmark_mask_kernels(256);
+  wfc_test_benchmark_mask_kernels(1024);
+  wfc_test_benchmark_mask_kernels(4096);
+}
+
+/* FNV-1a hash over the collapsed tile of every cell */
+static unsigned int wfc_test_grid_hash(wfc_grid *grid)
+{
+  unsigned int hash = 2166136261U;
+  unsigned int i;
+
+  for (i = 0; i < grid->rows * grid->cols; ++i)
+  {
+    hash = (hash ^ wfc_grid_find_nth_tile_in_mask(grid, i, 0)) * 16777619U;
+  }
+
+  return hash;
+}
+
+/* Solves the 5 tile set with the given propagation, prints ms/grid and returns the grid hash */
+static unsigned int wfc_test_benchmark_single_word(wfc_tiles *tiles, unsigned int propagation, unsigned int size, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int retries;
+  unsigned int hash;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = propagation;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ retries = wfc_test_solve(&grid, tiles, grid_memory, grid_memory_size, 1337); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved(&grid, tiles));
+  hash = wfc_test_grid_hash(&grid);
+
+  printf("[wfc] %-44s %10.3f ms/grid (%u retries, hash %08x)\n", name, time_ms, retries, hash);
+
+  free(grid_memory);
+
+  return hash;
+}
+
+static void wfc_test_single_word(void)
+{
+  unsigned char *tiles_memory;
+  wfc_tiles tiles = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+
+  /* 5 tiles fit one mask word. The hashes were recorded with the generic multi word path (WFC_NO_SINGLE_WORD) */
+  assert(wfc_test_benchmark_single_word(&tiles, WFC_PROPAGATION_NEIGHBOURS, 512, "wfc_single_word_neighbours_5_tiles_512x512") == 0x652c7b8b);
+  assert(wfc_test_benchmark_single_word(&tiles, WFC_PROPAGATION_WORKLIST, 512, "wfc_single_word_worklist_5_tiles_512x512") == 0x652c7b8b);
+  assert(wfc_test_benchmark_single_word(&tiles, WFC_PROPAGATION_SUPPORT, 512, "wfc_single_word_support_5_tiles_512x512") == 0x652c7b8b);
+
+  free(tiles_memory);
+}
+
+/* Solves a size x size grid of tile_count random tiles (more than an unsigned char can count) */
+static void wfc_test_benchmark_many_tiles(unsigned int tile_count, unsigned int propagation, unsigned int size, char *name)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int retries;
+  double time_start;
+  double time_ms;
+
+  wfc_tiles tiles = {0};
+  wfc_grid grid = {0};
+
+  wfc_test_setup_random_tiles(&tiles, &tiles_memory, tile_count, 4, 1, 8, 42);
+
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = propagation;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+  assert(grid.cell_entropy_count[0] == tile_count);
+  assert(grid.cell_entropy_count[size * size - 1] == tile_count);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ retries = wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 1); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved(&grid, &tiles));
+
+  printf("[wfc] %-44s %10.3f ms (%u retries, %.2f mb grid memory)\n", name, time_ms, retries, (double)grid_memory_size / 1024.0 / 1024.0);
+
+  free(grid_memory);
+  free(tiles_memory);
+}
+
+static void wfc_test_many_tiles(void)
+{
+  assert(WFC_GRID_MEMORY_SIZE(16, 16, 2000) == 16 * 16 * (sizeof(unsigned char) + sizeof(wfc_count) + sizeof(unsigned int) * 63) + sizeof(unsigned char));
+
+  /* A count of 256 tiles used to wrap to 0 */
+  wfc_test_benchmark_many_tiles(256, WFC_PROPAGATION_NEIGHBOURS, 16, "wfc_neighbours_256_random_tiles_16x16");
+  wfc_test_benchmark_many_tiles(300, WFC_PROPAGATION_WORKLIST, 32, "wfc_worklist_300_random_tiles_32x32");
+  wfc_test_benchmark_many_tiles(300, WFC_PROPAGATION_SUPPORT, 32, "wfc_support_300_random_tiles_32x32");
+  wfc_test_benchmark_many_tiles(2000, WFC_PROPAGATION_WORKLIST, 32, "wfc_worklist_2000_random_tiles_32x32");
+}
+
+/* Solves a size x size grid with AC-3 propagation and the given neighbour lookup, prints the throughput and returns the grid hash */
+static unsigned int wfc_test_benchmark_neighbours(wfc_tiles *tiles, unsigned int size, unsigned int neighbours, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int retries;
+  unsigned int hash;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = WFC_PROPAGATION_WORKLIST;
+  grid.neighbours = neighbours;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ retries = wfc_test_solve(&grid, tiles, grid_memory, grid_memory_size, 1337); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved(&grid, tiles));
+  hash = wfc_test_grid_hash(&grid);
+
+  printf("[wfc] %-44s %12.0f cells/sec (%u retries)\n", name, (double)(size * size * (retries + 1)) / (time_ms / 1000.0), retries);
+
+  free(grid_memory);
+
+  return hash;
+}
+
+/* Removes tile 0 from every cell of a size x size grid and times the neighbours propagation sweep alone,
+   which is bound by the neighbour lookups. Prints the throughput and returns the sum of the entropy counts */
+static unsigned int wfc_test_benchmark_neighbours_sweep(wfc_tiles *tiles, unsigned int size, unsigned int neighbours, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int entropy_sum = 0;
+  unsigned int i;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.neighbours = neighbours;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+  assert(wfc_grid_initialize(&grid, tiles, grid_memory, grid_memory_size));
+
+  for (i = 0; i < size * size; ++i)
+  {
+    grid.cell_entropy_masks[i * grid.cell_entropy_mask_words] &= ~1u;
+    grid.cell_entropy_count[i]--;
+  }
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ assert(wfc_grid_propagate_constraints(&grid, tiles)); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  for (i = 0; i < size * size; ++i)
+  {
+    entropy_sum += grid.cell_entropy_count[i];
+  }
+
+  printf("[wfc] %-44s %12.0f cells/sec\n", name, (double)(size * size) / (time_ms / 1000.0));
+
+  free(grid_memory);
+
+  return entropy_sum;
+}
+
+static void wfc_test_neighbours(void)
+{
+  unsigned char *tiles_memory;
+  wfc_tiles simple_tiles = {0};
+  wfc_tiles diagonal_tiles = {0};
+  wfc_tiles sweep_tiles = {0};
+  unsigned int dir_count;
+  unsigned int d, n;
+
+  /* The multiply-shift division matches the divide instruction */
+  for (d = 1; d < 5000; d += d < 70 ? 1 : 37)
+  {
+    wfc_divisor divisor;
+    int identical = 1;
+
+    wfc_divisor_initialize(&divisor, d);
+
+    for (n = 0; n < 100000; n += 7)
+    {
+      identical &= wfc_divide(&divisor, n) == n / d;
+    }
+
+    identical &= wfc_divide(&divisor, 0xFFFFFFFFu) == 0xFFFFFFFFu / d;
+    identical &= wfc_divide(&divisor, 0x80000000u) == 0x80000000u / d;
+    assert(identical);
+  }
+
+  /* Every direction leads to the cell the coordinates step to, for 4 and 8 directions */
+  for (dir_count = 4; dir_count <= 8; dir_count += 4)
+  {
+    wfc_tiles tiles = {0};
+    wfc_grid grid = {0};
+    unsigned char *grid_memory;
+    unsigned int grid_memory_size;
+    unsigned int i;
+    int identical = 1;
+
+    wfc_test_setup_random_tiles(&tiles, &tiles_memory, 8, dir_count, 1, 2, 42);
+
+    grid.cols = 37;
+    grid.rows = 23;
+
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    assert(grid_memory_size == WFC_GRID_MEMORY_SIZE(23, 37, 8));
+    grid_memory = malloc(grid_memory_size);
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+    for (i = 0; i < 37 * 23; ++i)
+    {
+      for (d = 0; d < dir_count; ++d)
+      {
+        int x = (int)(i % 37) + wfc_direction_dx[dir_count == 8 ? d : d * 2];
+        int y = (int)(i / 37) + wfc_direction_dy[dir_count == 8 ? d : d * 2];
+
+        identical &= wfc_grid_neighbour_index(&grid, (int)i, d, dir_count) == ((x < 0 || y < 0 || x >= 37 || y >= 23) ? -1 : wfc_grid_index_at(x, y, 37));
+      }
+    }
+
+    assert(identical);
+    assert(wfc_grid_neighbour_index(&grid, 0, 0, dir_count) == -1);
+    assert(wfc_grid_neighbour_index(&grid, wfc_grid_index_at(1, 1, 37), 1, dir_count) == wfc_grid_index_at(2, dir_count == 8 ? 0 : 1, 37));
+    assert(wfc_grid_neighbour_index(&grid, wfc_grid_index_at(36, 22, 37), dir_count / 2, dir_count) == -1);
+    free(grid_memory);
+
+    /* The table holds the same neighbours, the sentinel cell in place of -1 */
+    grid.neighbours = WFC_NEIGHBOURS_TABLE;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    assert(grid_memory_size == WFC_GRID_MEMORY_SIZE(23, 37, 8) + WFC_GRID_NEIGHBOUR_MEMORY_SIZE(23, 37, dir_count));
+    grid_memory = malloc(grid_memory_size);
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(grid.cell_collapsed[37 * 23]);
+
+    for (i = 0; i < 37 * 23; ++i)
+    {
+      unsigned int buffer[WFC_GRID_DIRECTIONS_MAX];
+      unsigned int *neighbours = wfc_grid_cell_neighbours(&grid, i, dir_count, buffer);
+
+      for (d = 0; d < dir_count; ++d)
+      {
+        int neighbour_index = wfc_grid_neighbour_index(&grid, (int)i, d, dir_count);
+
+        identical &= neighbours[d] == (neighbour_index < 0 ? 37u * 23u : (unsigned int)neighbour_index);
+      }
+    }
+
+    assert(identical);
+
+    free(grid_memory);
+    free(tiles_memory);
+  }
+
+  /* 4 directions: the 5 tile set gives the same grid as before, with either lookup */
+  wfc_test_setup_simple_tiles(&simple_tiles, &tiles_memory);
+  assert(wfc_test_benchmark_neighbours(&simple_tiles, 512, WFC_NEIGHBOURS_COMPUTE, "wfc_neighbours_4_dirs_512x512_compute") == 0x652c7b8b);
+  assert(wfc_test_benchmark_neighbours(&simple_tiles, 512, WFC_NEIGHBOURS_TABLE, "wfc_neighbours_4_dirs_512x512_table") == 0x652c7b8b);
+  assert(wfc_test_benchmark_neighbours_sweep(&simple_tiles, 1024, WFC_NEIGHBOURS_COMPUTE, "wfc_neighbours_sweep_4_dirs_1024x1024_compute") == 1024 * 1024 * 4);
+  assert(wfc_test_benchmark_neighbours_sweep(&simple_tiles, 1024, WFC_NEIGHBOURS_TABLE, "wfc_neighbours_sweep_4_dirs_1024x1024_table") == 1024 * 1024 * 4);
+  free(tiles_memory);
+
+  /* 8 directions including the diagonals */
+  wfc_test_setup_random_tiles(&diagonal_tiles, &tiles_memory, 128, 8, 1, 2, 42);
+  assert(wfc_test_benchmark_neighbours(&diagonal_tiles, 128, WFC_NEIGHBOURS_COMPUTE, "wfc_neighbours_8_dirs_128x128_compute") ==
+         wfc_test_benchmark_neighbours(&diagonal_tiles, 128, WFC_NEIGHBOURS_TABLE, "wfc_neighbours_8_dirs_128x128_table"));
+  free(tiles_memory);
+
+  wfc_test_setup_random_tiles(&sweep_tiles, &tiles_memory, 8, 8, 1, 2, 42);
+  assert(wfc_test_benchmark_neighbours_sweep(&sweep_tiles, 512, WFC_NEIGHBOURS_COMPUTE, "wfc_neighbours_sweep_8_dirs_512x512_compute") ==
+         wfc_test_benchmark_neighbours_sweep(&sweep_tiles, 512, WFC_NEIGHBOURS_TABLE, "wfc_neighbours_sweep_8_dirs_512x512_table"));
+  free(tiles_memory);
+}
+
+static int wfc_test_words_equal(unsigned int *a, unsigned int *b, unsigned int count)
+{
+  unsigned int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    if (a[i] != b[i])
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Fills words with garbage, so a build that leaves a row unwritten can not match the reference */
+static void wfc_test_scramble_words(unsigned int *words, unsigned int count)
+{
+  unsigned int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    words[i] = 0xDEADBEEFu;
+  }
+}
+
+/* Compares every tile pair and direction like wfc_tiles_compute_compatible_tiles did before the socket index */
+static void wfc_test_compute_compatible_tiles_reference(wfc_tiles *tiles, unsigned int *masks)
+{
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = (tile_count + 31) / 32;
+  unsigned int a, b, d;
+
+  for (a = 0; a < tile_count * dir_count * mask_words; ++a)
+  {
+    masks[a] = 0;
+  }
+
+  for (a = 0; a < tile_count; ++a)
+  {
+    for (d = 0; d < dir_count; ++d)
+    {
+      unsigned int base = (a * dir_count + d) * mask_words;
+      unsigned int opp_dir = (d + dir_count / 2) % dir_count;
+      wfc_socket_8x07 socket_a = tiles->tile_direction_sockets[a * dir_count + d];
+
+      for (b = 0; b < tile_count; ++b)
+      {
+        wfc_socket_8x07 socket_b = tiles->tile_direction_sockets[b * dir_count + opp_dir];
+
+        if (wfc_socket_reverse(socket_b, tiles->tile_direction_socket_count) == socket_a)
+        {
+          masks[base + (b / 32)] |= 1u << (b % 32);
+        }
+      }
+    }
+  }
+}
+
+/* Times the reference and the indexed computation of the compatible masks and checks they are identical */
+static void wfc_test_benchmark_compatible_tiles(unsigned int tile_count, unsigned int direction_count, char *name_reference, char *name_indexed)
+{
+  unsigned char *tiles_memory;
+  unsigned int *masks;
+  unsigned int mask_size;
+  double time_start;
+  double time_reference_ms;
+  double time_indexed_ms;
+
+  wfc_tiles tiles = {0};
+  wfc_test_setup_random_tiles(&tiles, &tiles_memory, tile_count, direction_count, 3, 4, 7);
+
+  mask_size = tile_count * direction_count * ((tile_count + 31) / 32);
+  masks = malloc(sizeof(unsigned int) * mask_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ wfc_test_compute_compatible_tiles_reference(&tiles, masks); }, name_reference);
+  time_reference_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ assert(wfc_tiles_compute_compatible_tiles(&tiles)); }, name_indexed);
+  time_indexed_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_words_equal(masks, tiles.tile_direction_compatible_masks, mask_size));
+
+  printf("[wfc] %-44s %10.3f ms -> %10.3f ms\n", name_indexed, time_reference_ms, time_indexed_ms);
+
+  free(masks);
+  free(tiles_memory);
+}
+
+static void wfc_test_compatible_tiles_index(void)
+{
+  unsigned int tile_counts[] = {1, 2, 31, 32, 33, 100};
+  unsigned int i, socket_count, direction_count;
+
+  /* Identical masks to the pairwise comparison, including unmatched sockets and duplicate buckets */
+  for (i = 0; i < sizeof(tile_counts) / sizeof(tile_counts[0]); ++i)
+  {
+    for (direction_count = 4; direction_count <= 8; direction_count += 4)
+    {
+      for (socket_count = 1; socket_count <= 8; socket_count += 3)
+      {
+        unsigned char *tiles_memory;
+        unsigned int *masks;
+        unsigned int mask_size = tile_counts[i] * direction_count * ((tile_counts[i] + 31) / 32);
+
+        wfc_tiles tiles = {0};
+        wfc_test_setup_random_tiles(&tiles, &tiles_memory, tile_counts[i], direction_count, socket_count, 2, i * 31 + socket_count);
+
+        masks = malloc(sizeof(unsigned int) * mask_size);
+        wfc_test_compute_compatible_tiles_reference(&tiles, masks);
+
+        assert(wfc_tiles_compute_compatible_tiles(&tiles));
+        assert(wfc_test_words_equal(masks, tiles.tile_direction_compatible_masks, mask_size));
+
+        free(masks);
+        free(tiles_memory);
+      }
+    }
+  }
+
+  /* Startup time of the tile set compilation */
+  wfc_test_benchmark_compatible_tiles(64, 4, "wfc_compatible_tiles_reference_64_tiles", "wfc_compatible_tiles_index_64_tiles");
+  wfc_test_benchmark_compatible_tiles(512, 4, "wfc_compatible_tiles_reference_512_tiles", "wfc_compatible_tiles_index_512_tiles");
+  wfc_test_benchmark_compatible_tiles(2000, 4, "wfc_compatible_tiles_reference_2000_tiles", "wfc_compatible_tiles_index_2000_tiles");
+  wfc_test_benchmark_compatible_tiles(2000, 8, "wfc_compatible_tiles_reference_2000_tiles_8_dirs", "wfc_compatible_tiles_index_2000_tiles_8_dirs");
+}
+
+/* Builds the compatible masks with 1 - 16 threads and prints the time against the serial build */
+static void wfc_test_benchmark_compatible_tiles_parallel(unsigned int tile_count, unsigned int direction_count)
+{
+  unsigned char *tiles_memory;
+  unsigned int *masks;
+  unsigned int *memory;
+  unsigned int memory_size;
+  unsigned int mask_size;
+  unsigned int thread_count;
+  char name[64];
+  double time_start;
+  double time_serial_ms;
+  double time_ms;
+
+  wfc_tiles tiles = {0};
+  wfc_test_setup_random_tiles(&tiles, &tiles_memory, tile_count, direction_count, 3, 4, 7);
+
+  mask_size = tile_count * direction_count * ((tile_count + 31) / 32);
+  masks = malloc(sizeof(unsigned int) * mask_size);
+  memory_size = WFC_TILES_PARALLEL_MEMORY_SIZE(tile_count, direction_count);
+  memory = malloc(memory_size);
+
+  /* Warm up the mask memory so the first build does not pay the page faults */
+  assert(wfc_tiles_compute_compatible_tiles(&tiles));
+
+  time_start = perf_platform_current_time_nanoseconds();
+  assert(wfc_tiles_compute_compatible_tiles(&tiles));
+  time_serial_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  for (thread_count = 0; thread_count < mask_size; ++thread_count)
+  {
+    masks[thread_count] = tiles.tile_direction_compatible_masks[thread_count];
+  }
+
+  printf("[wfc] %-44s %10.3f ms (%u tiles, %u dirs)\n", "wfc_compatible_tiles_serial", time_serial_ms, tile_count, direction_count);
+
+  for (thread_count = 1; thread_count <= 16; thread_count *= 2)
+  {
+    time_start = perf_platform_current_time_nanoseconds();
+    assert(wfc_tiles_compute_compatible_tiles_parallel(&tiles, thread_count, memory, memory_size));
+    time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+    assert(wfc_test_words_equal(masks, tiles.tile_direction_compatible_masks, mask_size));
+
+    sprintf(name, "wfc_compatible_tiles_parallel_%u_threads", thread_count);
+    printf("[wfc] %-44s %10.3f ms (%5.2fx)\n", name, time_ms, time_serial_ms / time_ms);
+  }
+
+  free(memory);
+  free(masks);
+  free(tiles_memory);
+}
+
+static void wfc_test_compatible_tiles_parallel(void)
+{
+  unsigned int tile_counts[] = {1, 31, 33, 100, 300};
+  unsigned int thread_counts[] = {1, 2, 3, 7, 16};
+  unsigned int i, t, direction_count;
+
+  for (i = 0; i < sizeof(tile_counts) / sizeof(tile_counts[0]); ++i)
+  {
+    for (direction_count = 4; direction_count <= 8; direction_count += 2)
+    {
+      unsigned char *tiles_memory;
+      unsigned int *masks;
+      unsigned int *memory;
+      unsigned int memory_size = WFC_TILES_PARALLEL_MEMORY_SIZE(tile_counts[i], direction_count);
+      unsigned int mask_size = tile_counts[i] * direction_count * ((tile_counts[i] + 31) / 32);
+      unsigned int phase, job;
+
+      wfc_tiles tiles = {0};
+      wfc_test_setup_random_tiles(&tiles, &tiles_memory, tile_counts[i], direction_count, 3, 2, i + direction_count);
+
+      masks = malloc(sizeof(unsigned int) * mask_size);
+      memory = malloc(memory_size);
+      wfc_test_compute_compatible_tiles_reference(&tiles, masks);
+
+      /* Not enough scratch memory or threads */
+      assert(!wfc_tiles_compute_compatible_tiles_parallel(&tiles, 2, memory, memory_size - 1));
+      assert(!wfc_tiles_compute_compatible_tiles_parallel(&tiles, 0, memory, memory_size));
+
+      /* Identical masks for any number of threads, including more threads than directions or mask words */
+      for (t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t)
+      {
+        wfc_test_scramble_words(tiles.tile_direction_compatible_masks, mask_size);
+        assert(wfc_tiles_compute_compatible_tiles_parallel(&tiles, thread_counts[t], memory, memory_size));
+        assert(wfc_test_words_equal(masks, tiles.tile_direction_compatible_masks, mask_size));
+      }
+
+      /* The jobs of a phase can run in any order on an external scheduler */
+      wfc_test_scramble_words(tiles.tile_direction_compatible_masks, mask_size);
+      assert(wfc_tiles_compute_compatible_tiles_parallel_begin(&tiles, memory, memory_size));
+
+      for (phase = 0; phase < WFC_TILES_PARALLEL_PHASES; ++phase)
+      {
+        /* Half built masks must not be used */
+        assert(tiles.tiles_compatible_tiles_computed == 0);
+
+        for (job = 5; job > 0; --job)
+        {
+          wfc_tiles_compute_compatible_tiles_job(&tiles, memory, phase, job - 1, 5);
+        }
+      }
+
+      wfc_tiles_compute_compatible_tiles_parallel_end(&tiles);
+      assert(tiles.tiles_compatible_tiles_computed == 1);
+      assert(wfc_test_words_equal(masks, tiles.tile_direction_compatible_masks, mask_size));
+
+      free(memory);
+      free(masks);
+      free(tiles_memory);
+    }
+  }
+
+  wfc_test_benchmark_compatible_tiles_parallel(4096, 8);
+}
+
+/* Times rebuilding a tile set (add tiles + compute the masks) against loading it from its serialized form */
+static void wfc_test_benchmark_serialization(unsigned int tile_count, char *name_rebuild, char *name_load)
+{
+  unsigned char *tiles_memory;
+  unsigned char *buffer;
+  unsigned int buffer_size;
+  double time_start;
+  double time_rebuild_ms;
+  double time_load_ms;
+
+  wfc_tiles tiles = {0};
+  wfc_tiles loaded = {0};
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ wfc_test_setup_random_tiles(&tiles, &tiles_memory, tile_count, 4, 3, 4, 7); }, name_rebuild);
+  time_rebuild_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  buffer_size = wfc_tiles_serialized_size(&tiles);
+  buffer = malloc(buffer_size);
+  assert(wfc_tiles_serialize(&tiles, buffer, buffer_size) == buffer_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ assert(wfc_tiles_deserialize(&loaded, buffer, buffer_size)); }, name_load);
+  time_load_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_tiles_is_compatible_tile(&loaded, tile_count - 1, 3, 0) == wfc_tiles_is_compatible_tile(&tiles, tile_count - 1, 3, 0));
+
+  printf("[wfc] %-44s %10.3f ms -> %10.6f ms (%u bytes)\n", name_load, time_rebuild_ms, time_load_ms, buffer_size);
+
+  free(buffer);
+  free(tiles_memory);
+}
+
+static void wfc_test_serialization(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *buffer;
+  unsigned char *grid_memory;
+  unsigned int buffer_size;
+  unsigned int grid_memory_size;
+  unsigned int hash;
+  wfc_socket_8x07 socket_buffer[4] = {0};
+  wfc_tiles_serialized_header *header;
+
+  wfc_tiles tiles = {0};
+  wfc_tiles loaded = {0};
+  wfc_grid grid = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+  assert(wfc_tiles_set_weight(&tiles, 0, 7));
+
+  buffer_size = wfc_tiles_serialized_size(&tiles);
+  assert(buffer_size == sizeof(wfc_tiles_serialized_header) + sizeof(unsigned int) * (5 * 3 + 5 * 4 + 5 * 4 * 1));
+  buffer = malloc(buffer_size);
+
+  assert(wfc_tiles_serialize(&tiles, buffer, buffer_size - 1) == 0);
+  assert(wfc_tiles_serialize(&tiles, buffer, buffer_size) == buffer_size);
+
+  /* The loaded set points into the buffer and matches the original */
+  assert(wfc_tiles_deserialize(&loaded, buffer, buffer_size));
+  assert(loaded.tiles_initialized == 1);
+  assert(loaded.tiles_compatible_tiles_computed == 1);
+  assert(loaded.tile_count == 5);
+  assert(loaded.tile_capacity == 5);
+  assert(loaded.tile_direction_count == 4);
+  assert(loaded.tile_direction_socket_count == 3);
+  assert(loaded.tile_direction_compatible_masks_words == 1);
+  assert((unsigned char *)loaded.tile_asset_ids == buffer + sizeof(wfc_tiles_serialized_header));
+  assert(wfc_test_words_equal(loaded.tile_asset_ids, tiles.tile_asset_ids, 5));
+  assert(wfc_test_words_equal(loaded.tile_rotations, tiles.tile_rotations, 5));
+  assert(wfc_test_words_equal(loaded.tile_weights, tiles.tile_weights, 5));
+  assert(loaded.tile_weights[0] == 7);
+  assert(wfc_test_words_equal(loaded.tile_direction_sockets, tiles.tile_direction_sockets, 5 * 4));
+  assert(wfc_test_words_equal(loaded.tile_direction_compatible_masks, tiles.tile_direction_compatible_masks, 5 * 4));
+
+  /* Loaded sets are full and already computed */
+  assert(!wfc_tiles_add_tile(&loaded, 99, socket_buffer, 0));
+  assert(!wfc_tiles_compute_compatible_tiles(&loaded));
+  assert(wfc_test_words_equal(loaded.tile_direction_compatible_masks, tiles.tile_direction_compatible_masks, 5 * 4));
+
+  /* Solving with the loaded set gives the same grid */
+  grid.cols = 64;
+  grid.rows = 64;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 1337);
+  hash = wfc_test_grid_hash(&grid);
+  wfc_test_solve(&grid, &loaded, grid_memory, grid_memory_size, 1337);
+  assert(wfc_test_grid_is_solved(&grid, &loaded));
+  assert(wfc_test_grid_hash(&grid) == hash);
+
+  /* Truncated or corrupt buffers are rejected */
+  header = (wfc_tiles_serialized_header *)buffer;
+  assert(!wfc_tiles_deserialize(&loaded, buffer, buffer_size - 1));
+  assert(!wfc_tiles_deserialize(&loaded, buffer, sizeof(wfc_tiles_serialized_header) - 1));
+
+  header->magic = 0x57464354u; /* Other endianness */
+  assert(!wfc_tiles_deserialize(&loaded, buffer, buffer_size));
+  header->magic = WFC_TILES_SERIALIZED_MAGIC;
+
+  header->version = WFC_TILES_SERIALIZED_VERSION + 1;
+  assert(!wfc_tiles_deserialize(&loaded, buffer, buffer_size));
+  header->version = WFC_TILES_SERIALIZED_VERSION;
+
+  header->tile_count = 0x40000000u;
+  assert(!wfc_tiles_deserialize(&loaded, buffer, buffer_size));
+  header->tile_count = 5;
+
+  header->data_size += 4;
+  assert(!wfc_tiles_deserialize(&loaded, buffer, buffer_size + 4));
+  header->data_size -= 4;
+
+  assert(wfc_tiles_deserialize(&loaded, buffer, buffer_size));
+
+  free(grid_memory);
+  free(buffer);
+  free(tiles_memory);
+
+  /* Startup time */
+  wfc_test_benchmark_serialization(64, "wfc_tiles_rebuild_64_tiles", "wfc_tiles_load_64_tiles");
+  wfc_test_benchmark_serialization(512, "wfc_tiles_rebuild_512_tiles", "wfc_tiles_load_512_tiles");
+  wfc_test_benchmark_serialization(4096, "wfc_tiles_rebuild_4096_tiles", "wfc_tiles_load_4096_tiles");
+}
+
+/* Compares the file name next to this source file with the text_length bytes of text.
+   Returns 1 if they are equal, 0 if not and -1 if the file can not be found from the current directory */
+static int wfc_test_file_equals(char *name, unsigned char *text, unsigned int text_length)
+{
+  char path[512];
+  char *source = __FILE__;
+  unsigned int directory_length = 0;
+  unsigned int i;
+  FILE *fp;
+  int c;
+
+  for (i = 0; source[i]; ++i)
+  {
+    if (source[i] == '/' || source[i] == '\\')
+    {
+      directory_length = i + 1;
+    }
+  }
+
+  for (i = 0; i < directory_length && i < sizeof(path) - 1; ++i)
+  {
+    path[i] = source[i];
+  }
+
+  for (; *name && i < sizeof(path) - 1; ++name, ++i)
+  {
+    path[i] = *name;
+  }
+
+  path[i] = '\0';
+  fp = fopen(path, "rb");
+
+  if (!fp)
+  {
+    return -1;
+  }
+
+  i = 0;
+
+  while ((c = fgetc(fp)) != EOF && i < text_length && (unsigned char)c == text[i])
+  {
+    ++i;
+  }
+
+  fclose(fp);
+
+  return c == EOF && i == text_length;
+}
+
+static void wfc_test_generate_header(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned char *header;
+  unsigned int header_size;
+  unsigned int grid_memory_size;
+  unsigned int hash;
+  unsigned int i;
+  int identical = 1;
+  wfc_socket_8x07 socket_buffer[4] = {0};
+  unsigned char truncated[65];
+  unsigned char regenerated[1357];
+  unsigned int parallel_memory[WFC_TILES_PARALLEL_MEMORY_SIZE(5, 4) / sizeof(unsigned int)];
+  int file_equal;
+
+  wfc_tiles tiles = {0};
+  wfc_tiles generated = {0};
+  wfc_tiles uncomputed = {0};
+  wfc_grid grid = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+
+  /* tests/wfc_test_tiles_simple.h was written by wfc_tiles_generate_header for the simple tile set */
+  assert(wfc_test_simple_tiles_initialize(&generated));
+  assert(generated.tile_count == 5);
+  assert(generated.tile_capacity == 5);
+  assert(generated.tile_direction_count == 4);
+  assert(generated.tile_direction_socket_count == 3);
+  assert(generated.tiles_compatible_tiles_computed == 1);
+  assert(wfc_test_words_equal(generated.tile_asset_ids, tiles.tile_asset_ids, 5));
+  assert(wfc_test_words_equal(generated.tile_rotations, tiles.tile_rotations, 5));
+  assert(wfc_test_words_equal(generated.tile_weights, tiles.tile_weights, 5));
+  assert(wfc_test_words_equal(generated.tile_direction_sockets, tiles.tile_direction_sockets, 5 * 4));
+  assert(wfc_test_words_equal(generated.tile_direction_compatible_masks, tiles.tile_direction_compatible_masks, 5 * 4));
+
+  /* The read-only set is never written to */
+  assert(!wfc_tiles_add_tile(&generated, 99, socket_buffer, 0));
+  assert(!wfc_tiles_compute_compatible_tiles(&generated));
+  assert(!wfc_tiles_compute_compatible_tiles_parallel(&generated, 2, parallel_memory, sizeof(parallel_memory)));
+  assert(generated.tiles_compatible_tiles_computed == 1);
+
+  /* Same grid as with the runtime computed set */
+  grid.cols = 64;
+  grid.rows = 64;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 1337);
+  hash = wfc_test_grid_hash(&grid);
+  wfc_test_solve(&grid, &generated, grid_memory, grid_memory_size, 1337);
+  assert(wfc_test_grid_is_solved(&grid, &generated));
+  assert(wfc_test_grid_hash(&grid) == hash);
+
+  /* A 0 sized buffer returns the size, a short buffer gets the part that fits */
+  header_size = wfc_tiles_generate_header(&tiles, "wfc_test_simple", 0, 0);
+  assert(header_size == 1357);
+  header = malloc(header_size);
+  assert(wfc_tiles_generate_header(&tiles, "wfc_test_simple", header, header_size) == header_size);
+
+  truncated[64] = 0xAB;
+  assert(wfc_tiles_generate_header(&tiles, "wfc_test_simple", truncated, 64) == header_size);
+  assert(truncated[64] == 0xAB);
+
+  for (i = 0; i < 64; ++i)
+  {
+    identical &= truncated[i] == header[i];
+  }
+
+  assert(identical);
+
+  /* The compiled in header regenerates byte for byte */
+  assert(wfc_tiles_generate_header(&generated, "wfc_test_simple", regenerated, sizeof(regenerated)) == header_size);
+
+  for (i = 0; i < header_size; ++i)
+  {
+    identical &= regenerated[i] == header[i];
+  }
+
+  assert(identical);
+
+  /* So does the checked in file (stored with -text, see .gitattributes) when it is reachable from the working directory */
+  file_equal = wfc_test_file_equals("wfc_test_tiles_simple.h", header, header_size);
+  assert(file_equal != 0);
+
+  if (file_equal < 0)
+  {
+    printf("[wfc] %-44s skipped, tests/wfc_test_tiles_simple.h not found from the working directory\n", "wfc_generate_header_file");
+  }
+
+  /* Names must be C identifiers and the masks must be computed */
+  assert(wfc_tiles_generate_header(&tiles, "", header, header_size) == 0);
+  assert(wfc_tiles_generate_header(&tiles, "1tiles", header, header_size) == 0);
+  assert(wfc_tiles_generate_header(&tiles, "my-tiles", header, header_size) == 0);
+  assert(wfc_tiles_generate_header(&uncomputed, "tiles", header, header_size) == 0);
+
+  free(header);
+  free(grid_memory);
+  free(tiles_memory);
+}
+
+typedef struct wfc_test_rng_job
+{
+  wfc_tiles *tiles;
+  unsigned int seed;
+  unsigned int hash;
+  unsigned int retries;
+
+} wfc_test_rng_job;
+
+/* Solves a 128x128 grid with its own random state, retrying with the next seeds until it succeeds */
+static void wfc_test_rng_job_run(void *argument)
+{
+  wfc_test_rng_job *job = (wfc_test_rng_job *)argument;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  wfc_rng rng;
+
+  wfc_grid grid = {0};
+  grid.cols = 128;
+  grid.rows = 128;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = WFC_PROPAGATION_WORKLIST;
+  grid.rng = &rng;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, job->tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  job->retries = 0;
+  wfc_rng_seed(&rng, job->seed);
+  wfc_grid_initialize(&grid, job->tiles, grid_memory, grid_memory_size);
+
+  while (!wfc(&grid, job->tiles))
+  {
+    wfc_grid_initialize(&grid, job->tiles, grid_memory, grid_memory_size);
+    wfc_rng_seed(&rng, job->seed + ++job->retries);
+  }
+
+  job->hash = wfc_test_grid_hash(&grid);
+
+  free(grid_memory);
+}
+
+static void wfc_test_rng_state(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int hash;
+  unsigned int i;
+  int identical = 1;
+  wfc_rng rng;
+  wfc_thread threads[4];
+  wfc_test_rng_job jobs[4];
+  unsigned int serial_hashes[4];
+
+  wfc_tiles tiles = {0};
+  wfc_grid grid = {0};
+
+  /* The per solver LCG produces the same sequence as the global generator */
+  rng.state[0] = 42;
+  wfc_seed_lcg = 42;
+
+  for (i = 0; i < 1000; ++i)
+  {
+    identical &= wfc_lcg_next(&rng) == wfc_randi();
+    identical &= wfc_lcg_range(&rng, 3, 17) == wfc_randi_range(3, 17);
+  }
+
+  assert(identical);
+  assert(rng.state[0] == wfc_seed_lcg);
+
+  /* A grid with its own state leaves the global generator untouched, the LCG solves like it with the same seed */
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+
+  grid.cols = 64;
+  grid.rows = 64;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  assert(wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 1337) == 0);
+  hash = wfc_test_grid_hash(&grid);
+
+  wfc_seed_lcg = 7;
+  wfc_rng_seed(&rng, 1337);
+  grid.rng = &rng;
+  assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+  assert(wfc(&grid, &tiles));
+  assert(wfc_seed_lcg == 7);
+#if WFC_RNG == WFC_RNG_LCG
+  assert(wfc_test_grid_hash(&grid) == hash);
+#else
+  (void)hash;
+#endif
+
+  /* Grids solved concurrently give the same results as solved one after another */
+  for (i = 0; i < 4; ++i)
+  {
+    jobs[i].tiles = &tiles;
+    jobs[i].seed = 100 + i * 10;
+    wfc_test_rng_job_run(&jobs[i]);
+    serial_hashes[i] = jobs[i].hash;
+    jobs[i].hash = 0;
+  }
+
+  for (i = 0; i < 4; ++i)
+  {
+    assert(wfc_thread_create(&threads[i], wfc_test_rng_job_run, &jobs[i]));
+  }
+
+  for (i = 0; i < 4; ++i)
+  {
+    wfc_thread_join(&threads[i]);
+    identical &= jobs[i].hash == serial_hashes[i];
+  }
+
+  assert(identical);
+
+  free(grid_memory);
+  free(tiles_memory);
+}
+
+/* Times wfc_rng_range style draws over the entropy counts 2 .. 257 and returns ns per draw */
+#define WFC_TEST_BENCHMARK_RNG(name, draw)                                                          \
+  do                                                                                                \
+  {                                                                                                 \
+    double time_start = perf_platform_current_time_nanoseconds();                                   \
+    double time_ns;                                                                                 \
+    sum = 0;                                                                                        \
+    PERF_PROFILE_WITH_NAME({                                                                        \
+      for (i = 0; i < 10000000; ++i)                                                                \
+      {                                                                                             \
+        unsigned int range = 2 + (i & 0xFF);                                                        \
+        draw;                                                                                       \
+        sum += value;                                                                               \
+      }                                                                                             \
+    }, name);                                                                                       \
+    time_ns = (perf_platform_current_time_nanoseconds() - time_start) / 10000000.0;                 \
+    printf("[wfc] %-44s %10.3f ns/collapse (sum %u)\n", name, time_ns, sum);                        \
+  } while (0)
+
+static void wfc_test_rng_generators(void)
+{
+  unsigned int pcg32_expected[6] = {0xA15C02B7u, 0x7B47F409u, 0xBA1D3330u, 0x83D2F293u, 0xBFA4784Bu, 0xCBED606Eu};
+  unsigned int xoshiro128_expected[6] = {0x00002D00u, 0x00000000u, 0x005A7080u, 0x04389D80u, 0x79199D9Bu, 0x61963B24u};
+  unsigned int splitmix32_expected[3] = {0x92CA2F0Eu, 0x3CD6E3F3u, 0x1B147DCCu};
+  unsigned int below_lcg = 0;
+  unsigned int below_pcg32 = 0;
+  unsigned int below_xoshiro128 = 0;
+  unsigned int buckets[6] = {0};
+  unsigned int max_lcg = 0;
+  unsigned int max_pcg32 = 0;
+  unsigned int splitmix_state = 0;
+  unsigned int value;
+  unsigned int sum;
+  unsigned int i;
+  int identical = 1;
+
+  wfc_rng lcg;
+  wfc_rng pcg32;
+  wfc_rng xoshiro128;
+
+  /* Reference outputs: pcg32_srandom(42, 54), xoshiro128** from {1, 2, 3, 4}, splitmix32 from 0 */
+  wfc_pcg32_seed(&pcg32, 42, 54);
+  xoshiro128.state[0] = 1;
+  xoshiro128.state[1] = 2;
+  xoshiro128.state[2] = 3;
+  xoshiro128.state[3] = 4;
+
+  for (i = 0; i < 6; ++i)
+  {
+    identical &= wfc_pcg32_next(&pcg32) == pcg32_expected[i];
+    identical &= wfc_xoshiro128_next(&xoshiro128) == xoshiro128_expected[i];
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    identical &= wfc_splitmix32_next(&splitmix_state) == splitmix32_expected[i];
+  }
+
+  assert(identical);
+
+  /* The wide multiply matches the portable 16 bit limb version */
+  lcg.state[0] = 5;
+
+  for (i = 0; i < 10000; ++i)
+  {
+    unsigned int a = i < 4 ? (i & 1 ? 0xFFFFFFFFu : 0) : wfc_lcg_next(&lcg);
+    unsigned int b = i < 4 ? (i & 2 ? 0xFFFFFFFFu : 1) : wfc_lcg_next(&lcg);
+    unsigned int hi, lo, hi_portable, lo_portable;
+
+    wfc_mul_wide(a, b, &hi, &lo);
+    wfc_mul_wide_portable(a, b, &hi_portable, &lo_portable);
+    identical &= hi == hi_portable && lo == lo_portable;
+  }
+
+  assert(identical);
+
+  /* A zero seed still gives a working xoshiro state */
+  wfc_xoshiro128_seed(&xoshiro128, 0);
+  assert((xoshiro128.state[0] | xoshiro128.state[1] | xoshiro128.state[2] | xoshiro128.state[3]) != 0);
+
+  /* Bias: for a range of 40000 the LCG's 16 bit modulo hits the values below 65536 % 40000 = 25536 twice as often.
+     Unbiased draws land there 63.84% of the time, the LCG 77.92% */
+  lcg.state[0] = 1;
+  wfc_pcg32_seed(&pcg32, 1, 0xDA3E39CBu);
+  wfc_xoshiro128_seed(&xoshiro128, 1);
+
+  for (i = 0; i < 400000; ++i)
+  {
+    while (!wfc_rng_reduce(wfc_pcg32_next(&pcg32), 40000, &value))
+    {
+    }
+    below_pcg32 += value < 25536;
+
+    while (!wfc_rng_reduce(wfc_xoshiro128_next(&xoshiro128), 40000, &value))
+    {
+    }
+    below_xoshiro128 += value < 25536;
+
+    below_lcg += wfc_lcg_range(&lcg, 0, 40000) < 25536;
+  }
+
+  printf("[wfc] %-44s lcg %6.2f%%, pcg32 %6.2f%%, xoshiro128 %6.2f%% (expected 63.84%%)\n", "wfc_rng_range_bias_40000",
+         100.0 * below_lcg / 400000.0, 100.0 * below_pcg32 / 400000.0, 100.0 * below_xoshiro128 / 400000.0);
+
+  assert(below_lcg > 400000 * 77 / 100);
+  assert(below_pcg32 > 400000 * 63 / 100 && below_pcg32 < 400000 * 645 / 1000);
+  assert(below_xoshiro128 > 400000 * 63 / 100 && below_xoshiro128 < 400000 * 645 / 1000);
+
+  /* Ranges above 2^16: the LCG never reaches the upper values */
+  for (i = 0; i < 100000; ++i)
+  {
+    unsigned int lcg_value = wfc_lcg_range(&lcg, 0, 100000);
+
+    while (!wfc_rng_reduce(wfc_pcg32_next(&pcg32), 100000, &value))
+    {
+    }
+
+    max_lcg = lcg_value > max_lcg ? lcg_value : max_lcg;
+    max_pcg32 = value > max_pcg32 ? value : max_pcg32;
+  }
+
+  assert(max_lcg < 65536);
+  assert(max_pcg32 > 99000 && max_pcg32 < 100000);
+
+  /* Small ranges are uniform within 1% */
+  for (i = 0; i < 600000; ++i)
+  {
+    while (!wfc_rng_reduce(wfc_xoshiro128_next(&xoshiro128), 6, &value))
+    {
+    }
+    buckets[value]++;
+  }
+
+  for (i = 0; i < 6; ++i)
+  {
+    assert(buckets[i] > 99000 && buckets[i] < 101000);
+  }
+
+  /* A range of 1 (and 0) always gives 0 */
+  assert(wfc_rng_reduce(0xFFFFFFFFu, 1, &value) && value == 0);
+  assert(wfc_rng_reduce(0xFFFFFFFFu, 0, &value) && value == 0);
+
+  /* Cost of one random tile choice */
+  WFC_TEST_BENCHMARK_RNG("wfc_rng_lcg_modulo", value = wfc_lcg_range(&lcg, 0, range));
+  WFC_TEST_BENCHMARK_RNG("wfc_rng_pcg32_multiply_shift", while (!wfc_rng_reduce(wfc_pcg32_next(&pcg32), range, &value)){});
+  WFC_TEST_BENCHMARK_RNG("wfc_rng_xoshiro128_multiply_shift", while (!wfc_rng_reduce(wfc_xoshiro128_next(&xoshiro128), range, &value)){});
+}
+
+/* Returns 1 if the incrementally maintained weight sums and entropies of every cell match a recount from its mask */
+static int wfc_test_weight_sums_consistent(wfc_grid *grid)
+{
+  unsigned int i, k;
+
+  for (i = 0; i < grid->rows * grid->cols; ++i)
+  {
+    unsigned int weight_sum = 0;
+    unsigned int count = 0;
+    double weight_log_sum = 0.0;
+
+    for (k = 0; k < grid->cell_entropy_mask_words * 32; ++k)
+    {
+      if (grid->cell_entropy_masks[i * grid->cell_entropy_mask_words + k / 32] & (1u << (k % 32)))
+      {
+        weight_sum += grid->tile_weights[k];
+        weight_log_sum += grid->tile_weight_logs[k];
+        count++;
+      }
+    }
+
+    /* The weight logs are rounded so that the sums are exact in any order */
+    if (grid->cell_weight_sums[i] != weight_sum || grid->cell_weight_log_sums[i] != weight_log_sum || grid->cell_entropy_count[i] != count)
+    {
+      return 0;
+    }
+
+    if (!grid->cell_collapsed[i] && grid->cell_shannon_entropy[i] != wfc_grid_shannon_entropy(grid, i, count))
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Solves the grid with the given entropy and propagation, prints ms/grid and returns the grid hash */
+static unsigned int wfc_test_benchmark_entropy(wfc_tiles *tiles, unsigned int entropy, unsigned int propagation, unsigned int size, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int retries;
+  unsigned int hash;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = propagation;
+  grid.entropy = entropy;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ retries = wfc_test_solve(&grid, tiles, grid_memory, grid_memory_size, 1337); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved(&grid, tiles));
+  hash = wfc_test_grid_hash(&grid);
+
+  printf("[wfc] %-44s %10.3f ms/grid (%u retries, hash %08x)\n", name, time_ms, retries, hash);
+
+  free(grid_memory);
+
+  return hash;
+}
+
+/* Solves a size x size grid and returns how many cells hold tile */
+static unsigned int wfc_test_count_tile(wfc_tiles *tiles, unsigned int entropy, unsigned int size, unsigned int tile)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int count = 0;
+  unsigned int i;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.entropy = entropy;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  wfc_test_solve(&grid, tiles, grid_memory, grid_memory_size, 1337);
+  assert(wfc_test_grid_is_solved(&grid, tiles));
+
+  for (i = 0; i < size * size; ++i)
+  {
+    count += wfc_grid_find_nth_tile_in_mask(&grid, i, 0) == tile;
+  }
+
+  free(grid_memory);
+
+  return count;
+}
+
+static void wfc_test_weighted_entropy(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int uniform_count;
+  unsigned int weighted_count;
+  unsigned int propagation;
+  unsigned int i;
+  double max_error = 0.0;
+
+  wfc_tiles tiles = {0};
+  wfc_grid grid = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+
+  /* Weights must be positive and belong to an existing tile */
+  assert(tiles.tile_weights[4] == 1);
+  assert(!wfc_tiles_set_weight(&tiles, 0, 0));
+  assert(!wfc_tiles_set_weight(&tiles, 5, 1));
+
+  /* With uniform weights the Shannon entropy orders the cells like the count and the weighted pick is the uniform one */
+  assert(wfc_test_benchmark_entropy(&tiles, WFC_ENTROPY_COUNT, WFC_PROPAGATION_NEIGHBOURS, 512, "wfc_count_neighbours_5_tiles_512x512") == 0x652c7b8b);
+  assert(wfc_test_benchmark_entropy(&tiles, WFC_ENTROPY_SHANNON, WFC_PROPAGATION_NEIGHBOURS, 512, "wfc_shannon_neighbours_5_tiles_512x512") == 0x652c7b8b);
+  assert(wfc_test_benchmark_entropy(&tiles, WFC_ENTROPY_COUNT, WFC_PROPAGATION_WORKLIST, 512, "wfc_count_worklist_5_tiles_512x512") == 0x652c7b8b);
+  assert(wfc_test_benchmark_entropy(&tiles, WFC_ENTROPY_SHANNON, WFC_PROPAGATION_WORKLIST, 512, "wfc_shannon_worklist_5_tiles_512x512") == 0x652c7b8b);
+  assert(wfc_test_benchmark_entropy(&tiles, WFC_ENTROPY_SHANNON, WFC_PROPAGATION_SUPPORT, 512, "wfc_shannon_support_5_tiles_512x512") == 0x652c7b8b);
+
+  /* The log2 table is exact for small sums and close for large ones */
+  grid.cols = 1;
+  grid.rows = 1;
+  grid.entropy = WFC_ENTROPY_SHANNON;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  assert(grid_memory_size == WFC_GRID_MEMORY_SIZE(1, 1, 5) + WFC_GRID_ENTROPY_MEMORY_SIZE(1, 1, 5));
+  grid_memory = malloc(grid_memory_size);
+  assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+  assert(wfc_log2(1.0) == 0.0);
+  assert(wfc_log2(8.0) == 3.0);
+  assert(wfc_log2(10.0) > 3.3219280948873 && wfc_log2(10.0) < 3.3219280948874);
+  assert(wfc_grid_log2_uint(&grid, 1) == 0.0);
+  assert(wfc_grid_log2_uint(&grid, 5) == wfc_log2(5.0));
+  assert(wfc_grid_log2_uint(&grid, 300) == wfc_log2(300.0));
+  assert(wfc_grid_log2_uint(&grid, 0x80000000u) == 31.0);
+
+  for (i = 3; i < 0x10000000u; i = i * 3 + 1)
+  {
+    double error = wfc_grid_log2_uint(&grid, i) - wfc_log2((double)i);
+    error = error < 0.0 ? -error : error;
+    max_error = error > max_error ? error : max_error;
+  }
+
+  assert(max_error < 0.00001);
+
+  /* Five uniform tiles: log2(5) */
+  assert(grid.cell_shannon_entropy[0] == wfc_log2(5.0));
+  free(grid_memory);
+
+  /* A heavier tile shows up more often */
+  uniform_count = wfc_test_count_tile(&tiles, WFC_ENTROPY_SHANNON, 64, 0);
+  assert(wfc_tiles_set_weight(&tiles, 0, 16));
+  weighted_count = wfc_test_count_tile(&tiles, WFC_ENTROPY_SHANNON, 64, 0);
+  assert(weighted_count > uniform_count * 2);
+  assert(wfc_test_count_tile(&tiles, WFC_ENTROPY_COUNT, 64, 0) < weighted_count);
+
+  /* The weights change the entropy: 16 + 4 * 1 is more certain than 5 * 1 */
+  grid.cols = 1;
+  grid.rows = 1;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+  assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+  assert(grid.cell_weight_sums[0] == 20);
+  assert(grid.cell_shannon_entropy[0] > 1.12 && grid.cell_shannon_entropy[0] < 1.13); /* log2(20) - 16 * 4 / 20 */
+
+  /* The LCG draws 16 bits, so grids using it are limited to a weight sum of 65536 */
+  {
+    wfc_rng rng;
+
+    assert(wfc_tiles_set_weight(&tiles, 0, 65532));
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(wfc_tiles_set_weight(&tiles, 0, 65533));
+    assert(!wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+    grid.rng = &rng;
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size) == (WFC_RNG != WFC_RNG_LCG));
+    grid.rng = 0;
+    assert(wfc_tiles_set_weight(&tiles, 0, 16));
+  }
+
+  free(grid_memory);
+
+  printf("[wfc] %-44s %10u -> %6u of %u cells\n", "wfc_entropy_tile_0_weight_16", uniform_count, weighted_count, 64 * 64);
+
+  free(tiles_memory);
+
+  /* The incremental sums match a recount after contradictions and backtracks of every propagation,
+     for single and multi word masks */
+  for (i = 0; i < 2; ++i)
+  {
+    wfc_tiles random_tiles = {0};
+    unsigned int t;
+
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, i ? 48 : 24, 4, 1, 3, 42);
+
+    for (t = 0; t < random_tiles.tile_count; ++t)
+    {
+      assert(wfc_tiles_set_weight(&random_tiles, t, 1 + (t * 7) % 13));
+    }
+
+    for (propagation = WFC_PROPAGATION_NEIGHBOURS; propagation <= WFC_PROPAGATION_SUPPORT; ++propagation)
+    {
+      unsigned int seed;
+
+      wfc_grid weighted_grid = {0};
+      weighted_grid.cols = 32;
+      weighted_grid.rows = 32;
+      weighted_grid.selection = propagation == WFC_PROPAGATION_WORKLIST ? WFC_SELECTION_LINEAR_SCAN : WFC_SELECTION_MIN_HEAP;
+      weighted_grid.propagation = propagation;
+      weighted_grid.entropy = WFC_ENTROPY_SHANNON;
+      weighted_grid.trail_capacity = propagation == WFC_PROPAGATION_NEIGHBOURS ? 0 : 1u << 16;
+      weighted_grid.backtrack_budget = 4;
+
+      grid_memory_size = wfc_grid_memory_size(&weighted_grid, &random_tiles);
+      grid_memory = malloc(grid_memory_size);
+
+      for (seed = 1; seed <= 4; ++seed)
+      {
+        wfc_seed_lcg = seed;
+        assert(wfc_grid_initialize(&weighted_grid, &random_tiles, grid_memory, grid_memory_size));
+        assert(wfc_test_weight_sums_consistent(&weighted_grid));
+
+        if (wfc(&weighted_grid, &random_tiles))
+        {
+          assert(wfc_test_grid_is_solved(&weighted_grid, &random_tiles));
+        }
+
+        assert(wfc_test_weight_sums_consistent(&weighted_grid));
+      }
+
+      /* With an unlimited budget backtracking still solves the weighted grid */
+      if (propagation != WFC_PROPAGATION_NEIGHBOURS)
+      {
+        weighted_grid.backtrack_budget = 0;
+        assert(wfc_test_solve(&weighted_grid, &random_tiles, grid_memory, grid_memory_size, 3) < 10);
+        assert(wfc_test_grid_is_solved(&weighted_grid, &random_tiles));
+        assert(wfc_test_weight_sums_consistent(&weighted_grid));
+      }
+
+      free(grid_memory);
+    }
+
+    free(tiles_memory);
+  }
+
+  /* Overhead of the weight sums on a larger set */
+  {
+    wfc_tiles random_tiles = {0};
+
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, 240, 4, 1, 8, 42);
+    wfc_test_benchmark_entropy(&random_tiles, WFC_ENTROPY_COUNT, WFC_PROPAGATION_WORKLIST, 32, "wfc_count_worklist_240_tiles_32x32");
+    wfc_test_benchmark_entropy(&random_tiles, WFC_ENTROPY_SHANNON, WFC_PROPAGATION_WORKLIST, 32, "wfc_shannon_worklist_240_tiles_32x32");
+    free(tiles_memory);
+  }
+}
+
+/* Sets up job_count jobs of size x size grids over one block of grid memory */
+static unsigned char *wfc_test_setup_batch(wfc_tiles *tiles, wfc_batch_job *jobs, wfc_grid *grids, unsigned int job_count, unsigned int size, unsigned int propagation)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int i;
+
+  for (i = 0; i < job_count; ++i)
+  {
+    wfc_grid grid = {0};
+    grid.cols = size;
+    grid.rows = size;
+    grid.selection = WFC_SELECTION_MIN_HEAP;
+    grid.propagation = propagation;
+    grids[i] = grid;
+  }
+
+  grid_memory_size = wfc_grid_memory_size(&grids[0], tiles);
+  grid_memory = malloc(grid_memory_size * job_count);
+
+  for (i = 0; i < job_count; ++i)
+  {
+    jobs[i].grid = &grids[i];
+    jobs[i].grid_memory = grid_memory + grid_memory_size * i;
+    jobs[i].grid_memory_size = grid_memory_size;
+    jobs[i].seed = 1000 + i * 7;
+    jobs[i].retries_max = 10;
+  }
+
+  return grid_memory;
+}
+
+static void wfc_test_batch(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  wfc_batch_job *jobs;
+  wfc_grid *grids;
+  unsigned int *hashes;
+  unsigned int thread_count;
+  unsigned int stolen;
+  unsigned int i;
+  int identical;
+  wfc_rng rng;
+
+  wfc_tiles tiles = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+
+  jobs = malloc(sizeof(wfc_batch_job) * 256);
+  grids = malloc(sizeof(wfc_grid) * 256);
+  hashes = malloc(sizeof(unsigned int) * 256);
+
+  /* Every job solves like a single grid with its own state seeded with the job seed */
+  grid_memory = wfc_test_setup_batch(&tiles, jobs, grids, 256, 32, WFC_PROPAGATION_NEIGHBOURS);
+  assert(wfc_batch_solve(&tiles, jobs, 256, 1, 0) == 256);
+
+  for (i = 0; i < 256; ++i)
+  {
+    hashes[i] = wfc_test_grid_hash(&grids[i]);
+  }
+
+  assert(jobs[5].status == WFC_BATCH_SOLVED && jobs[5].attempts == 1 && jobs[5].worker == 0 && jobs[5].time == 0.0);
+  wfc_rng_seed(&rng, jobs[5].seed);
+  grids[5].rng = &rng;
+  assert(wfc_grid_initialize(&grids[5], &tiles, jobs[5].grid_memory, jobs[5].grid_memory_size));
+  assert(wfc(&grids[5], &tiles));
+  assert(wfc_test_grid_hash(&grids[5]) == hashes[5]);
+
+  /* Throughput for 1 to 16 threads. The results do not depend on the thread count */
+  for (thread_count = 1; thread_count <= 16; thread_count *= 2)
+  {
+    double time_start = perf_platform_current_time_nanoseconds();
+    double time_ms;
+    char name[64];
+
+    assert(wfc_batch_solve(&tiles, jobs, 256, thread_count, perf_platform_current_time_nanoseconds) == 256);
+    time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+    identical = 1;
+    stolen = 0;
+
+    for (i = 0; i < 256; ++i)
+    {
+      identical &= jobs[i].status == WFC_BATCH_SOLVED && wfc_test_grid_hash(&grids[i]) == hashes[i];
+      identical &= jobs[i].worker < thread_count && jobs[i].time > 0.0;
+      stolen += jobs[i].stolen;
+    }
+
+    assert(identical);
+
+    sprintf(name, "wfc_batch_256_maps_32x32_%u_threads", thread_count);
+    printf("[wfc] %-44s %10.0f maps/sec (%u stolen)\n", name, 256.0 / (time_ms / 1000.0), stolen);
+  }
+
+  free(grid_memory);
+
+  /* Uneven jobs: the first worker's share is 16 times larger, the others steal from it */
+  grid_memory = wfc_test_setup_batch(&tiles, jobs, grids, 64, 32, WFC_PROPAGATION_NEIGHBOURS);
+
+  for (i = 0; i < 64; ++i)
+  {
+    grids[i].rows = i < 16 ? 32 : 8;
+    grids[i].cols = i < 16 ? 32 : 8;
+  }
+
+  assert(wfc_batch_solve(&tiles, jobs, 64, 4, perf_platform_current_time_nanoseconds) == 64);
+
+  identical = 1;
+  stolen = 0;
+
+  for (i = 0; i < 64; ++i)
+  {
+    identical &= wfc_test_grid_is_solved(&grids[i], &tiles);
+    identical &= jobs[i].stolen ? jobs[i].worker != i / 16 : jobs[i].worker == i / 16;
+    stolen += jobs[i].stolen;
+  }
+
+  assert(identical);
+  printf("[wfc] %-44s %10u of 64 jobs stolen\n", "wfc_batch_uneven_4_threads", stolen);
+
+  /* Jobs report failures instead of retrying forever */
+  jobs[3].grid_memory_size = 0;
+  jobs[4].retries_max = 0;
+  assert(wfc_batch_solve(&tiles, jobs, 8, 2, 0) == 7);
+  assert(jobs[3].status == WFC_BATCH_FAILED && jobs[3].attempts == 0);
+  assert(jobs[4].status == WFC_BATCH_SOLVED && jobs[4].attempts == 1);
+
+  free(grid_memory);
+  free(tiles_memory);
+
+  {
+    wfc_tiles random_tiles = {0};
+
+    /* Without the worklist this rule set contradicts on every attempt */
+    wfc_test_setup_random_tiles(&random_tiles, &tiles_memory, 24, 4, 1, 3, 42);
+    grid_memory = wfc_test_setup_batch(&random_tiles, jobs, grids, 4, 32, WFC_PROPAGATION_NEIGHBOURS);
+
+    for (i = 0; i < 4; ++i)
+    {
+      jobs[i].retries_max = 2;
+    }
+
+    assert(wfc_batch_solve(&random_tiles, jobs, 4, 4, 0) == 0);
+    assert(jobs[0].status == WFC_BATCH_FAILED && jobs[0].attempts == 3);
+    assert(jobs[3].status == WFC_BATCH_FAILED && jobs[3].attempts == 3);
+
+    free(grid_memory);
+    free(tiles_memory);
+  }
+
+  free(hashes);
+  free(grids);
+  free(jobs);
+}
+
+/* Sorts count latencies ascending and returns the given percentile */
+static double wfc_test_percentile(double *values, unsigned int count, unsigned int percentile)
+{
+  unsigned int i, j;
+
+  for (i = 1; i < count; ++i)
+  {
+    double value = values[i];
+
+    for (j = i; j > 0 && values[j - 1] > value; --j)
+    {
+      values[j] = values[j - 1];
+    }
+
+    values[j] = value;
+  }
+
+  return values[(count - 1) * percentile / 100];
+}
+
+/* The serial retry loop the race replaces: attempt n is seeded with seed + n. Returns the seed used or WFC_CELL_NONE */
+static unsigned int wfc_test_solve_serial(wfc_grid *grid, wfc_tiles *tiles, unsigned char *grid_memory, unsigned int grid_memory_size, unsigned int seed, unsigned int retries_max)
+{
+  wfc_rng rng;
+  unsigned int attempt;
+  unsigned int seed_used = WFC_CELL_NONE;
+
+  grid->rng = &rng;
+
+  for (attempt = 0; attempt <= retries_max; ++attempt)
+  {
+    wfc_rng_seed(&rng, seed + attempt);
+    assert(wfc_grid_initialize(grid, tiles, grid_memory, grid_memory_size));
+
+    if (wfc(grid, tiles))
+    {
+      seed_used = seed + attempt;
+      break;
+    }
+  }
+
+  grid->rng = 0;
+
+  return seed_used;
+}
+
+static void wfc_test_race(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int problem;
+  unsigned int i;
+  int identical = 1;
+  double *latencies[3];
+  wfc_grid grids[4];
+  wfc_race_lane lanes[4];
+  unsigned int cancelled = 0;
+
+  wfc_tiles tiles = {0};
+
+  /* A rule set that contradicts on most attempts, some seeds need dozens of restarts */
+  wfc_test_setup_random_tiles(&tiles, &tiles_memory, 32, 4, 1, 4, 42);
+
+  for (i = 0; i < 4; ++i)
+  {
+    wfc_grid grid = {0};
+    grid.cols = 24;
+    grid.rows = 24;
+    grid.selection = WFC_SELECTION_MIN_HEAP;
+    grid.propagation = WFC_PROPAGATION_WORKLIST;
+    grids[i] = grid;
+  }
+
+  grid_memory_size = wfc_grid_memory_size(&grids[0], &tiles);
+  grid_memory = malloc(grid_memory_size * 4);
+
+  for (i = 0; i < 4; ++i)
+  {
+    lanes[i].grid = &grids[i];
+    lanes[i].grid_memory = grid_memory + grid_memory_size * i;
+    lanes[i].grid_memory_size = grid_memory_size;
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    latencies[i] = malloc(sizeof(double) * 200);
+  }
+
+  /* A cancelled grid gives up right away */
+  {
+    volatile unsigned int cancel = 1;
+    wfc_rng rng;
+
+    wfc_rng_seed(&rng, 1);
+    grids[0].rng = &rng;
+    grids[0].cancel = &cancel;
+    assert(wfc_grid_initialize(&grids[0], &tiles, grid_memory, grid_memory_size));
+    assert(!wfc(&grids[0], &tiles));
+    assert(grids[0].cells_processed == 0);
+    grids[0].cancel = 0;
+  }
+
+  for (problem = 0; problem < 200; ++problem)
+  {
+    unsigned int seed = 1 + problem * 1000;
+    unsigned int serial_seed;
+    unsigned int serial_hash;
+    unsigned int seed_used = 0;
+    double time_start;
+    int winner;
+
+    /* Serial retry loop */
+    time_start = perf_platform_current_time_nanoseconds();
+    serial_seed = wfc_test_solve_serial(&grids[0], &tiles, grid_memory, grid_memory_size, seed, 999);
+    latencies[0][problem] = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+    assert(serial_seed != WFC_CELL_NONE);
+    serial_hash = wfc_test_grid_hash(&grids[0]);
+
+    /* The lowest seed race ends with the grid of the serial loop */
+    time_start = perf_platform_current_time_nanoseconds();
+    winner = wfc_race_solve(&tiles, lanes, 4, WFC_RACE_LOWEST_SEED, seed, 999, &seed_used);
+    latencies[1][problem] = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+    identical &= winner >= 0 && seed_used == serial_seed && wfc_test_grid_hash(&grids[winner]) == serial_hash;
+
+    for (i = 0; i < 4; ++i)
+    {
+      cancelled += lanes[i].cancelled;
+    }
+
+    /* The first success wins, any solved grid will do */
+    time_start = perf_platform_current_time_nanoseconds();
+    winner = wfc_race_solve(&tiles, lanes, 4, WFC_RACE_FIRST, seed, 999, &seed_used);
+    latencies[2][problem] = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+    identical &= winner >= 0 && seed_used >= seed && wfc_test_grid_is_solved(&grids[winner], &tiles);
+    identical &= grids[winner].rng == &lanes[winner].rng && grids[winner].cancel == 0;
+  }
+
+  assert(identical);
+
+  /* Without any success there is no winner */
+  for (problem = 1; wfc_test_solve_serial(&grids[0], &tiles, grid_memory, grid_memory_size, problem, 0) != WFC_CELL_NONE; ++problem)
+  {
+  }
+
+  assert(wfc_race_solve(&tiles, lanes, 4, WFC_RACE_LOWEST_SEED, problem, 0, 0) == -1);
+  assert(wfc_race_solve(&tiles, lanes, 4, WFC_RACE_FIRST, problem, 0, 0) == -1);
+  assert(lanes[0].attempts + lanes[1].attempts + lanes[2].attempts + lanes[3].attempts == 1);
+  assert(wfc_race_solve(&tiles, lanes, 0, WFC_RACE_FIRST, 1, 10, 0) == -1);
+
+  printf("[wfc] %-44s p50 %8.3f ms, p99 %8.3f ms\n", "wfc_race_serial_retry_loop_24x24", wfc_test_percentile(latencies[0], 200, 50), wfc_test_percentile(latencies[0], 200, 99));
+  printf("[wfc] %-44s p50 %8.3f ms, p99 %8.3f ms (%u cancelled)\n", "wfc_race_lowest_seed_4_lanes_24x24", wfc_test_percentile(latencies[1], 200, 50), wfc_test_percentile(latencies[1], 200, 99), cancelled);
+  printf("[wfc] %-44s p50 %8.3f ms, p99 %8.3f ms\n", "wfc_race_first_4_lanes_24x24", wfc_test_percentile(latencies[2], 200, 50), wfc_test_percentile(latencies[2], 200, 99));
+
+  for (i = 0; i < 3; ++i)
+  {
+    free(latencies[i]);
+  }
+
+  free(grid_memory);
+  free(tiles_memory);
+}
+
+/* Returns 1 if the tiles of every pair of adjacent loaded cells in the window around the viewer fit together */
+static int wfc_test_world_is_consistent(wfc_world *world, wfc_tiles *tiles)
+{
+  int radius = (int)world->radius;
+  int min_x = (world->viewer_x - radius) * (int)world->chunk_cols;
+  int min_y = (world->viewer_y - radius) * (int)world->chunk_rows;
+  int max_x = (world->viewer_x + radius + 1) * (int)world->chunk_cols;
+  int max_y = (world->viewer_y + radius + 1) * (int)world->chunk_rows;
+  unsigned int words = tiles->tile_direction_compatible_masks_words;
+  int x, y;
+
+  for (y = min_y; y < max_y; ++y)
+  {
+    for (x = min_x; x < max_x; ++x)
+    {
+      unsigned int tile = wfc_world_tile_at(world, x, y);
+      unsigned int d;
+
+      if (tile == WFC_CELL_NONE)
+      {
+        return 0;
+      }
+
+      for (d = 0; d < 4; ++d)
+      {
+        unsigned int neighbour = wfc_world_tile_at(world, x + wfc_direction_dx[d * 2], y + wfc_direction_dy[d * 2]);
+
+        if (neighbour != WFC_CELL_NONE && !(tiles->tile_direction_compatible_masks[(tile * 4 + d) * words + neighbour / 32] & (1u << (neighbour % 32))))
+        {
+          return 0;
+        }
+      }
+    }
+  }
+
+  return 1;
+}
+
+static void wfc_test_world(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned char *world_memory;
+  unsigned int world_memory_size;
+  unsigned int generated = 0;
+  unsigned int step;
+  int consistent = 1;
+  double time_start;
+  double time;
+
+  wfc_tiles tiles = {0};
+  wfc_world world = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+
+  /* A fixed tile outside the grid restricts the border cell next to it */
+  {
+    wfc_grid grid = {0};
+    unsigned int grid_memory_size;
+    unsigned int cell_tile;
+    unsigned int count;
+
+    grid.cols = 8;
+    grid.rows = 8;
+    grid.selection = WFC_SELECTION_MIN_HEAP;
+    grid.propagation = WFC_PROPAGATION_WORKLIST;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    grid_memory = malloc(grid_memory_size);
+
+    wfc_seed_lcg = 7;
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+    /* Tile 1 above cell 3 */
+    count = wfc_grid_constrain_neighbour_tile(&grid, &tiles, 3, 0, 1);
+    assert(count > 0 && count < tiles.tile_count);
+    assert(grid.cell_entropy_count[3] == count);
+    assert(wfc(&grid, &tiles));
+    assert(wfc_test_grid_is_solved(&grid, &tiles));
+
+    cell_tile = wfc_grid_find_nth_tile_in_mask(&grid, 3, 0);
+    assert((tiles.tile_direction_compatible_masks[(1 * 4 + 2) * tiles.tile_direction_compatible_masks_words] & (1u << cell_tile)) != 0);
+
+    free(grid_memory);
+  }
+
+  world.chunk_rows = 16;
+  world.chunk_cols = 16;
+  world.radius = 2;
+  world.seed = 1337;
+  world.retries_max = 10;
+  world.grid.selection = WFC_SELECTION_MIN_HEAP;
+  world.grid.propagation = WFC_PROPAGATION_WORKLIST;
+  world.grid.trail_capacity = 4096; /* Dense borders contradict often, backtracking keeps the restarts rare */
+  world.grid.backtrack_budget = 256;
+
+  world_memory_size = wfc_world_memory_size(&world, &tiles);
+  world_memory = malloc(world_memory_size);
+  assert(!wfc_world_initialize(&world, &tiles, world_memory, world_memory_size - 1));
+  assert(wfc_world_initialize(&world, &tiles, world_memory, world_memory_size));
+  assert(world.chunk_count == 25);
+
+  /* The viewer walks a square around the origin through negative coordinates, far beyond the window */
+  time_start = perf_platform_current_time_nanoseconds();
+
+  for (step = 0; step < 256; ++step)
+  {
+    int leg = (int)(step / 64);
+    int along = (int)(step % 64) * 12;
+    int x = leg == 0 ? along : (leg == 1 ? 768 : (leg == 2 ? 768 - along : 0));
+    int y = leg == 0 ? 0 : (leg == 1 ? -along : (leg == 2 ? -768 : -768 + along));
+
+    generated += wfc_world_update(&world, &tiles, x, y);
+
+    if (step % 16 == 0)
+    {
+      consistent &= wfc_test_world_is_consistent(&world, &tiles);
+    }
+  }
+
+  time = perf_platform_current_time_nanoseconds() - time_start;
+
+  assert(consistent);
+  assert(world.chunks_failed == 0);
+  assert(world.chunks_generated == generated);
+  assert(world.chunks_generated - world.chunks_evicted <= world.chunk_count);
+  assert(world.viewer_x == 0 && world.viewer_y == wfc_world_floor_div(-768 + 63 * 12, 16));
+  assert(wfc_test_world_is_consistent(&world, &tiles));
+
+  /* Only the window stays loaded */
+  assert(wfc_world_chunk_at(&world, world.viewer_x + 3, world.viewer_y) == 0);
+  assert(wfc_world_tile_at(&world, 768, -768) == WFC_CELL_NONE);
+  assert(wfc_world_floor_div(-1, 16) == -1 && wfc_world_floor_div(-16, 16) == -1 && wfc_world_floor_div(-17, 16) == -2);
+
+  printf("[wfc] %-44s %10.0f chunks/sec (%u chunks, %u attempts)\n", "wfc_world_16x16_chunks_radius_2", world.chunks_generated / (time / 1000000000.0), world.chunks_generated, world.attempts);
+  printf("[wfc] %-44s %10u bytes\n", "wfc_world_16x16_chunks_radius_2_memory", world_memory_size);
+
+  free(world_memory);
+  free(tiles_memory);
+}
+
+/* Solves a size x size grid on thread_count threads, prints the time and seam failures and returns the grid hash */
+static unsigned int wfc_test_benchmark_parallel(wfc_tiles *tiles, unsigned int size, unsigned int thread_count, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned char *parallel_memory;
+  unsigned int grid_memory_size;
+  unsigned int parallel_memory_size;
+  unsigned int hash;
+  double time_start;
+  double time;
+
+  wfc_grid grid = {0};
+  wfc_parallel parallel = {0};
+
+  grid.cols = size;
+  grid.rows = size;
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+  assert(wfc_grid_initialize(&grid, tiles, grid_memory, grid_memory_size));
+
+  parallel.block_rows = 128;
+  parallel.block_cols = 128;
+  parallel.seam = 4;
+  parallel.thread_count = thread_count;
+  parallel.seed = 1337;
+  parallel.retries_max = 4;
+  parallel.repairs_max = 3;
+  parallel.repair_margin = 8;
+  parallel.grid.selection = WFC_SELECTION_MIN_HEAP;
+  parallel.grid.propagation = WFC_PROPAGATION_WORKLIST;
+  parallel.grid.trail_capacity = 4096;
+  parallel.grid.backtrack_budget = 256;
+
+  parallel_memory_size = wfc_parallel_memory_size(&parallel, tiles);
+  parallel_memory = malloc(parallel_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  assert(wfc_parallel_solve(&parallel, &grid, tiles, parallel_memory, parallel_memory_size));
+  time = perf_platform_current_time_nanoseconds() - time_start;
+
+  assert(wfc_test_grid_is_solved(&grid, tiles));
+  assert(parallel.block_count == 8 * 8 && parallel.seam_count == 7 * 8 + 8 * 7 + 7 * 7);
+  hash = wfc_test_grid_hash(&grid);
+
+  printf("[wfc] %-44s %10.3f ms, %u/%u seams failed (%.1f%%), %u repairs\n", name, time / 1000000.0, parallel.seam_failures, parallel.seam_count,
+         100.0 * parallel.seam_failures / parallel.seam_count, parallel.repairs);
+
+  free(parallel_memory);
+  free(grid_memory);
+
+  return hash;
+}
+
+static void wfc_test_parallel(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned char *parallel_memory;
+  unsigned int grid_memory_size;
+  unsigned int parallel_memory_size;
+  unsigned int hash;
+  unsigned int tile;
+  unsigned int repairs_failed = 0;
+  unsigned int stale_collapsed = 0;
+  unsigned int i;
+  int solved;
+  double time_start;
+
+  unsigned char *simple_tiles_memory;
+  wfc_tiles tiles = {0};
+  wfc_tiles simple_tiles = {0};
+  wfc_grid grid = {0};
+  wfc_parallel parallel = {0};
+
+  /* The T tiles of the simple set can not fill most regions fixed on all sides, these random tiles can */
+  wfc_test_setup_random_tiles(&tiles, &tiles_memory, 32, 4, 1, 3, 42);
+
+  /* Partial blocks and seams at the right and bottom border, the result does not depend on the thread count */
+  grid.cols = 100;
+  grid.rows = 70;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+  assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+  parallel.block_rows = 16;
+  parallel.block_cols = 24;
+  parallel.seam = 2;
+  parallel.thread_count = 3;
+  parallel.seed = 42;
+  parallel.retries_max = 4;
+  parallel.repairs_max = 3;
+  parallel.repair_margin = 4;
+  parallel.grid.selection = WFC_SELECTION_MIN_HEAP;
+  parallel.grid.propagation = WFC_PROPAGATION_WORKLIST;
+  parallel.grid.trail_capacity = 1024;
+  parallel.grid.backtrack_budget = 64;
+
+  parallel_memory_size = wfc_parallel_memory_size(&parallel, &tiles);
+  parallel_memory = malloc(parallel_memory_size);
+
+  assert(!wfc_parallel_solve(&parallel, &grid, &tiles, parallel_memory, parallel_memory_size - 1));
+  assert(wfc_parallel_solve(&parallel, &grid, &tiles, parallel_memory, parallel_memory_size));
+  assert(wfc_test_grid_is_solved(&grid, &tiles));
+  assert(grid.cells_processed == 100 * 70);
+  assert(parallel.block_count == 4 * 4 && parallel.seam_count == 3 * 4 + 4 * 3 + 3 * 3);
+  assert(parallel.repairs_failed == 0);
+  hash = wfc_test_grid_hash(&grid);
+
+  parallel.thread_count = 1;
+  assert(wfc_parallel_solve(&parallel, &grid, &tiles, parallel_memory, parallel_memory_size));
+  assert(wfc_test_grid_hash(&grid) == hash);
+
+  /* Without retries and backtracking more seams fail, every failed region gets repaired locally and the grid is
+     only reported solved if the repairs succeeded */
+  parallel.retries_max = 0;
+  parallel.grid.trail_capacity = 0;
+  solved = wfc_parallel_solve(&parallel, &grid, &tiles, parallel_memory, parallel_memory_size);
+  assert(parallel.seam_failures > 0 && parallel.repairs >= parallel.seam_failures + parallel.block_failures);
+  assert(solved == (parallel.repairs_failed == 0));
+  assert(solved == wfc_test_grid_is_solved(&grid, &tiles));
+
+  /* Failed repairs leave the grid as it was. The T tiles of the simple set fail most seams, and every mask of the
+     reused grid holds a tile that does not fit itself vertically: none of them may count as collapsed unless a
+     region of this solve wrote it */
+  wfc_test_setup_simple_tiles(&simple_tiles, &simple_tiles_memory);
+  assert(wfc_grid_initialize(&grid, &simple_tiles, grid_memory, grid_memory_size));
+
+  for (tile = 0; wfc_tiles_is_compatible_tile(&simple_tiles, tile, 0, tile); ++tile)
+  {
+  }
+
+  parallel.repairs_max = 1;
+  parallel.repair_margin = 1;
+
+  for (parallel.seed = 0; parallel.seed < 8; ++parallel.seed)
+  {
+    for (i = 0; i < 100 * 70; ++i)
+    {
+      wfc_grid_set_cell_tile(&grid, i, tile);
+    }
+
+    solved = wfc_parallel_solve(&parallel, &grid, &simple_tiles, parallel_memory, parallel_memory_size);
+    assert(solved == (parallel.repairs_failed == 0));
+    repairs_failed += parallel.repairs_failed;
+
+    for (i = 0; i < 100 * 70; ++i)
+    {
+      unsigned int d;
+
+      for (d = 0; d < 4; ++d)
+      {
+        int neighbour_index = wfc_grid_neighbour_index(&grid, (int)i, d, 4);
+
+        stale_collapsed += grid.cell_collapsed[i] && neighbour_index >= 0 && grid.cell_collapsed[neighbour_index] &&
+                           !wfc_tiles_is_compatible_tile(&simple_tiles, wfc_grid_find_nth_tile_in_mask(&grid, i, 0), d, wfc_grid_find_nth_tile_in_mask(&grid, (unsigned int)neighbour_index, 0));
+      }
+    }
+  }
+
+  assert(repairs_failed > 0);
+  assert(stale_collapsed == 0);
+
+  free(parallel_memory);
+  free(grid_memory);
+
+  /* Scaling across thread counts against the serial solve of the same grid */
+  grid.cols = 1024;
+  grid.rows = 1024;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = WFC_PROPAGATION_WORKLIST;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+  time_start = perf_platform_current_time_nanoseconds();
+  assert(wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 1337) == 0);
+  printf("[wfc] %-44s %10.3f ms\n", "wfc_parallel_serial_1024x1024", (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0);
+  free(grid_memory);
+
+  hash = wfc_test_benchmark_parallel(&tiles, 1024, 1, "wfc_parallel_1_thread_1024x1024");
+  assert(wfc_test_benchmark_parallel(&tiles, 1024, 2, "wfc_parallel_2_threads_1024x1024") == hash);
+  assert(wfc_test_benchmark_parallel(&tiles, 1024, 4, "wfc_parallel_4_threads_1024x1024") == hash);
+
+  free(simple_tiles_memory);
+  free(tiles_memory);
+}
+
+/* Hash of the cells of a solved grid outside the rectangle */
+static unsigned int wfc_test_grid_hash_outside(wfc_grid *grid, unsigned int row, unsigned int col, unsigned int rows, unsigned int cols)
+{
+  unsigned int hash = 2166136261U;
+  unsigned int x, y;
+
+  for (y = 0; y < grid->rows; ++y)
+  {
+    for (x = 0; x < grid->cols; ++x)
+    {
+      if (y < row || y >= row + rows || x < col || x >= col + cols)
+      {
+        hash = (hash ^ wfc_grid_find_nth_tile_in_mask(grid, y * grid->cols + x, 0)) * 16777619U;
+      }
+    }
+  }
+
+  return hash;
+}
+
+/* Solves a size x size grid, then re-solves edits 32x32 regions of it and prints both times */
+static void wfc_test_benchmark_region(wfc_tiles *tiles, unsigned int size, unsigned int edits, char *name_solve, char *name_edit)
+{
+  unsigned char *grid_memory;
+  unsigned char *region_memory;
+  unsigned int grid_memory_size;
+  unsigned int region_memory_size;
+  unsigned int retries = 0;
+  unsigned int i;
+  double time_start;
+  double time_solve;
+  double time_edit;
+  wfc_rng rng;
+
+  wfc_grid grid = {0};
+  wfc_grid region = {0};
+
+  grid.cols = size;
+  grid.rows = size;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = WFC_PROPAGATION_WORKLIST;
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  region.cols = 32;
+  region.rows = 32;
+  region.selection = WFC_SELECTION_MIN_HEAP;
+  region.propagation = WFC_PROPAGATION_WORKLIST;
+  region.rng = &rng;
+  region_memory_size = wfc_grid_memory_size(&region, tiles);
+  region_memory = malloc(region_memory_size);
+
+  time_start = perf_platform_current_time_nanoseconds();
+  assert(wfc_test_solve(&grid, tiles, grid_memory, grid_memory_size, 1337) == 0);
+  time_solve = perf_platform_current_time_nanoseconds() - time_start;
+
+  time_start = perf_platform_current_time_nanoseconds();
+
+  for (i = 0; i < edits; ++i)
+  {
+    unsigned int row = (i * 7919u) % (size - 32);
+    unsigned int col = (i * 104729u) % (size - 32);
+    int status = 0;
+
+    while (status == 0)
+    {
+      wfc_rng_seed(&rng, i * 1000 + retries);
+      status = wfc_grid_solve_region(&grid, tiles, row, col, 32, 32, 0, &region, region_memory, region_memory_size);
+      retries += status == 0 ? 1u : 0u;
+    }
+
+    assert(status == 1);
+  }
+
+  time_edit = perf_platform_current_time_nanoseconds() - time_start;
+
+  assert(wfc_test_grid_is_solved(&grid, tiles));
+
+  printf("[wfc] %-44s %10.3f ms\n", name_solve, time_solve / 1000000.0);
+  printf("[wfc] %-44s %10.3f ms/edit (%u retries in %u edits)\n", name_edit, time_edit / 1000000.0 / edits, retries, edits);
+
+  free(region_memory);
+  free(grid_memory);
+}
+
+static void wfc_test_region(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned char *region_memory;
+  unsigned int grid_memory_size;
+  unsigned int region_memory_size;
+  unsigned int hash_outside;
+  unsigned int hash;
+  unsigned char mask[12 * 16];
+  unsigned int kept[12 * 16];
+  unsigned int i;
+  int changed = 0;
+  int status;
+  wfc_rng rng;
+
+  wfc_tiles tiles = {0};
+  wfc_grid grid = {0};
+  wfc_grid region = {0};
+
+  /* Random tiles, the T tiles of the simple set can not fill most regions fixed on all sides */
+  wfc_test_setup_random_tiles(&tiles, &tiles_memory, 32, 4, 1, 3, 42);
+
+  grid.cols = 64;
+  grid.rows = 64;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = WFC_PROPAGATION_WORKLIST;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+  wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 1);
+  hash = wfc_test_grid_hash(&grid);
+
+  region.cols = 16;
+  region.rows = 12;
+  region.selection = WFC_SELECTION_MIN_HEAP;
+  region.propagation = WFC_PROPAGATION_SUPPORT;
+  region.rng = &rng;
+  region_memory_size = wfc_grid_memory_size(&region, &tiles);
+  region_memory = malloc(region_memory_size);
+
+  /* Out of the grid or a region memory too small for the rectangle */
+  assert(wfc_grid_solve_region(&grid, &tiles, 60, 10, 12, 16, 0, &region, region_memory, region_memory_size) == -1);
+  assert(wfc_grid_solve_region(&grid, &tiles, 10, 10, 16, 16, 0, &region, region_memory, region_memory_size) == -1);
+
+  /* The rectangle changes, everything around it stays and still fits */
+  hash_outside = wfc_test_grid_hash_outside(&grid, 20, 30, 12, 16);
+
+  for (i = 1, status = 0; status != 1; ++i)
+  {
+    wfc_rng_seed(&rng, i);
+    status = wfc_grid_solve_region(&grid, &tiles, 20, 30, 12, 16, 0, &region, region_memory, region_memory_size);
+    assert(status >= 0);
+  }
+
+  assert(wfc_test_grid_is_solved(&grid, &tiles));
+  assert(wfc_test_grid_hash_outside(&grid, 20, 30, 12, 16) == hash_outside);
+  assert(wfc_test_grid_hash(&grid) != hash);
+
+  /* At the grid border, only the collapsed side constrains */
+  wfc_rng_seed(&rng, 7);
+  assert(wfc_grid_solve_region(&grid, &tiles, 0, 48, 12, 16, 0, &region, region_memory, region_memory_size) >= 0);
+  assert(wfc_test_grid_is_solved(&grid, &tiles));
+
+  /* A masked region keeps the cells outside the mask, here everything but a diamond */
+  for (i = 0; i < 12 * 16; ++i)
+  {
+    int dx = (int)(i % 16) - 8;
+    int dy = (int)(i / 16) - 6;
+
+    mask[i] = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy) < 6;
+    kept[i] = wfc_grid_find_nth_tile_in_mask(&grid, (40 + i / 16) * 64 + 8 + i % 16, 0);
+  }
+
+  for (i = 1, status = 0; status != 1; ++i)
+  {
+    wfc_rng_seed(&rng, i);
+    status = wfc_grid_solve_region(&grid, &tiles, 40, 8, 12, 16, mask, &region, region_memory, region_memory_size);
+    assert(status >= 0);
+  }
+
+  assert(wfc_test_grid_is_solved(&grid, &tiles));
+
+  for (i = 0; i < 12 * 16; ++i)
+  {
+    unsigned int tile = wfc_grid_find_nth_tile_in_mask(&grid, (40 + i / 16) * 64 + 8 + i % 16, 0);
+
+    assert(mask[i] || tile == kept[i]);
+    changed |= tile != kept[i];
+  }
+
+  assert(changed);
+
+  free(region_memory);
+  free(grid_memory);
+
+  /* The cost of an edit depends on its size, not on the grid size */
+  wfc_test_benchmark_region(&tiles, 256, 100, "wfc_region_solve_256x256", "wfc_region_edit_32x32_in_256x256");
+  wfc_test_benchmark_region(&tiles, 2048, 100, "wfc_region_solve_2048x2048", "wfc_region_edit_32x32_in_2048x2048");
+
+  free(tiles_memory);
+}
+
+/* Solves a grid with count pinned cells, pinned again on every restart. With poke the pins are written into the
+   masks by hand, otherwise they go through wfc_grid_pin_tile() and wfc_grid_propagate_constraints().
+   Returns the number of restarts, retries_max + 1 if no attempt succeeded */
+static unsigned int wfc_test_solve_pinned(wfc_grid *grid, wfc_tiles *tiles, unsigned char *grid_memory, unsigned int grid_memory_size, unsigned int seed,
+                                          unsigned int *pin_cells, unsigned int *pin_tiles, unsigned int pin_count, int poke, unsigned int retries_max)
+{
+  unsigned int retries;
+
+  for (retries = 0; retries <= retries_max; ++retries)
+  {
+    unsigned int i;
+    int pinned = 1;
+
+    wfc_seed_lcg = seed + retries;
+    assert(wfc_grid_initialize(grid, tiles, grid_memory, grid_memory_size));
+
+    for (i = 0; i < pin_count; ++i)
+    {
+      if (poke)
+      {
+        grid->cell_entropy_masks[pin_cells[i]] = 1u << pin_tiles[i];
+      }
+      else
+      {
+        pinned &= wfc_grid_pin_tile(grid, pin_cells[i], pin_tiles[i]) == 1;
+      }
+    }
+
+    assert(pinned);
+
+    if ((poke || wfc_grid_propagate_constraints(grid, tiles)) && wfc(grid, tiles))
+    {
+      break;
+    }
+  }
+
+  return retries;
+}
+
+static void wfc_test_pinned_cells(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int pin_cells[256];
+  unsigned int pin_tiles[256];
+  unsigned int solution[48 * 48];
+  unsigned int pin_count = 0;
+  unsigned int words;
+  unsigned int a, b, c;
+  unsigned int pair_mask, pair_supported = 0;
+  unsigned int i, mode;
+
+  wfc_tiles tiles = {0};
+  wfc_grid grid = {0};
+
+  wfc_test_setup_simple_tiles(&tiles, &tiles_memory);
+  words = tiles.tile_direction_compatible_masks_words;
+
+  grid.cols = 48;
+  grid.rows = 48;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = WFC_PROPAGATION_SUPPORT; /* The largest of the three */
+  grid_memory = malloc(wfc_grid_memory_size(&grid, &tiles));
+  grid.propagation = WFC_PROPAGATION_WORKLIST;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+
+  /* The pins are taken from a solved grid, so they can always be met together */
+  wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 1);
+
+  for (i = 0; i < 48 * 48; ++i)
+  {
+    solution[i] = wfc_grid_find_nth_tile_in_mask(&grid, i, 0);
+
+    if (pin_count < 256 && (i * 2654435761u) % 9 == 0)
+    {
+      pin_cells[pin_count] = i;
+      pin_tiles[pin_count] = solution[i];
+      pin_count++;
+    }
+  }
+
+  /* Two tiles that can not be right of each other */
+  for (a = 0, b = 0; (tiles.tile_direction_compatible_masks[(a * 4 + 1) * words] >> b) & 1u; b = (b + 1) % 5, a += b == 0 ? 1u : 0u)
+  {
+  }
+
+  /* A second tile for cell 49 whose right hand neighbours together with those of the solution still leave one out */
+  for (c = 0; c < tiles.tile_count; ++c)
+  {
+    pair_supported = tiles.tile_direction_compatible_masks[(solution[49] * 4 + 1) * words] | tiles.tile_direction_compatible_masks[(c * 4 + 1) * words];
+
+    if (c != solution[49] && wfc_popcount(pair_supported) < tiles.tile_count)
+    {
+      break;
+    }
+  }
+
+  assert(c < tiles.tile_count);
+  pair_mask = (1u << solution[49]) | (1u << c);
+
+  for (mode = 0; mode < 3; ++mode)
+  {
+    grid.propagation = mode;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+    /* A pin leaves a single tile, the neighbours follow after the propagation */
+    assert(wfc_grid_pin_tile(&grid, 49, solution[49]) == 1);
+    assert(grid.cell_entropy_count[49] == 1);
+    assert(wfc_grid_pin_tile(&grid, 49, (solution[49] + 1) % 5) == 0);
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(wfc_grid_pin_tile(&grid, 49, solution[49]) == 1);
+    assert(wfc_grid_propagate_constraints(&grid, &tiles));
+    assert(grid.cell_entropy_count[50] == wfc_popcount(tiles.tile_direction_compatible_masks[(solution[49] * 4 + 1) * words]));
+    assert(!grid.cell_collapsed[50] && !grid.cell_collapsed[49]);
+
+    /* The restriction of cell 50 carries on to cell 51 */
+    assert(!(grid.cell_entropy_masks[51] & ~wfc_grid_supported_word(&grid, &tiles, 50, 1, 0)));
+    assert(wfc(&grid, &tiles) || mode == WFC_PROPAGATION_NEIGHBOURS);
+
+    /* A restriction to several tiles is propagated as well */
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(wfc_grid_constrain(&grid, 49, &pair_mask) == 2);
+    assert(wfc_grid_propagate_constraints(&grid, &tiles));
+    assert(grid.cell_entropy_count[50] == wfc_popcount(pair_supported));
+
+    /* Pins that contradict each other are found before solving */
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(wfc_grid_pin_tile(&grid, 100, a) == 1 && wfc_grid_pin_tile(&grid, 101, b) == 1);
+    assert(!wfc_grid_propagate_constraints(&grid, &tiles));
+  }
+
+  /* Restarts of a map with every ninth cell pinned */
+  for (mode = 0; mode < 4; ++mode)
+  {
+    static char *names[4] = {"wfc_pinned_poked_neighbours_48x48", "wfc_pinned_batched_neighbours_48x48", "wfc_pinned_poked_worklist_48x48", "wfc_pinned_batched_worklist_48x48"};
+    unsigned int retries = 0;
+    unsigned int solved = 0;
+    unsigned int seed;
+
+    grid.propagation = mode >= 2 ? WFC_PROPAGATION_WORKLIST : WFC_PROPAGATION_NEIGHBOURS;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+
+    for (seed = 1; seed <= 10; ++seed)
+    {
+      unsigned int grid_retries = wfc_test_solve_pinned(&grid, &tiles, grid_memory, grid_memory_size, seed * 1000, pin_cells, pin_tiles, pin_count, mode % 2 == 0, 99);
+
+      if (grid_retries < 100)
+      {
+        solved++;
+
+        for (i = 0; i < pin_count; ++i)
+        {
+          assert(wfc_grid_find_nth_tile_in_mask(&grid, pin_cells[i], 0) == pin_tiles[i]);
+        }
+
+        assert(wfc_test_grid_is_solved(&grid, &tiles));
+      }
+
+      retries += grid_retries;
+    }
+
+    printf("[wfc] %-44s %5u/10 solved, %8.2f retries/grid (%u pins)\n", names[mode], solved, retries / 10.0, pin_count);
+  }
+
+  free(grid_memory);
+  free(tiles_memory);
+}
+
+/* Builds the 2^direction_count tiles with every combination of 2 socket values on their sides. Every set of
+   neighbours leaves at least one tile, so grids of any topology never run into contradictions */
+static void wfc_test_setup_complete_tiles(wfc_tiles *tiles, unsigned char **tiles_memory, unsigned int direction_count, unsigned int topology)
+{
+  wfc_socket_8x07 socket_buffer[8];
+  unsigned int tiles_memory_size;
+  unsigned int i, d;
+
+  tiles->tile_capacity = 1u << direction_count;
+  tiles->tile_direction_count = direction_count;
+  tiles->tile_direction_socket_count = 1;
+  tiles->tile_topology = topology;
+
+  tiles_memory_size = WFC_TILES_MEMORY_SIZE(tiles->tile_capacity, tiles->tile_direction_count);
+  *tiles_memory = malloc(tiles_memory_size);
+
+  assert(wfc_tiles_initialize(tiles, *tiles_memory, tiles_memory_size));
+
+  for (i = 0; i < tiles->tile_capacity; ++i)
+  {
+    for (d = 0; d < direction_count; ++d)
+    {
+      socket_buffer[d] = wfc_socket_pack(0, 0, (i >> d) & 1u);
+    }
+
+    assert(wfc_tiles_add_tile(tiles, i, socket_buffer, 0));
+  }
+
+  assert(wfc_tiles_compute_compatible_tiles(tiles));
+}
+
+/* Returns 1 if every cell is collapsed to a tile compatible with all of its neighbours, for any topology */
+static int wfc_test_grid_is_solved_all(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int i, d;
+
+  for (i = 0; i < wfc_grid_cell_count(grid); ++i)
+  {
+    if (!grid->cell_collapsed[i] || grid->cell_entropy_count[i] != 1)
+    {
+      return 0;
+    }
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      int neighbour = wfc_grid_neighbour_index(grid, (int)i, d, dir_count);
+
+      if (neighbour >= 0 && !wfc_tiles_is_compatible_tile(tiles, wfc_grid_find_nth_tile_in_mask(grid, i, 0), d,
+                                                          wfc_grid_find_nth_tile_in_mask(grid, (unsigned int)neighbour, 0)))
+      {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* Solves a size^3 voxel grid and prints the time and throughput */
+static void wfc_test_benchmark_voxel(wfc_tiles *tiles, unsigned int size, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.layers = size;
+  grid.topology = WFC_TOPOLOGY_CUBE;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  wfc_seed_lcg = 1337;
+  assert(wfc_grid_initialize(&grid, tiles, grid_memory, grid_memory_size));
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ assert(wfc(&grid, tiles)); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved_all(&grid, tiles));
+
+  printf("[wfc] %-44s %10.3f ms %10.0f cells/sec\n", name, time_ms, (double)wfc_grid_cell_count(&grid) / (time_ms / 1000.0));
+
+  free(grid_memory);
+}
+
+static void wfc_test_voxel_grids(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int i, d;
+  unsigned int a, b;
+
+  wfc_tiles tiles = {0};
+  wfc_grid grid = {0};
+
+  /* Cube tiles rotate within their layer, above and below keep their sockets */
+  {
+    unsigned char *rotated_memory;
+    wfc_socket_8x07 socket_buffer[6];
+    wfc_tiles rotated = {0};
+    static const unsigned int expected[4][6] = {{1, 2, 3, 4, 5, 6}, {5, 1, 3, 2, 4, 6}, {4, 5, 3, 1, 2, 6}, {2, 4, 3, 5, 1, 6}};
+
+    rotated.tile_capacity = 4;
+    rotated.tile_direction_count = 6;
+    rotated.tile_direction_socket_count = 1;
+    rotated.tile_topology = WFC_TOPOLOGY_CUBE;
+    rotated_memory = malloc(WFC_TILES_MEMORY_SIZE(rotated.tile_capacity, rotated.tile_direction_count));
+    assert(wfc_tiles_initialize(&rotated, rotated_memory, WFC_TILES_MEMORY_SIZE(rotated.tile_capacity, rotated.tile_direction_count)));
+
+    for (d = 0; d < 6; ++d)
+    {
+      socket_buffer[d] = wfc_socket_pack(0, 0, d + 1);
+    }
+
+    assert(wfc_tiles_add_tile(&rotated, 0, socket_buffer, 3));
+    assert(rotated.tile_count == 4);
+
+    for (i = 0; i < 4; ++i)
+    {
+      for (d = 0; d < 6; ++d)
+      {
+        assert(wfc_socket_unpack(rotated.tile_direction_sockets[i * 6 + d], 0) == expected[i][d]);
+      }
+    }
+
+    free(rotated_memory);
+  }
+
+  wfc_test_setup_complete_tiles(&tiles, &tiles_memory, 6, WFC_TOPOLOGY_CUBE);
+
+  /* The opposite of d is (d + 3) % 6, so a faces b in d exactly when their sockets on the shared face match */
+  for (a = 0; a < 64; ++a)
+  {
+    for (b = 0; b < 64; ++b)
+    {
+      for (d = 0; d < 6; ++d)
+      {
+        assert(wfc_tiles_is_compatible_tile(&tiles, a, d, b) == (((a >> d) & 1u) == ((b >> ((d + 3) % 6)) & 1u)));
+      }
+    }
+  }
+
+  grid.cols = 8;
+  grid.rows = 12;
+  grid.layers = 16;
+  grid.topology = WFC_TOPOLOGY_CUBE;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid.propagation = WFC_PROPAGATION_NEIGHBOURS;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+  assert(wfc_grid_cell_count(&grid) == 8 * 12 * 16);
+
+  /* Every cell has its own index, and its neighbours are the cells next to its coordinates */
+  for (i = 0; i < wfc_grid_cell_count(&grid); ++i)
+  {
+    unsigned int x, y, z;
+
+    wfc_grid_cell_coords(&grid, i, &x, &y, &z);
+    assert(x < 8 && y < 12 && z < 16);
+    assert(wfc_grid_cell_index(&grid, x, y, z) == i);
+
+    for (d = 0; d < 6; ++d)
+    {
+      int expected = -1;
+      int nx = (int)x + wfc_cube_dx[d];
+      int ny = (int)y + wfc_cube_dy[d];
+      int nz = (int)z + wfc_cube_dz[d];
+
+      if (nx >= 0 && ny >= 0 && nz >= 0 && nx < 8 && ny < 12 && nz < 16)
+      {
+        expected = (int)wfc_grid_cell_index(&grid, (unsigned int)nx, (unsigned int)ny, (unsigned int)nz);
+      }
+
+      assert(wfc_grid_neighbour_index(&grid, (int)i, d, 6) == expected);
+    }
+  }
+
+  /* The cell above is a whole layer away */
+  assert(wfc_grid_cell_index(&grid, 1, 1, 1) - wfc_grid_cell_index(&grid, 1, 1, 0) == 8u * 12u);
+
+  wfc_seed_lcg = 7;
+  assert(wfc(&grid, &tiles));
+  assert(wfc_test_grid_is_solved_all(&grid, &tiles));
+
+  free(grid_memory);
+
+  /* The worklist and support propagations solve cube grids as well */
+  for (i = WFC_PROPAGATION_WORKLIST; i <= WFC_PROPAGATION_SUPPORT; ++i)
+  {
+    grid.propagation = i;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    grid_memory = malloc(grid_memory_size);
+
+    wfc_seed_lcg = 11;
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    assert(wfc(&grid, &tiles));
+    assert(wfc_test_grid_is_solved_all(&grid, &tiles));
+
+    free(grid_memory);
+  }
+
+  /* Cube grids need cube tiles */
+  grid.propagation = WFC_PROPAGATION_NEIGHBOURS;
+
+  {
+    unsigned char *square_memory;
+    wfc_tiles square = {0};
+
+    wfc_test_setup_simple_tiles(&square, &square_memory);
+    grid_memory_size = wfc_grid_memory_size(&grid, &square);
+    grid_memory = malloc(grid_memory_size);
+    assert(!wfc_grid_initialize(&grid, &square, grid_memory, grid_memory_size));
+    free(grid_memory);
+    free(square_memory);
+  }
+
+  wfc_test_benchmark_voxel(&tiles, 128, "wfc_voxel_128x128x128");
+
+  free(tiles_memory);
+}
+
+/* Solves a size x size grid of the complete tile set of the topology and prints the throughput */
+static void wfc_test_benchmark_topology(wfc_tiles *tiles, unsigned int topology, unsigned int size, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.topology = topology;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  wfc_seed_lcg = 1337;
+  assert(wfc_grid_initialize(&grid, tiles, grid_memory, grid_memory_size));
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ assert(wfc(&grid, tiles)); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved_all(&grid, tiles));
+
+  printf("[wfc] %-44s %10.3f ms %10.0f cells/sec\n", name, time_ms, (double)(size * size) / (time_ms / 1000.0));
+
+  free(grid_memory);
+}
+
+static void wfc_test_hex_grids(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *square_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int i, d;
+
+  wfc_tiles tiles = {0};
+  wfc_tiles square = {0};
+  wfc_grid grid = {0};
+
+  /* Axial (q, r) steps of the directions, up-right first. Offset (x, y) is axial (x - (y - (y & 1)) / 2, y) */
+  static const int axial_dq[6] = {1, 1, 0, -1, -1, 0};
+  static const int axial_dr[6] = {-1, 0, 1, 1, 0, -1};
+
+  /* Hex tiles rotate by 60 degrees per rotation */
+  {
+    unsigned char *rotated_memory;
+    wfc_socket_8x07 socket_buffer[6];
+    wfc_tiles rotated = {0};
+
+    rotated.tile_capacity = 6;
+    rotated.tile_direction_count = 6;
+    rotated.tile_direction_socket_count = 1;
+    rotated.tile_topology = WFC_TOPOLOGY_HEX;
+    rotated_memory = malloc(WFC_TILES_MEMORY_SIZE(rotated.tile_capacity, rotated.tile_direction_count));
+    assert(wfc_tiles_initialize(&rotated, rotated_memory, WFC_TILES_MEMORY_SIZE(rotated.tile_capacity, rotated.tile_direction_count)));
+
+    for (d = 0; d < 6; ++d)
+    {
+      socket_buffer[d] = wfc_socket_pack(0, 0, d + 1);
+    }
+
+    assert(wfc_tiles_add_tile(&rotated, 0, socket_buffer, 5));
+    assert(rotated.tile_count == 6);
+
+    for (i = 0; i < 6; ++i)
+    {
+      for (d = 0; d < 6; ++d)
+      {
+        assert(wfc_socket_unpack(rotated.tile_direction_sockets[i * 6 + d], 0) == (d + 6 - i) % 6 + 1);
+      }
+    }
+
+    /* Hex tiles need 6 directions */
+    rotated.tile_direction_count = 4;
+    assert(!wfc_tiles_add_tile(&rotated, 1, socket_buffer, 0));
+
+    free(rotated_memory);
+  }
+
+  wfc_test_setup_complete_tiles(&tiles, &tiles_memory, 6, WFC_TOPOLOGY_HEX);
+  wfc_test_setup_complete_tiles(&square, &square_memory, 4, WFC_TOPOLOGY_SQUARE);
+
+  grid.cols = 7;
+  grid.rows = 6;
+  grid.topology = WFC_TOPOLOGY_HEX;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  /* Hex grids need 6 direction tiles */
+  assert(!wfc_grid_initialize(&grid, &square, grid_memory, grid_memory_size));
+  assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+  /* The neighbours are one axial step away and lead back in the opposite direction */
+  for (i = 0; i < 7 * 6; ++i)
+  {
+    int x = (int)(i % 7);
+    int y = (int)(i / 7);
+
+    for (d = 0; d < 6; ++d)
+    {
+      int neighbour = wfc_grid_neighbour_index(&grid, (int)i, d, 6);
+      int q = x - (y - (y & 1)) / 2 + axial_dq[d];
+      int r = y + axial_dr[d];
+      int nx = q + (r - (r & 1)) / 2;
+      int expected = (nx >= 0 && r >= 0 && nx < 7 && r < 6) ? r * 7 + nx : -1;
+
+      assert(neighbour == expected);
+      assert(neighbour < 0 || wfc_grid_neighbour_index(&grid, neighbour, (d + 3) % 6, 6) == (int)i);
+    }
+  }
+
+  wfc_seed_lcg = 3;
+  assert(wfc(&grid, &tiles));
+  assert(wfc_test_grid_is_solved_all(&grid, &tiles));
+
+  free(grid_memory);
+
+  wfc_test_benchmark_topology(&square, WFC_TOPOLOGY_SQUARE, 512, "wfc_topology_square_512x512");
+  wfc_test_benchmark_topology(&tiles, WFC_TOPOLOGY_HEX, 512, "wfc_topology_hex_512x512");
+
+  free(square_memory);
+  free(tiles_memory);
+}
+
+/* Solves a size x size grid of the complete 4 direction tile set with the given boundary and prints the throughput */
+static void wfc_test_benchmark_boundary(wfc_tiles *tiles, unsigned int boundary, unsigned int size, char *name)
+{
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  double time_start;
+  double time_ms;
+
+  wfc_grid grid = {0};
+  grid.cols = size;
+  grid.rows = size;
+  grid.boundary = boundary;
+  grid.selection = WFC_SELECTION_MIN_HEAP;
+
+  grid_memory_size = wfc_grid_memory_size(&grid, tiles);
+  grid_memory = malloc(grid_memory_size);
+
+  wfc_seed_lcg = 1337;
+  assert(wfc_grid_initialize(&grid, tiles, grid_memory, grid_memory_size));
+
+  time_start = perf_platform_current_time_nanoseconds();
+  PERF_PROFILE_WITH_NAME({ assert(wfc(&grid, tiles)); }, name);
+  time_ms = (perf_platform_current_time_nanoseconds() - time_start) / 1000000.0;
+
+  assert(wfc_test_grid_is_solved_all(&grid, tiles));
+
+  printf("[wfc] %-44s %10.3f ms %10.0f cells/sec\n", name, time_ms, (double)(size * size) / (time_ms / 1000.0));
+
+  free(grid_memory);
+}
+
+static void wfc_test_periodic_grids(void)
+{
+  unsigned char *tiles_memory;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  unsigned int i, d, config;
+
+  wfc_tiles tiles_empty = {0};
+  wfc_tiles tiles = {0};
+  wfc_grid grid = {0};
+
+  /* Every neighbour wraps around to the opposite edge */
+  for (config = 0; config < 4; ++config)
+  {
+    static const unsigned int topologies[4] = {WFC_TOPOLOGY_SQUARE, WFC_TOPOLOGY_SQUARE, WFC_TOPOLOGY_HEX, WFC_TOPOLOGY_CUBE};
+    static const unsigned int direction_counts[4] = {4, 8, 6, 6};
+    unsigned int dir_count = direction_counts[config];
+
+    tiles = tiles_empty;
+    wfc_test_setup_complete_tiles(&tiles, &tiles_memory, dir_count, topologies[config]);
+
+    grid.cols = 8;
+    grid.rows = 6;
+    grid.layers = 4;
+    grid.topology = topologies[config];
+    grid.boundary = WFC_BOUNDARY_PERIODIC;
+    grid.selection = WFC_SELECTION_MIN_HEAP;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    grid_memory = malloc(grid_memory_size);
+
+    assert(wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+
+    for (i = 0; i < wfc_grid_cell_count(&grid); ++i)
+    {
+      unsigned int x, y, z;
+
+      wfc_grid_cell_coords(&grid, i, &x, &y, &z);
+
+      for (d = 0; d < dir_count; ++d)
+      {
+        int dx, dy, dz = 0;
+        unsigned int expected;
+
+        if (grid.topology == WFC_TOPOLOGY_SQUARE)
+        {
+          dx = wfc_direction_dx[dir_count == 8 ? d : d * 2];
+          dy = wfc_direction_dy[dir_count == 8 ? d : d * 2];
+        }
+        else if (grid.topology == WFC_TOPOLOGY_HEX)
+        {
+          dx = wfc_hex_dx[y & 1u][d];
+          dy = wfc_hex_dy[d];
+        }
+        else
+        {
+          dx = wfc_cube_dx[d];
+          dy = wfc_cube_dy[d];
+          dz = wfc_cube_dz[d];
+        }
+
+        expected = wfc_grid_cell_index(&grid, (unsigned int)((int)x + dx + (int)grid.cols) % grid.cols, (unsigned int)((int)y + dy + (int)grid.rows) % grid.rows,
+                                       (unsigned int)((int)z + dz + (int)wfc_grid_layer_count(&grid)) % wfc_grid_layer_count(&grid));
+
+        assert(wfc_grid_neighbour_index(&grid, (int)i, d, dir_count) == (int)expected);
+      }
+    }
+
+    wfc_seed_lcg = 5;
+    assert(wfc(&grid, &tiles));
+    assert(wfc_test_grid_is_solved_all(&grid, &tiles));
+
+    free(grid_memory);
+    free(tiles_memory);
+  }
+
+  /* The rows of hex grids only line up across the wrap for an even row count */
+  tiles = tiles_empty;
+  wfc_test_setup_complete_tiles(&tiles, &tiles_memory, 6, WFC_TOPOLOGY_HEX);
+  grid.rows = 7;
+  grid.topology = WFC_TOPOLOGY_HEX;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+  assert(!wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+  free(grid_memory);
+  free(tiles_memory);
+
+  /* A periodic axis of size 1 would make a cell its own neighbour, an axis of size 2 wraps onto the other cell */
+  tiles = tiles_empty;
+  wfc_test_setup_complete_tiles(&tiles, &tiles_memory, 4, WFC_TOPOLOGY_SQUARE);
+  grid.topology = WFC_TOPOLOGY_SQUARE;
+
+  for (config = 0; config < 4; ++config)
+  {
+    grid.cols = config == 1 ? 1 : 4;
+    grid.rows = config == 0 ? 1 : (config == 1 ? 4 : 2);
+    grid.propagation = config == 3 ? WFC_PROPAGATION_WORKLIST : WFC_PROPAGATION_NEIGHBOURS;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    grid_memory = malloc(grid_memory_size);
+
+    if (config < 2)
+    {
+      assert(!wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+    }
+    else
+    {
+      for (i = 0; i < 200; ++i)
+      {
+        wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, i);
+        assert(wfc_test_grid_is_solved_all(&grid, &tiles));
+      }
+    }
+
+    free(grid_memory);
+  }
+
+  free(tiles_memory);
+
+  tiles = tiles_empty;
+  wfc_test_setup_complete_tiles(&tiles, &tiles_memory, 6, WFC_TOPOLOGY_CUBE);
+  grid.cols = 4;
+  grid.rows = 4;
+  grid.layers = 1;
+  grid.topology = WFC_TOPOLOGY_CUBE;
+  grid.propagation = WFC_PROPAGATION_NEIGHBOURS;
+  grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+  grid_memory = malloc(grid_memory_size);
+  assert(!wfc_grid_initialize(&grid, &tiles, grid_memory, grid_memory_size));
+  free(grid_memory);
+  free(tiles_memory);
+
+  /* A seamless texture: the right edge fits the left edge and the bottom edge the top, also
+     after re-solving a region across the corner of the texture */
+  {
+    wfc_grid region = {0};
+    unsigned char *region_memory;
+    unsigned int region_memory_size;
+    wfc_rng rng;
+    int status = 0;
+    unsigned int y;
+
+    tiles = tiles_empty;
+    wfc_test_setup_random_tiles(&tiles, &tiles_memory, 32, 4, 1, 3, 42);
+
+    grid.cols = 48;
+    grid.rows = 40;
+    grid.topology = WFC_TOPOLOGY_SQUARE;
+    grid.propagation = WFC_PROPAGATION_WORKLIST;
+    grid_memory_size = wfc_grid_memory_size(&grid, &tiles);
+    grid_memory = malloc(grid_memory_size);
+
+    wfc_test_solve(&grid, &tiles, grid_memory, grid_memory_size, 21);
+    assert(wfc_test_grid_is_solved_all(&grid, &tiles));
+
+    for (y = 0; y < grid.rows; ++y)
+    {
+      assert(wfc_tiles_is_compatible_tile(&tiles, wfc_grid_find_nth_tile_in_mask(&grid, y * grid.cols + grid.cols - 1, 0), 1,
+                                          wfc_grid_find_nth_tile_in_mask(&grid, y * grid.cols, 0)));
+    }
+
+    region.selection = WFC_SELECTION_MIN_HEAP;
+    region.propagation = WFC_PROPAGATION_WORKLIST;
+    region.rng = &rng;
+    region.rows = 10;
+    region.cols = 10;
+    region_memory_size = wfc_grid_memory_size(&region, &tiles);
+    region_memory = malloc(region_memory_size);
+
+    for (i = 0; status != 1 && i < 1000; ++i)
+    {
+      wfc_rng_seed(&rng, i);
+      status = wfc_grid_solve_region(&grid, &tiles, 0, 0, 10, 10, 0, &region, region_memory, region_memory_size);
+      assert(status >= 0);
+    }
+
+    assert(status == 1);
+    assert(wfc_test_grid_is_solved_all(&grid, &tiles));
+
+    /* A rectangle spanning the whole width would have to wrap onto itself */
+    assert(wfc_grid_solve_region(&grid, &tiles, 0, 0, 10, grid.cols, 0, &region, region_memory, region_memory_size) == -1);
+
+    free(region_memory);
+    free(grid_memory);
+    free(tiles_memory);
+  }
+
+  tiles = tiles_empty;
+  wfc_test_setup_complete_tiles(&tiles, &tiles_memory, 4, WFC_TOPOLOGY_SQUARE);
+  wfc_test_benchmark_boundary(&tiles, WFC_BOUNDARY_BOUNDED, 1024, "wfc_boundary_bounded_1024x1024");
+  wfc_test_benchmark_boundary(&tiles, WFC_BOUNDARY_PERIODIC, 1024, "wfc_boundary_periodic_1024x1024");
+  free(tiles_memory);
+}
+
+int main(void)
+{
+  wfc_test_socket();
+  wfc_test_grid_incides();
+  wfc_test_tile_stack_alloc();
+  wfc_test_tile_rotation_symmetrical_sockets();
+  wfc_test_tile_rotation_asymmetrical_sockets();
+  wfc_test_tile_compute_compatible_tiles();
+  wfc_test_simple_tiles();
+  wfc_test_selection_min_heap();
+  wfc_test_propagation_worklist();
+  wfc_test_propagation_support();
+  wfc_test_backtracking();
+  wfc_test_bit_intrinsics();
+  wfc_test_mask_kernels();
+  wfc_test_single_word();
+  wfc_test_many_tiles();
+  wfc_test_neighbours();
+  wfc_test_compatible_tiles_index();
+  wfc_test_compatible_tiles_parallel();
+  wfc_test_serialization();
+  wfc_test_generate_header();
+  wfc_test_rng_state();
+  wfc_test_rng_generators();
+  wfc_test_weighted_entropy();
+  wfc_test_batch();
+  wfc_test_race();
+  wfc_test_world();
+  wfc_test_parallel();
+  wfc_test_region();
+  wfc_test_pinned_cells();
+  wfc_test_voxel_grids();
+  wfc_test_hex_grids();
+  wfc_test_periodic_grids();
+
+  return 0;
+}
+
+/*
+   -----------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
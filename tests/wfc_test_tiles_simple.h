@@ -0,0 +1,29 @@
+/* Generated by wfc_tiles_generate_header, do not edit. Include wfc.h before this file. */
+#ifndef WFC_TILES_WFC_TEST_SIMPLE_H
+#define WFC_TILES_WFC_TEST_SIMPLE_H
+
+static const unsigned int wfc_test_simple_asset_ids[5u] = {
+    0u, 1u, 1u, 1u, 1u};
+
+static const unsigned int wfc_test_simple_rotations[5u] = {
+    0u, 0u, 1u, 2u, 3u};
+
+static const unsigned int wfc_test_simple_weights[5u] = {
+    1u, 1u, 1u, 1u, 1u};
+
+static const wfc_socket_8x07 wfc_test_simple_sockets[20u] = {
+    0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000008u, 0x00000008u, 0x00000000u, 0x00000008u,
+    0x00000008u, 0x00000008u, 0x00000008u, 0x00000000u, 0x00000000u, 0x00000008u, 0x00000008u, 0x00000008u,
+    0x00000008u, 0x00000000u, 0x00000008u, 0x00000008u};
+
+static const unsigned int wfc_test_simple_masks[20u] = {
+    0x00000003u, 0x00000005u, 0x00000009u, 0x00000011u, 0x0000001Cu, 0x0000001Au, 0x00000009u, 0x0000000Eu,
+    0x0000001Cu, 0x0000001Au, 0x00000016u, 0x00000011u, 0x00000003u, 0x0000001Au, 0x00000016u, 0x0000000Eu,
+    0x0000001Cu, 0x00000005u, 0x00000016u, 0x0000000Eu};
+
+WFC_API WFC_INLINE int wfc_test_simple_tiles_initialize(wfc_tiles *tiles)
+{
+  return wfc_tiles_initialize_static(tiles, 5u, 4u, 3u, wfc_test_simple_asset_ids, wfc_test_simple_rotations, wfc_test_simple_weights, wfc_test_simple_sockets, wfc_test_simple_masks);
+}
+
+#endif
@@ -1,728 +1,5085 @@
-/* wfc.h - v0.3 - public domain data structures - nickscha 2025
-
-A C89 standard compliant, single header, nostdlib (no C Standard Library) Wave Function Collapse (WFC).
-
-LICENSE
-
-  Placed in the public domain and also MIT licensed.
-  See end of file for detailed license information.
-
-*/
-#ifndef WFC_H
-#define WFC_H
-
-/* #############################################################################
- * # COMPILER SETTINGS
- * #############################################################################
- */
-/* Check if using C99 or later (inline is supported) */
-#if __STDC_VERSION__ >= 199901L
-#define WFC_INLINE inline
-#elif defined(__GNUC__) || defined(__clang__)
-#define WFC_INLINE __inline__
-#elif defined(_MSC_VER)
-#define WFC_INLINE __inline
-#else
-#define WFC_INLINE
-#endif
-
-#define WFC_API static
-
-/* #############################################################################
- * # Math & RNG
- * #############################################################################
- */
-/* Linear Congruential Generator (LCG) constants */
-#define WFC_LCG_A 1664525U
-#define WFC_LCG_C 1013904223U
-#define WFC_LCG_M 4294967296.0f /* 2^32 */
-
-/* Seed for the random number generator */
-static unsigned int wfc_seed_lcg = 1;
-
-WFC_API WFC_INLINE unsigned int wfc_randi(void)
-{
-  wfc_seed_lcg = (WFC_LCG_A * wfc_seed_lcg + WFC_LCG_C);
-  return wfc_seed_lcg;
-}
-
-WFC_API WFC_INLINE unsigned int wfc_randi_range(unsigned int min, unsigned int max)
-{
-  unsigned int r = wfc_randi();
-  unsigned int range = max - min;
-  unsigned int val = (r >> 16) % (range ? range : 1);
-
-  return min + val;
-}
-
-/* Counts the number of set bits in an integer (population count) */
-WFC_API WFC_INLINE unsigned int wfc_popcount(unsigned int n)
-{
-  unsigned int count = 0;
-
-  while (n > 0)
-  {
-    n &= (n - 1);
-    count++;
-  }
-  return count;
-}
-
-/* #############################################################################
- * # Socket Mask
- * #############################################################################
- */
-/* Packs 8 sockets that can have a value from 0 - 7 in a single 32bit type (here we only use 24bits, 8 values * 3bits for 0-7 range)  */
-#define WFC_SOCKETS_MAX_VALUES 8
-typedef unsigned int wfc_socket_8x07;
-
-/* Set socket[idx] = value (idx = 0..7, value = 0..7) */
-WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_pack(wfc_socket_8x07 s, int idx, unsigned int value)
-{
-  int shift = idx * 3;
-  wfc_socket_8x07 mask = (wfc_socket_8x07)(0x7 << shift);
-  s = (s & ~mask) | ((value & 0x7) << shift);
-  return s;
-}
-
-WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_pack_4(
-    unsigned int socket_value_0,
-    unsigned int socket_value_1,
-    unsigned int socket_value_2,
-    unsigned int socket_value_3)
-{
-  wfc_socket_8x07 s = 0;
-
-  s = wfc_socket_pack(s, 0, socket_value_0);
-  s = wfc_socket_pack(s, 1, socket_value_1);
-  s = wfc_socket_pack(s, 2, socket_value_2);
-  s = wfc_socket_pack(s, 3, socket_value_3);
-
-  return s;
-}
-
-WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_pack_8(
-    unsigned int socket_value_0,
-    unsigned int socket_value_1,
-    unsigned int socket_value_2,
-    unsigned int socket_value_3,
-    unsigned int socket_value_4,
-    unsigned int socket_value_5,
-    unsigned int socket_value_6,
-    unsigned int socket_value_7)
-{
-  wfc_socket_8x07 s = 0;
-
-  s = wfc_socket_pack(s, 0, socket_value_0);
-  s = wfc_socket_pack(s, 1, socket_value_1);
-  s = wfc_socket_pack(s, 2, socket_value_2);
-  s = wfc_socket_pack(s, 3, socket_value_3);
-  s = wfc_socket_pack(s, 4, socket_value_4);
-  s = wfc_socket_pack(s, 5, socket_value_5);
-  s = wfc_socket_pack(s, 6, socket_value_6);
-  s = wfc_socket_pack(s, 7, socket_value_7);
-
-  return s;
-}
-
-/* Get socket[idx] (idx = 0..7) */
-WFC_API WFC_INLINE unsigned int wfc_socket_unpack(wfc_socket_8x07 s, int idx)
-{
-  int shift = idx * 3;
-  return (s >> shift) & 0x7;
-}
-
-/* Reverse order of sockets, up to socket_count */
-WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_reverse(wfc_socket_8x07 s, unsigned int socket_count)
-{
-  wfc_socket_8x07 r = 0;
-  unsigned int i;
-
-  if (socket_count < 1 || socket_count > WFC_SOCKETS_MAX_VALUES)
-  {
-    return s; /* invalid count, return unchanged */
-  }
-
-  for (i = 0; i < socket_count; ++i)
-  {
-    unsigned int v = wfc_socket_unpack(s, (int)i);
-    
-    r = wfc_socket_pack(r, ((int)socket_count - 1) - (int)i, v);
-  }
-
-  return r;
-}
-
-/* #############################################################################
- * # Tile initialization and setup
- * #############################################################################
- */
-/* Data-oriented SoA tiles struct */
-typedef struct wfc_tiles
-{
-  /* Initialization Flags */
-  unsigned int tiles_initialized;
-  unsigned int tiles_compatible_tiles_computed;
-  unsigned int tile_direction_compatible_masks_words; /* = (tile_count + 31) / 32 */
-
-  /* Configuration */
-  unsigned int tile_capacity;               /* Maximum number of tiles that can be stored */
-  unsigned int tile_count;                  /* Current number of tiles */
-  unsigned int tile_direction_count;        /* Number of directions per tile */
-  unsigned int tile_direction_socket_count; /* Number of socket values per direction */
-
-  /* Data arrays per tile */
-  unsigned int *tile_asset_ids; /* Size: tile_count. User data: Tile ids. These are not used by the actual algorithm  */
-  unsigned int *tile_rotations; /* Size: tile_count. For each tile id what rotation did we apply (0=no rotation, 1=1 rotation, ...) */
-
-  /* Data arrays per tile and tile_direction_count */
-  wfc_socket_8x07 *tile_direction_sockets; /* Size: tile_count * tile_direction_count. The sockets (e.g flags) for each direction */
-
-  /* Dynamic bitmask: each tile-direction has mask_words words to represent all compatible tiles */
-  unsigned int *tile_direction_compatible_masks;
-
-} wfc_tiles;
-
-#define WFC_TILES_MEMORY_SIZE(tile_capacity, tile_direction_count)                                         \
-  ((unsigned int)(sizeof(unsigned int) * ((tile_capacity) * 2                        /* ids + rotations */ \
-                                          + (tile_capacity) * (tile_direction_count) /* sockets */         \
-                                          + (tile_capacity) * (tile_direction_count) * ((tile_capacity + 31) / 32) /* mask words */)))
-
-WFC_API WFC_INLINE int wfc_tiles_is_compatible_tile(
-    wfc_tiles *tiles,
-    unsigned int tile_a,
-    unsigned int dir,
-    unsigned int tile_b)
-{
-  unsigned int mask_words;
-  unsigned int base;
-  unsigned int *mask;
-  unsigned int word_index;
-  unsigned int bit_index;
-  unsigned int word;
-
-  if (!tiles)
-  {
-    return 0;
-  }
-
-  mask_words = tiles->tile_direction_compatible_masks_words;
-  base = (tile_a * tiles->tile_direction_count + dir) * mask_words;
-  mask = &tiles->tile_direction_compatible_masks[base];
-
-  word_index = tile_b / 32;
-  bit_index = tile_b % 32;
-
-  word = mask[word_index];
-
-  if (word & (1u << bit_index))
-  {
-    return 1;
-  }
-
-  return 0;
-}
-
-WFC_API WFC_INLINE int wfc_tiles_initialize(wfc_tiles *tiles, unsigned char *tiles_memory, unsigned int tiles_memory_size)
-{
-  unsigned char *ptr = tiles_memory;
-
-  if (!tiles || !tiles_memory || tiles_memory_size < WFC_TILES_MEMORY_SIZE(tiles->tile_capacity, tiles->tile_direction_count))
-  {
-    return 0;
-  }
-
-  tiles->tile_asset_ids = (unsigned int *)ptr;
-  ptr += sizeof(unsigned int) * tiles->tile_capacity;
-
-  tiles->tile_rotations = (unsigned int *)ptr;
-  ptr += sizeof(unsigned int) * tiles->tile_capacity;
-
-  tiles->tile_direction_sockets = (wfc_socket_8x07 *)ptr;
-  ptr += sizeof(wfc_socket_8x07) * (tiles->tile_capacity * tiles->tile_direction_count);
-
-  tiles->tile_direction_compatible_masks = (unsigned int *)ptr;
-
-  tiles->tiles_initialized = 1;
-
-  return 1;
-}
-
-WFC_API WFC_INLINE int wfc_tiles_add_tile(
-    wfc_tiles *tiles,
-    unsigned int tile_id,
-    wfc_socket_8x07 *tile_direction_sockets,
-    unsigned int tile_rotations)
-{
-  unsigned int i;
-  unsigned int tile_direction_count;
-
-  /* Invalid arguments */
-  if (!tiles || !tiles->tiles_initialized || tiles->tile_capacity == 0 || !tile_direction_sockets)
-  {
-    return 0;
-  }
-
-  /* not enough space in buffer */
-  if (tiles->tile_count + 1 + tile_rotations > tiles->tile_capacity)
-  {
-    return 0;
-  }
-
-  tile_direction_count = tiles->tile_direction_count;
-
-  /* Add the tile */
-  tiles->tile_asset_ids[tiles->tile_count] = tile_id;
-  tiles->tile_rotations[tiles->tile_count] = 0;
-
-  /* Add the sockets for each direction of the tile */
-  for (i = 0; i < tile_direction_count; ++i)
-  {
-    tiles->tile_direction_sockets[(tiles->tile_count * tile_direction_count) + i] = tile_direction_sockets[i];
-  }
-
-  tiles->tile_count++;
-
-  if (tile_rotations > 0)
-  {
-    unsigned int rotation;
-
-    /* Clamp tile_rotations to tile_direction_count -1 */
-    if (tile_rotations > tile_direction_count - 1)
-    {
-      tile_rotations = tile_direction_count - 1;
-    }
-
-    /* Rotate the sockets and add new tiles */
-    for (rotation = 0; rotation < tile_rotations; ++rotation)
-    {
-      tiles->tile_asset_ids[tiles->tile_count] = tile_id;
-      tiles->tile_rotations[tiles->tile_count] = rotation + 1;
-
-      /* Rotate the socket values clockwise */
-      {
-        unsigned int src_base = (tiles->tile_count - 1) * tile_direction_count;
-        unsigned int dst_base = tiles->tile_count * tile_direction_count;
-        unsigned int j;
-
-        for (j = 0; j < tile_direction_count; ++j)
-        {
-          unsigned int src_index = (j + (tile_direction_count - 1)) % tile_direction_count;
-
-          tiles->tile_direction_sockets[dst_base + j] = tiles->tile_direction_sockets[src_base + src_index];
-        }
-      }
-
-      tiles->tile_count++;
-    }
-  }
-
-  return 1;
-}
-
-WFC_API WFC_INLINE int wfc_tiles_compute_compatible_tiles(wfc_tiles *tiles)
-{
-  unsigned int tile_count;
-  unsigned int dir_count;
-  unsigned int mask_words;
-
-  unsigned int a, b, d;
-
-  if (!tiles || !tiles->tiles_initialized || !tiles->tile_direction_compatible_masks)
-  {
-    return 0;
-  }
-
-  tile_count = tiles->tile_count;
-  dir_count = tiles->tile_direction_count;
-
-  tiles->tile_direction_compatible_masks_words = (tile_count + 31) / 32;
-  mask_words = tiles->tile_direction_compatible_masks_words;
-
-  /* Clear masks */
-  for (a = 0; a < tile_count * dir_count * mask_words; ++a)
-  {
-    tiles->tile_direction_compatible_masks[a] = 0;
-  }
-
-  for (a = 0; a < tile_count; ++a)
-  {
-
-    for (d = 0; d < dir_count; ++d)
-    {
-
-      unsigned int base = (a * dir_count + d) * mask_words;
-      unsigned int opp_dir = (d + dir_count / 2) % dir_count;
-      wfc_socket_8x07 socket_a = tiles->tile_direction_sockets[a * dir_count + d];
-
-      for (b = 0; b < tile_count; ++b)
-      {
-        wfc_socket_8x07 socket_b = tiles->tile_direction_sockets[b * dir_count + opp_dir];
-
-        if (wfc_socket_reverse(socket_b, tiles->tile_direction_socket_count) == socket_a)
-        {
-          tiles->tile_direction_compatible_masks[base + (b / 32)] |= 1u << (b % 32);
-        }
-      }
-    }
-  }
-
-  tiles->tiles_compatible_tiles_computed = 1;
-
-  return 1;
-}
-
-/* #############################################################################
- * # Grid initialization and setup
- * #############################################################################
- */
-/* Data-oriented SoA grid struct */
-typedef struct wfc_grid
-{
-  /* Configuration */
-  unsigned int rows; /* Number of grid rows    */
-  unsigned int cols; /* Number of grid columns */
-
-  /* Runtime information */
-  unsigned int cells_processed;    /* The number of cells already processed */
-  unsigned int cell_index_current; /* The current processed cell */
-
-  /* The number of unsigned ints needed to store the bitmask for one cell's entropies */
-  unsigned int cell_entropy_mask_words;
-
-  /* Data arrays */
-  unsigned char *cell_collapsed;     /* Is the current cell collapsed? Size = rows * cols */
-  unsigned char *cell_entropy_count; /* How many entropy/options does the cell have? Size = rows * cols */
-  unsigned int *cell_entropy_masks;  /* The entropy bitmasks. Size = rows * cols * cell_entropy_mask_words */
-
-} wfc_grid;
-
-#define WFC_GRID_MEMORY_SIZE(rows, cols, tile_count)                                                      \
-  ((unsigned int)(sizeof(unsigned char) * ((rows) * (cols)) * 2 /* cell_collapsed + cell_entropy_count */ \
-                  + sizeof(unsigned int) * ((rows) * (cols)) * ((tile_count + 31) / 32) /* cell_entropy_masks */))
-
-WFC_API WFC_INLINE int wfc_grid_initialize(wfc_grid *grid, wfc_tiles *tiles, unsigned char *grid_memory, unsigned int grid_memory_size)
-{
-  unsigned char *ptr = grid_memory;
-
-  unsigned int grid_size;
-  unsigned int tile_count;
-  unsigned int i;
-  unsigned int j;
-
-  if (!grid || !tiles || !grid_memory || grid_memory_size < WFC_GRID_MEMORY_SIZE(grid->rows, grid->cols, tiles->tile_count))
-  {
-    return 0;
-  }
-
-  grid_size = grid->cols * grid->rows;
-  tile_count = tiles->tile_count;
-
-  grid->cell_entropy_mask_words = (tile_count + 31) / 32;
-
-  grid->cell_collapsed = ptr;
-  ptr += sizeof(unsigned char) * grid_size;
-
-  grid->cell_entropy_count = ptr;
-  ptr += sizeof(unsigned char) * grid_size;
-
-  grid->cell_entropy_masks = (unsigned int *)ptr;
-
-  /* Initialize cell entropy bitmasks to all 1s (all tiles possible) */
-  for (i = 0; i < grid_size; ++i)
-  {
-    unsigned int base_index = (i * grid->cell_entropy_mask_words);
-
-    for (j = 0; j < grid->cell_entropy_mask_words; ++j)
-    {
-      /* Set all bits to 1, meaning all tiles are initially possible */
-      grid->cell_entropy_masks[base_index + j] = 0xFFFFFFFF;
-    }
-
-    grid->cell_collapsed[i] = 0;
-    grid->cell_entropy_count[i] = (unsigned char)tile_count;
-  }
-
-  return 1;
-}
-
-WFC_API WFC_INLINE int wfc_grid_index_at(int x, int y, int cols)
-{
-  return (y * cols + x);
-}
-
-WFC_API WFC_INLINE void wfc_grid_coords_at(int index, int cols, int *x, int *y)
-{
-  if (!x || !y)
-  {
-    return; /* invalid input, no-op */
-  }
-
-  *y = index / cols;
-  *x = index % cols;
-}
-
-/* Collapse the current cell and set the first entropies entry to the desired tile_index entropies entry */
-WFC_API WFC_INLINE void wfc_grid_collapse_current_cell(wfc_grid *grid, unsigned int tile_to_keep)
-{
-  unsigned int i;
-  unsigned int base_mask_index = grid->cell_index_current * grid->cell_entropy_mask_words;
-
-  /* Clear all bits in the cell's entropy mask */
-  for (i = 0; i < grid->cell_entropy_mask_words; ++i)
-  {
-    grid->cell_entropy_masks[base_mask_index + i] = 0;
-  }
-
-  /* Set the single bit for the chosen tile */
-  grid->cell_entropy_masks[base_mask_index + (tile_to_keep / 32)] = (1u << (tile_to_keep % 32));
-
-  grid->cell_collapsed[grid->cell_index_current] = 1;     /* Mark the cell as collapsed */
-  grid->cell_entropy_count[grid->cell_index_current] = 1; /* A collapsed cell has only 1 option */
-  grid->cells_processed++;
-}
-
-WFC_API WFC_INLINE int wfc_grid_neighbour_index(wfc_grid *grid, int index, unsigned int dir, unsigned int dir_count)
-{
-  int x, y;
-
-  wfc_grid_coords_at(index, (int)grid->cols, &x, &y);
-
-  (void)dir_count;
-
-  switch (dir)
-  {
-  case 0:
-    y -= 1;
-    break; /* up */
-  case 1:
-    x += 1;
-    break; /* right */
-  case 2:
-    y += 1;
-    break; /* down */
-  case 3:
-    x -= 1;
-    break; /* left */
-  default:
-    return -1; /* not handled (for >4 dirs extend this) */
-  }
-
-  if (x < 0 || y < 0 || x >= (int)grid->cols || y >= (int)grid->rows)
-  {
-    return -1;
-  }
-
-  return wfc_grid_index_at(x, y, (int)grid->cols);
-}
-
-WFC_API WFC_INLINE unsigned int wfc_grid_find_nth_tile_in_mask(wfc_grid *grid, unsigned int cell_index, unsigned int n)
-{
-  unsigned int word_index, bit_index;
-  unsigned int count = 0;
-  unsigned int base_mask_index = cell_index * grid->cell_entropy_mask_words;
-
-  for (word_index = 0; word_index < grid->cell_entropy_mask_words; ++word_index)
-  {
-    unsigned int word = grid->cell_entropy_masks[base_mask_index + word_index];
-    unsigned int bits_in_word = wfc_popcount(word);
-
-    if (count + bits_in_word > n)
-    {
-      /* The Nth bit is in this word */
-      for (bit_index = 0; bit_index < 32; ++bit_index)
-      {
-        if (word & (1u << bit_index))
-        {
-          if (count == n)
-          {
-            return (word_index * 32) + bit_index;
-          }
-
-          count++;
-        }
-      }
-    }
-
-    count += bits_in_word;
-  }
-
-  return (unsigned int)-1; /* Should not be reached if n < entropy_count */
-}
-
-/* #############################################################################
- * # Wave Function Collapse Algorithm
- * #############################################################################
- */
-WFC_API WFC_INLINE void wfc_update_neighbour_entropies(wfc_grid *grid, wfc_tiles *tiles, unsigned int collapsed_index)
-{
-  unsigned int dir_count = tiles->tile_direction_count;
-  unsigned int tile_count = tiles->tile_count;
-  unsigned int compatible_mask_words = tiles->tile_direction_compatible_masks_words;
-  unsigned int d, k;
-
-  /* Since the cell is collapsed, it has only one tile. Find it. */
-  unsigned int collapsed_tile = wfc_grid_find_nth_tile_in_mask(grid, collapsed_index, 0);
-
-  /* This should not happen if the logic is correct */
-  if (collapsed_tile > tile_count)
-  {
-    return;
-  }
-
-  for (d = 0; d < dir_count; ++d)
-  {
-    int neighbour_index = wfc_grid_neighbour_index(grid, (int)collapsed_index, d, dir_count);
-
-    unsigned int *compatible_mask;
-    unsigned int *neighbour_mask;
-    unsigned int new_entropy_count;
-
-    if (neighbour_index < 0 || grid->cell_collapsed[neighbour_index])
-    {
-      continue;
-    }
-
-    /* Get the mask of tiles that are compatible with our collapsed tile in this direction */
-    compatible_mask = &tiles->tile_direction_compatible_masks[(collapsed_tile * dir_count + d) * compatible_mask_words];
-    neighbour_mask = &grid->cell_entropy_masks[(unsigned int)neighbour_index * grid->cell_entropy_mask_words];
-
-    new_entropy_count = 0;
-
-    /* Filter the neighbor's possibilities by ANDing its mask with the compatibility mask. */
-    for (k = 0; k < compatible_mask_words; ++k)
-    {
-      neighbour_mask[k] &= compatible_mask[k];
-      new_entropy_count += wfc_popcount(neighbour_mask[k]);
-    }
-
-    grid->cell_entropy_count[neighbour_index] = (unsigned char)new_entropy_count;
-  }
-}
-
-WFC_API WFC_INLINE int wfc(wfc_grid *grid, wfc_tiles *tiles)
-{
-  unsigned int total_cells;
-  unsigned int iteration;
-
-  if (!grid || !tiles || !tiles->tiles_initialized || grid->rows < 1 || grid->cols < 1 || tiles->tile_count < 1)
-  {
-    return 0;
-  }
-
-  if (!tiles->tiles_compatible_tiles_computed)
-  {
-    wfc_tiles_compute_compatible_tiles(tiles);
-  }
-
-  total_cells = grid->rows * grid->cols;
-  grid->cells_processed = 0;
-
-  /* Repeat until all cells are collapsed */
-  for (iteration = 0; iteration < total_cells; ++iteration)
-  {
-    unsigned int lowest_entropy = 255;
-    unsigned int lowest_cell = 0;
-    unsigned int i;
-
-    /* 1. Find the non-collapsed cell with the lowest entropy */
-    for (i = 0; i < total_cells; ++i)
-    {
-      unsigned char count = grid->cell_entropy_count[i];
-
-      if (!grid->cell_collapsed[i])
-      {
-        if (count == 0)
-        {
-          return 0; /* This cell has no valid tiles → unsolvable */
-        }
-
-        if (count < lowest_entropy)
-        {
-          lowest_entropy = count;
-          lowest_cell = i;
-
-          if (lowest_entropy == 1)
-          {
-            break; /* can't get lower than 1 */
-          }
-        }
-      }
-    }
-
-    /* no cell found (finished or stuck) */
-    if (lowest_entropy == 255)
-    {
-      break;
-    }
-
-    /* 2. Randomly choose one tile from available entropies */
-    {
-      unsigned int choice_index;
-      unsigned int chosen_tile_index;
-
-      choice_index = wfc_randi_range(0, lowest_entropy);
-
-      /* Find the actual tile index corresponding to the random choice */
-      chosen_tile_index = wfc_grid_find_nth_tile_in_mask(grid, lowest_cell, choice_index);
-
-      /* This would mean a contradiction or bug */
-      if (chosen_tile_index > tiles->tile_count)
-      {
-        return 0;
-      }
-
-      grid->cell_index_current = lowest_cell;
-      wfc_grid_collapse_current_cell(grid, chosen_tile_index);
-    }
-
-    /* 3. Propagate constraints */
-    wfc_update_neighbour_entropies(grid, tiles, grid->cell_index_current);
-  }
-
-  return grid->cells_processed == grid->rows * grid->cols;
-}
-
-#endif /* WFC_H */
-
-/*
-   ------------------------------------------------------------------------------
-   This software is available under 2 licenses -- choose whichever you prefer.
-   ------------------------------------------------------------------------------
-   ALTERNATIVE A - MIT License
-   Copyright (c) 2025 nickscha
-   Permission is hereby granted, free of charge, to any person obtaining a copy of
-   this software and associated documentation files (the "Software"), to deal in
-   the Software without restriction, including without limitation the rights to
-   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
-   of the Software, and to permit persons to whom the Software is furnished to do
-   so, subject to the following conditions:
-   The above copyright notice and this permission notice shall be included in all
-   copies or substantial portions of the Software.
-   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-   SOFTWARE.
-   ------------------------------------------------------------------------------
-   ALTERNATIVE B - Public Domain (www.unlicense.org)
-   This is free and unencumbered software released into the public domain.
-   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
-   software, either in source code form or as a compiled binary, for any purpose,
-   commercial or non-commercial, and by any means.
-   In jurisdictions that recognize copyright laws, the author or authors of this
-   software dedicate any and all copyright interest in the software to the public
-   domain. We make this dedication for the benefit of the public at large and to
-   the detriment of our heirs and successors. We intend this dedication to be an
-   overt act of relinquishment in perpetuity of all present and future rights to
-   this software under copyright law.
-   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
-   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
-   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-   ------------------------------------------------------------------------------
-*/
+/* wfc.h - v0.3 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) Wave Function Collapse (WFC).
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef WFC_H
+#define WFC_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define WFC_INLINE inline
+#elif defined(__GNUC__) || defined(__clang__)
+#define WFC_INLINE __inline__
+#elif defined(_MSC_VER)
+#define WFC_INLINE __inline
+#else
+#define WFC_INLINE
+#endif
+
+#define WFC_API static
+
+/* Hardware bit intrinsics are used when the target enables them (e.g. -march=native, -mpopcnt, -mbmi2 or /arch:AVX2).
+   Define WFC_NO_INTRINSICS to always use the portable C89 code. */
+#if !defined(WFC_NO_INTRINSICS) && (defined(__GNUC__) || defined(__clang__))
+#define WFC_INTRINSIC_CTZ
+#if defined(__POPCNT__) || defined(__aarch64__)
+#define WFC_INTRINSIC_POPCOUNT
+#endif
+#if defined(__BMI2__) && (defined(__x86_64__) || defined(__i386__))
+#define WFC_INTRINSIC_PDEP
+#endif
+#elif !defined(WFC_NO_INTRINSICS) && defined(_MSC_VER)
+#include <intrin.h>
+#define WFC_INTRINSIC_CTZ
+#if defined(__AVX__)
+#define WFC_INTRINSIC_POPCOUNT
+#endif
+#if defined(__AVX2__)
+#define WFC_INTRINSIC_PDEP
+#endif
+#endif
+
+/* SIMD mask kernels on GCC/clang vector extensions, which lower to AVX2, SSE2 or NEON depending on the target
+   without pulling in any intrinsic header. Define WFC_NO_SIMD to always use the scalar loops. */
+#if !defined(WFC_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && defined(__AVX2__)
+#define WFC_SIMD_WORDS 8
+typedef unsigned int wfc_simd_u32 __attribute__((vector_size(32), aligned(4), __may_alias__));
+#elif !defined(WFC_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__SSE2__) || defined(__ARM_NEON))
+#define WFC_SIMD_WORDS 4
+typedef unsigned int wfc_simd_u32 __attribute__((vector_size(16), aligned(4), __may_alias__));
+#endif
+
+/* Thin thread shim for the parallel functions. Define WFC_THREADS to enable it, it pulls in pthread.h on
+   POSIX and declares the few kernel32 functions it needs on Win32. Without it the core stays nostdlib and
+   the *_job functions can be driven by any scheduler. */
+#ifdef WFC_THREADS
+#ifndef WFC_THREADS_MAX
+#define WFC_THREADS_MAX 64
+#endif
+
+#ifdef _WIN32
+#ifndef _WINDOWS_
+#define WFC_WIN32_API(r) __declspec(dllimport) r __stdcall
+WFC_WIN32_API(void *)
+CreateThread(void *lpThreadAttributes, unsigned long dwStackSize, unsigned long(__stdcall *lpStartAddress)(void *), void *lpParameter, unsigned long dwCreationFlags, unsigned long *lpThreadId);
+WFC_WIN32_API(unsigned long)
+WaitForSingleObject(void *hHandle, unsigned long dwMilliseconds);
+WFC_WIN32_API(int)
+CloseHandle(void *hObject);
+#endif /* _WINDOWS_ (windows.h) */
+typedef void *wfc_thread_handle;
+#else
+#include <pthread.h>
+typedef pthread_t wfc_thread_handle;
+#endif
+
+typedef struct wfc_thread
+{
+  wfc_thread_handle handle;
+  void (*function)(void *argument);
+  void *argument;
+} wfc_thread;
+
+#ifdef _WIN32
+static unsigned long __stdcall wfc_thread_entry(void *thread)
+{
+  ((wfc_thread *)thread)->function(((wfc_thread *)thread)->argument);
+  return 0;
+}
+#else
+static void *wfc_thread_entry(void *thread)
+{
+  ((wfc_thread *)thread)->function(((wfc_thread *)thread)->argument);
+  return (void *)0;
+}
+#endif
+
+/* Starts function(argument) on a new thread. The thread struct must stay alive until wfc_thread_join */
+WFC_API WFC_INLINE int wfc_thread_create(wfc_thread *thread, void (*function)(void *argument), void *argument)
+{
+  thread->function = function;
+  thread->argument = argument;
+
+#ifdef _WIN32
+  thread->handle = CreateThread((void *)0, 0, wfc_thread_entry, thread, 0, (unsigned long *)0);
+  return thread->handle != (void *)0;
+#else
+  return pthread_create(&thread->handle, (void *)0, wfc_thread_entry, thread) == 0;
+#endif
+}
+
+WFC_API WFC_INLINE void wfc_thread_join(wfc_thread *thread)
+{
+#ifdef _WIN32
+  WaitForSingleObject(thread->handle, 0xFFFFFFFF); /* INFINITE */
+  CloseHandle(thread->handle);
+#else
+  pthread_join(thread->handle, (void **)0);
+#endif
+}
+
+/* Atomic operations (full barriers) on counters shared between threads. add and cas return the previous value, store overwrites unconditionally */
+#ifdef _MSC_VER
+long _InterlockedExchangeAdd(long volatile *addend, long value);
+long _InterlockedCompareExchange(long volatile *destination, long exchange, long comparand);
+long _InterlockedExchange(long volatile *target, long value);
+#pragma intrinsic(_InterlockedExchangeAdd, _InterlockedCompareExchange, _InterlockedExchange)
+#endif
+
+WFC_API WFC_INLINE unsigned int wfc_atomic_add(volatile unsigned int *value, unsigned int amount)
+{
+#ifdef _MSC_VER
+  return (unsigned int)_InterlockedExchangeAdd((long volatile *)value, (long)amount);
+#else
+  return __sync_fetch_and_add(value, amount);
+#endif
+}
+
+WFC_API WFC_INLINE unsigned int wfc_atomic_cas(volatile unsigned int *value, unsigned int expected, unsigned int desired)
+{
+#ifdef _MSC_VER
+  return (unsigned int)_InterlockedCompareExchange((long volatile *)value, (long)desired, (long)expected);
+#else
+  return __sync_val_compare_and_swap(value, expected, desired);
+#endif
+}
+
+WFC_API WFC_INLINE unsigned int wfc_atomic_load(volatile unsigned int *value)
+{
+  return wfc_atomic_add(value, 0);
+}
+
+WFC_API WFC_INLINE void wfc_atomic_store(volatile unsigned int *value, unsigned int desired)
+{
+#ifdef _MSC_VER
+  _InterlockedExchange((long volatile *)value, (long)desired);
+#else
+  /* The __sync builtins have no plain store with a full barrier, the compare and swap is retried until it lands */
+  unsigned int expected = *value;
+  unsigned int previous;
+
+  while ((previous = __sync_val_compare_and_swap(value, expected, desired)) != expected)
+  {
+    expected = previous;
+  }
+#endif
+}
+#endif /* WFC_THREADS */
+
+/* #############################################################################
+ * # Math & RNG
+ * #############################################################################
+ */
+/* Linear Congruential Generator (LCG) constants */
+#define WFC_LCG_A 1664525U
+#define WFC_LCG_C 1013904223U
+#define WFC_LCG_M 4294967296.0f /* 2^32 */
+
+/* Random number generators. WFC_RNG selects the one wfc_rng_seed/wfc_rng_next/wfc_rng_range use:
+   - WFC_RNG_LCG        32 bit LCG with the old range reduction, reproduces the results of earlier seeds (default)
+   - WFC_RNG_PCG32      PCG-XSH-RR 64/32 with multiply-shift range reduction
+   - WFC_RNG_XOSHIRO128 xoshiro128** seeded by splitmix32, with multiply-shift range reduction
+   All generators are available through their own functions independent of WFC_RNG. */
+#define WFC_RNG_LCG 0
+#define WFC_RNG_PCG32 1
+#define WFC_RNG_XOSHIRO128 2
+
+#ifndef WFC_RNG
+#define WFC_RNG WFC_RNG_LCG
+#endif
+
+/* Random number state. Every solver that owns one is independent of all others, so grids can be solved
+   concurrently and each result only depends on its own seed.
+   LCG: state[0]. PCG32: 64 bit state in state[0] (low) and state[1] (high), 64 bit increment in state[2] and state[3].
+   xoshiro128**: state[0..3]. */
+typedef struct wfc_rng
+{
+  unsigned int state[4];
+
+} wfc_rng;
+
+/* Full 64 bit product of two 32 bit values */
+#if defined(__GNUC__) || defined(__clang__)
+__extension__ typedef unsigned long long wfc_u64;
+#define WFC_HAS_U64
+#elif defined(_MSC_VER)
+typedef unsigned __int64 wfc_u64;
+#define WFC_HAS_U64
+#endif
+
+WFC_API WFC_INLINE void wfc_mul_wide_portable(unsigned int a, unsigned int b, unsigned int *hi, unsigned int *lo)
+{
+  unsigned int a_lo = a & 0xFFFF, a_hi = a >> 16;
+  unsigned int b_lo = b & 0xFFFF, b_hi = b >> 16;
+  unsigned int ll = a_lo * b_lo;
+  unsigned int lh = a_lo * b_hi;
+  unsigned int hl = a_hi * b_lo;
+  unsigned int mid = (ll >> 16) + (lh & 0xFFFF) + (hl & 0xFFFF);
+
+  *lo = (mid << 16) | (ll & 0xFFFF);
+  *hi = a_hi * b_hi + (lh >> 16) + (hl >> 16) + (mid >> 16);
+}
+
+WFC_API WFC_INLINE void wfc_mul_wide(unsigned int a, unsigned int b, unsigned int *hi, unsigned int *lo)
+{
+#if defined(WFC_HAS_U64) && !defined(WFC_NO_INTRINSICS)
+  wfc_u64 product = (wfc_u64)a * b;
+  *hi = (unsigned int)(product >> 32);
+  *lo = (unsigned int)product;
+#else
+  wfc_mul_wide_portable(a, b, hi, lo);
+#endif
+}
+
+/* Lemire's multiply-shift reduction of x into [0, range) without a division. Returns 0 when x falls into the few
+   values that would make the result biased, the caller then draws a new x */
+WFC_API WFC_INLINE int wfc_rng_reduce(unsigned int x, unsigned int range, unsigned int *value)
+{
+  unsigned int lo;
+
+  wfc_mul_wide(x, range, value, &lo);
+
+  /* The remainder is only computed for the rare low products */
+  return lo >= range || lo >= (0u - range) % range;
+}
+
+/* Division by a divisor that is fixed at runtime (e.g. the grid columns) as a multiply and two shifts.
+   Granlund & Montgomery: n / d = (t + ((n - t) >> shift_1)) >> shift_2 with t the high word of n * multiplier,
+   exact for every 32 bit n. A zeroed divisor divides by 1 */
+typedef struct wfc_divisor
+{
+  unsigned int multiplier;
+  unsigned int shift_1;
+  unsigned int shift_2;
+
+} wfc_divisor;
+
+/* d has to be between 1 and 2^31 */
+WFC_API WFC_INLINE void wfc_divisor_initialize(wfc_divisor *divisor, unsigned int d)
+{
+  unsigned int l = 0;
+  unsigned int remainder;
+  unsigned int quotient = 0;
+  unsigned int i;
+
+  /* l = ceil(log2(d)) */
+  while ((1u << l) < d)
+  {
+    l++;
+  }
+
+  /* multiplier = floor(2^32 * (2^l - d) / d) + 1, as a long division since (2^l - d) < d */
+  remainder = (l < 32 ? (1u << l) : 0u) - d;
+
+  for (i = 0; i < 32; ++i)
+  {
+    remainder <<= 1;
+    quotient <<= 1;
+
+    if (remainder >= d)
+    {
+      remainder -= d;
+      quotient |= 1;
+    }
+  }
+
+  divisor->multiplier = quotient + 1;
+  divisor->shift_1 = l > 0 ? 1 : 0;
+  divisor->shift_2 = l > 0 ? l - 1 : 0;
+}
+
+WFC_API WFC_INLINE unsigned int wfc_divide(wfc_divisor *divisor, unsigned int n)
+{
+  unsigned int t, lo;
+
+  wfc_mul_wide(n, divisor->multiplier, &t, &lo);
+
+  return (t + ((n - t) >> divisor->shift_1)) >> divisor->shift_2;
+}
+
+WFC_API WFC_INLINE unsigned int wfc_lcg_next(wfc_rng *rng)
+{
+  rng->state[0] = (WFC_LCG_A * rng->state[0] + WFC_LCG_C);
+  return rng->state[0];
+}
+
+/* Old range reduction of the LCG: top 16 bits modulo the range */
+WFC_API WFC_INLINE unsigned int wfc_lcg_range(wfc_rng *rng, unsigned int min, unsigned int max)
+{
+  unsigned int r = wfc_lcg_next(rng);
+  unsigned int range = max - min;
+  unsigned int val = (r >> 16) % (range ? range : 1);
+
+  return min + val;
+}
+
+WFC_API WFC_INLINE unsigned int wfc_splitmix32_next(unsigned int *state)
+{
+  unsigned int z = (*state += 0x9E3779B9u);
+  z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+  z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+  return z ^ (z >> 16);
+}
+
+/* PCG32 state = state * 6364136223846793005 + increment, the 64 bit arithmetic done on 32 bit halves */
+WFC_API WFC_INLINE void wfc_pcg32_step(wfc_rng *rng)
+{
+#if defined(WFC_HAS_U64) && !defined(WFC_NO_INTRINSICS)
+  wfc_u64 state = ((wfc_u64)rng->state[1] << 32) | rng->state[0];
+  wfc_u64 increment = ((wfc_u64)rng->state[3] << 32) | rng->state[2];
+
+  state = state * (((wfc_u64)0x5851F42Du << 32) | 0x4C957F2Du) + increment;
+
+  rng->state[0] = (unsigned int)state;
+  rng->state[1] = (unsigned int)(state >> 32);
+#else
+  unsigned int hi, lo;
+  unsigned int state_lo = rng->state[0];
+  unsigned int state_hi = rng->state[1];
+
+  wfc_mul_wide(state_lo, 0x4C957F2Du, &hi, &lo);
+  hi += state_lo * 0x5851F42Du + state_hi * 0x4C957F2Du;
+
+  rng->state[0] = lo + rng->state[2];
+  rng->state[1] = hi + rng->state[3] + (rng->state[0] < lo);
+#endif
+}
+
+WFC_API WFC_INLINE unsigned int wfc_pcg32_next(wfc_rng *rng)
+{
+  unsigned int old_lo = rng->state[0];
+  unsigned int old_hi = rng->state[1];
+  unsigned int xor_lo, xor_hi, xorshifted, rot;
+
+  wfc_pcg32_step(rng);
+
+  /* xorshifted = ((old >> 18) ^ old) >> 27, rot = old >> 59 */
+  xor_lo = old_lo ^ ((old_lo >> 18) | (old_hi << 14));
+  xor_hi = old_hi ^ (old_hi >> 18);
+  xorshifted = (xor_lo >> 27) | (xor_hi << 5);
+  rot = old_hi >> 27;
+
+  return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+}
+
+/* Seeds like the reference pcg32_srandom(initstate, initseq) for values that fit 32 bits */
+WFC_API WFC_INLINE void wfc_pcg32_seed(wfc_rng *rng, unsigned int initstate, unsigned int initseq)
+{
+  rng->state[0] = 0;
+  rng->state[1] = 0;
+  rng->state[2] = (initseq << 1) | 1u;
+  rng->state[3] = initseq >> 31;
+  wfc_pcg32_step(rng);
+  rng->state[0] += initstate;
+  rng->state[1] += rng->state[0] < initstate;
+  wfc_pcg32_step(rng);
+}
+
+WFC_API WFC_INLINE unsigned int wfc_xoshiro128_next(wfc_rng *rng)
+{
+  unsigned int *s = rng->state;
+  unsigned int x = s[1] * 5;
+  unsigned int result = ((x << 7) | (x >> 25)) * 9;
+  unsigned int t = s[1] << 9;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 11) | (s[3] >> 21);
+
+  return result;
+}
+
+WFC_API WFC_INLINE void wfc_xoshiro128_seed(wfc_rng *rng, unsigned int seed)
+{
+  rng->state[0] = wfc_splitmix32_next(&seed);
+  rng->state[1] = wfc_splitmix32_next(&seed);
+  rng->state[2] = wfc_splitmix32_next(&seed);
+  rng->state[3] = wfc_splitmix32_next(&seed);
+
+  /* The all zero state is the one state xoshiro can not leave */
+  if (!(rng->state[0] | rng->state[1] | rng->state[2] | rng->state[3]))
+  {
+    rng->state[0] = 1;
+  }
+}
+
+WFC_API WFC_INLINE void wfc_rng_seed(wfc_rng *rng, unsigned int seed)
+{
+#if WFC_RNG == WFC_RNG_PCG32
+  wfc_pcg32_seed(rng, seed, 0xDA3E39CBu);
+#elif WFC_RNG == WFC_RNG_XOSHIRO128
+  wfc_xoshiro128_seed(rng, seed);
+#else
+  rng->state[0] = seed;
+#endif
+}
+
+WFC_API WFC_INLINE unsigned int wfc_rng_next(wfc_rng *rng)
+{
+#if WFC_RNG == WFC_RNG_PCG32
+  return wfc_pcg32_next(rng);
+#elif WFC_RNG == WFC_RNG_XOSHIRO128
+  return wfc_xoshiro128_next(rng);
+#else
+  return wfc_lcg_next(rng);
+#endif
+}
+
+/* Random value in [min, max) */
+WFC_API WFC_INLINE unsigned int wfc_rng_range(wfc_rng *rng, unsigned int min, unsigned int max)
+{
+#if WFC_RNG == WFC_RNG_LCG
+  return wfc_lcg_range(rng, min, max);
+#else
+  unsigned int val;
+
+  while (!wfc_rng_reduce(wfc_rng_next(rng), max - min, &val))
+  {
+  }
+
+  return min + val;
+#endif
+}
+
+/* Seed of the global LCG, used by grids without their own wfc_rng */
+static unsigned int wfc_seed_lcg = 1;
+
+WFC_API WFC_INLINE unsigned int wfc_randi(void)
+{
+  wfc_rng rng;
+  rng.state[0] = wfc_seed_lcg;
+  wfc_seed_lcg = wfc_lcg_next(&rng);
+  return wfc_seed_lcg;
+}
+
+WFC_API WFC_INLINE unsigned int wfc_randi_range(unsigned int min, unsigned int max)
+{
+  wfc_rng rng;
+  unsigned int val;
+
+  rng.state[0] = wfc_seed_lcg;
+  val = wfc_lcg_range(&rng, min, max);
+  wfc_seed_lcg = rng.state[0];
+
+  return val;
+}
+
+/* Index of the lowest set bit (n must not be 0), de Bruijn multiplication */
+static const unsigned char wfc_debruijn_bit_index[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9};
+
+WFC_API WFC_INLINE unsigned int wfc_bit_scan_forward_portable(unsigned int n)
+{
+  return wfc_debruijn_bit_index[((n & (0u - n)) * 0x077CB531U) >> 27];
+}
+
+/* Counts the number of set bits in an integer (population count) */
+WFC_API WFC_INLINE unsigned int wfc_popcount_portable(unsigned int n)
+{
+  unsigned int count = 0;
+
+  while (n > 0)
+  {
+    n &= (n - 1);
+    count++;
+  }
+  return count;
+}
+
+/* Index of the nth (0 based) set bit (n must be lower than the popcount) */
+WFC_API WFC_INLINE unsigned int wfc_select_bit_portable(unsigned int word, unsigned int n)
+{
+  while (n-- > 0)
+  {
+    word &= word - 1;
+  }
+
+  return wfc_bit_scan_forward_portable(word);
+}
+
+WFC_API WFC_INLINE unsigned int wfc_bit_scan_forward(unsigned int n)
+{
+#if defined(WFC_INTRINSIC_CTZ) && defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, n);
+  return (unsigned int)index;
+#elif defined(WFC_INTRINSIC_CTZ)
+  return (unsigned int)__builtin_ctz(n);
+#else
+  return wfc_bit_scan_forward_portable(n);
+#endif
+}
+
+WFC_API WFC_INLINE unsigned int wfc_popcount(unsigned int n)
+{
+#if defined(WFC_INTRINSIC_POPCOUNT) && defined(_MSC_VER)
+  return __popcnt(n);
+#elif defined(WFC_INTRINSIC_POPCOUNT)
+  return (unsigned int)__builtin_popcount(n);
+#else
+  return wfc_popcount_portable(n);
+#endif
+}
+
+WFC_API WFC_INLINE unsigned int wfc_select_bit(unsigned int word, unsigned int n)
+{
+  /* Deposit a single bit into the nth set position of word */
+#if defined(WFC_INTRINSIC_PDEP) && defined(_MSC_VER)
+  return wfc_bit_scan_forward(_pdep_u32(1u << n, word));
+#elif defined(WFC_INTRINSIC_PDEP)
+  return wfc_bit_scan_forward(__builtin_ia32_pdep_si(1u << n, word));
+#else
+  return wfc_select_bit_portable(word, n);
+#endif
+}
+
+/* #############################################################################
+ * # Mask kernels
+ * #############################################################################
+ */
+/* dst &= src over words mask words, returns the number of bits left in dst */
+WFC_API WFC_INLINE unsigned int wfc_mask_and_count_portable(unsigned int *dst, unsigned int *src, unsigned int words)
+{
+  unsigned int count = 0;
+  unsigned int i;
+
+  for (i = 0; i < words; ++i)
+  {
+    dst[i] &= src[i];
+    count += wfc_popcount(dst[i]);
+  }
+
+  return count;
+}
+
+WFC_API WFC_INLINE int wfc_mask_is_empty_portable(unsigned int *mask, unsigned int words)
+{
+  unsigned int bits = 0;
+  unsigned int i;
+
+  for (i = 0; i < words; ++i)
+  {
+    bits |= mask[i];
+  }
+
+  return bits == 0;
+}
+
+/* dst |= src over words mask words */
+WFC_API WFC_INLINE void wfc_mask_or_portable(unsigned int *dst, unsigned int *src, unsigned int words)
+{
+  unsigned int i;
+
+  for (i = 0; i < words; ++i)
+  {
+    dst[i] |= src[i];
+  }
+}
+
+#ifdef WFC_SIMD_WORDS
+/* Per lane bit count (SWAR), the lanes are summed once at the end of a kernel */
+WFC_API WFC_INLINE wfc_simd_u32 wfc_simd_popcount(wfc_simd_u32 v)
+{
+  v = v - ((v >> 1) & 0x55555555u);
+  v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+  v = (v + (v >> 4)) & 0x0F0F0F0Fu;
+  v = v + (v >> 8);
+  v = v + (v >> 16);
+  return v & 0x3Fu;
+}
+#endif
+
+WFC_API WFC_INLINE unsigned int wfc_mask_and_count(unsigned int *dst, unsigned int *src, unsigned int words)
+{
+#ifdef WFC_SIMD_WORDS
+  wfc_simd_u32 counts = {0};
+  unsigned int count = 0;
+  unsigned int i;
+
+  for (i = 0; i + WFC_SIMD_WORDS <= words; i += WFC_SIMD_WORDS)
+  {
+    wfc_simd_u32 v = *(wfc_simd_u32 *)&dst[i] & *(wfc_simd_u32 *)&src[i];
+
+    *(wfc_simd_u32 *)&dst[i] = v;
+    counts += wfc_simd_popcount(v);
+  }
+
+  if (i > 0)
+  {
+    unsigned int lane;
+
+    for (lane = 0; lane < WFC_SIMD_WORDS; ++lane)
+    {
+      count += counts[lane];
+    }
+  }
+
+  return count + wfc_mask_and_count_portable(&dst[i], &src[i], words - i);
+#else
+  return wfc_mask_and_count_portable(dst, src, words);
+#endif
+}
+
+WFC_API WFC_INLINE int wfc_mask_is_empty(unsigned int *mask, unsigned int words)
+{
+#ifdef WFC_SIMD_WORDS
+  wfc_simd_u32 bits = {0};
+  unsigned int i;
+  unsigned int lane;
+
+  for (i = 0; i + WFC_SIMD_WORDS <= words; i += WFC_SIMD_WORDS)
+  {
+    bits |= *(wfc_simd_u32 *)&mask[i];
+  }
+
+  for (lane = 0; lane < WFC_SIMD_WORDS && i > 0; ++lane)
+  {
+    if (bits[lane])
+    {
+      return 0;
+    }
+  }
+
+  return wfc_mask_is_empty_portable(&mask[i], words - i);
+#else
+  return wfc_mask_is_empty_portable(mask, words);
+#endif
+}
+
+WFC_API WFC_INLINE void wfc_mask_or(unsigned int *dst, unsigned int *src, unsigned int words)
+{
+#ifdef WFC_SIMD_WORDS
+  unsigned int i;
+
+  for (i = 0; i + WFC_SIMD_WORDS <= words; i += WFC_SIMD_WORDS)
+  {
+    *(wfc_simd_u32 *)&dst[i] |= *(wfc_simd_u32 *)&src[i];
+  }
+
+  wfc_mask_or_portable(&dst[i], &src[i], words - i);
+#else
+  wfc_mask_or_portable(dst, src, words);
+#endif
+}
+
+/* #############################################################################
+ * # Socket Mask
+ * #############################################################################
+ */
+/* Packs 8 sockets that can have a value from 0 - 7 in a single 32bit type (here we only use 24bits, 8 values * 3bits for 0-7 range)  */
+#define WFC_SOCKETS_MAX_VALUES 8
+typedef unsigned int wfc_socket_8x07;
+
+/* Set socket[idx] = value (idx = 0..7, value = 0..7) */
+WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_pack(wfc_socket_8x07 s, int idx, unsigned int value)
+{
+  int shift = idx * 3;
+  wfc_socket_8x07 mask = (wfc_socket_8x07)(0x7 << shift);
+  s = (s & ~mask) | ((value & 0x7) << shift);
+  return s;
+}
+
+WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_pack_4(
+    unsigned int socket_value_0,
+    unsigned int socket_value_1,
+    unsigned int socket_value_2,
+    unsigned int socket_value_3)
+{
+  wfc_socket_8x07 s = 0;
+
+  s = wfc_socket_pack(s, 0, socket_value_0);
+  s = wfc_socket_pack(s, 1, socket_value_1);
+  s = wfc_socket_pack(s, 2, socket_value_2);
+  s = wfc_socket_pack(s, 3, socket_value_3);
+
+  return s;
+}
+
+WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_pack_8(
+    unsigned int socket_value_0,
+    unsigned int socket_value_1,
+    unsigned int socket_value_2,
+    unsigned int socket_value_3,
+    unsigned int socket_value_4,
+    unsigned int socket_value_5,
+    unsigned int socket_value_6,
+    unsigned int socket_value_7)
+{
+  wfc_socket_8x07 s = 0;
+
+  s = wfc_socket_pack(s, 0, socket_value_0);
+  s = wfc_socket_pack(s, 1, socket_value_1);
+  s = wfc_socket_pack(s, 2, socket_value_2);
+  s = wfc_socket_pack(s, 3, socket_value_3);
+  s = wfc_socket_pack(s, 4, socket_value_4);
+  s = wfc_socket_pack(s, 5, socket_value_5);
+  s = wfc_socket_pack(s, 6, socket_value_6);
+  s = wfc_socket_pack(s, 7, socket_value_7);
+
+  return s;
+}
+
+/* Get socket[idx] (idx = 0..7) */
+WFC_API WFC_INLINE unsigned int wfc_socket_unpack(wfc_socket_8x07 s, int idx)
+{
+  int shift = idx * 3;
+  return (s >> shift) & 0x7;
+}
+
+/* Reverse order of sockets, up to socket_count */
+WFC_API WFC_INLINE wfc_socket_8x07 wfc_socket_reverse(wfc_socket_8x07 s, unsigned int socket_count)
+{
+  wfc_socket_8x07 r = 0;
+  unsigned int i;
+
+  if (socket_count < 1 || socket_count > WFC_SOCKETS_MAX_VALUES)
+  {
+    return s; /* invalid count, return unchanged */
+  }
+
+  for (i = 0; i < socket_count; ++i)
+  {
+    unsigned int v = wfc_socket_unpack(s, (int)i);
+    
+    r = wfc_socket_pack(r, ((int)socket_count - 1) - (int)i, v);
+  }
+
+  return r;
+}
+
+/* #############################################################################
+ * # Tile initialization and setup
+ * #############################################################################
+ */
+/* Grid topologies. Tiles and grids of the same topology have to be used together */
+#define WFC_TOPOLOGY_SQUARE 0 /* 2D grid with 4 or 8 directions running clockwise from up (default) */
+#define WFC_TOPOLOGY_CUBE 1   /* 3D voxel grid with 6 face directions: up, right, above, down, left, below */
+#define WFC_TOPOLOGY_HEX 2    /* 2D grid of pointy top hexes with 6 directions running clockwise from up-right */
+
+/* Data-oriented SoA tiles struct */
+typedef struct wfc_tiles
+{
+  /* Initialization Flags */
+  unsigned int tiles_initialized;
+  unsigned int tiles_compatible_tiles_computed;
+  unsigned int tile_direction_compatible_masks_words; /* = (tile_count + 31) / 32 */
+
+  /* Configuration */
+  unsigned int tile_capacity;               /* Maximum number of tiles that can be stored */
+  unsigned int tile_count;                  /* Current number of tiles */
+  unsigned int tile_direction_count;        /* Number of directions per tile */
+  unsigned int tile_direction_socket_count; /* Number of socket values per direction */
+  unsigned int tile_topology;               /* WFC_TOPOLOGY_SQUARE (default), WFC_TOPOLOGY_CUBE or WFC_TOPOLOGY_HEX, decides how tiles are rotated */
+
+  /* Data arrays per tile */
+  unsigned int *tile_asset_ids; /* Size: tile_count. User data: Tile ids. These are not used by the actual algorithm  */
+  unsigned int *tile_rotations; /* Size: tile_count. For each tile id what rotation did we apply (0=no rotation, 1=1 rotation, ...) */
+  unsigned int *tile_weights;   /* Size: tile_count. Relative frequency of each tile (default 1), used by WFC_ENTROPY_SHANNON grids */
+
+  /* Data arrays per tile and tile_direction_count */
+  wfc_socket_8x07 *tile_direction_sockets; /* Size: tile_count * tile_direction_count. The sockets (e.g flags) for each direction */
+
+  /* Dynamic bitmask: each tile-direction has mask_words words to represent all compatible tiles */
+  unsigned int *tile_direction_compatible_masks;
+
+  /* Scratch used by wfc_tiles_compute_compatible_tiles: socket hash slots (2 * tile_capacity) and representative tile per tile (tile_capacity) */
+  unsigned int *tile_socket_index;
+
+} wfc_tiles;
+
+#define WFC_TILES_MEMORY_SIZE(tile_capacity, tile_direction_count)                                         \
+  ((unsigned int)(sizeof(unsigned int) * ((tile_capacity) * 3                        /* ids + rotations + weights */ \
+                                          + (tile_capacity) * (tile_direction_count) /* sockets */         \
+                                          + (tile_capacity) * (tile_direction_count) * ((tile_capacity + 31) / 32) /* mask words */ \
+                                          + (tile_capacity) * 3                      /* socket index */)))
+
+WFC_API WFC_INLINE int wfc_tiles_is_compatible_tile(
+    wfc_tiles *tiles,
+    unsigned int tile_a,
+    unsigned int dir,
+    unsigned int tile_b)
+{
+  unsigned int mask_words;
+  unsigned int base;
+  unsigned int *mask;
+  unsigned int word_index;
+  unsigned int bit_index;
+  unsigned int word;
+
+  if (!tiles)
+  {
+    return 0;
+  }
+
+  mask_words = tiles->tile_direction_compatible_masks_words;
+  base = (tile_a * tiles->tile_direction_count + dir) * mask_words;
+  mask = &tiles->tile_direction_compatible_masks[base];
+
+  word_index = tile_b / 32;
+  bit_index = tile_b % 32;
+
+  word = mask[word_index];
+
+  if (word & (1u << bit_index))
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+WFC_API WFC_INLINE int wfc_tiles_initialize(wfc_tiles *tiles, unsigned char *tiles_memory, unsigned int tiles_memory_size)
+{
+  unsigned char *ptr = tiles_memory;
+
+  if (!tiles || !tiles_memory || tiles_memory_size < WFC_TILES_MEMORY_SIZE(tiles->tile_capacity, tiles->tile_direction_count))
+  {
+    return 0;
+  }
+
+  tiles->tile_asset_ids = (unsigned int *)ptr;
+  ptr += sizeof(unsigned int) * tiles->tile_capacity;
+
+  tiles->tile_rotations = (unsigned int *)ptr;
+  ptr += sizeof(unsigned int) * tiles->tile_capacity;
+
+  tiles->tile_weights = (unsigned int *)ptr;
+  ptr += sizeof(unsigned int) * tiles->tile_capacity;
+
+  tiles->tile_direction_sockets = (wfc_socket_8x07 *)ptr;
+  ptr += sizeof(wfc_socket_8x07) * (tiles->tile_capacity * tiles->tile_direction_count);
+
+  tiles->tile_direction_compatible_masks = (unsigned int *)ptr;
+  ptr += sizeof(unsigned int) * (tiles->tile_capacity * tiles->tile_direction_count * ((tiles->tile_capacity + 31) / 32));
+
+  tiles->tile_socket_index = (unsigned int *)ptr;
+
+  tiles->tiles_initialized = 1;
+
+  return 1;
+}
+
+/* Source direction of every direction of a WFC_TOPOLOGY_CUBE tile rotated clockwise around the z axis.
+   The 4 directions of a layer rotate like a 2D tile, above and below keep their sockets */
+static const unsigned int wfc_cube_rotation_source[6] = {4, 0, 2, 1, 3, 5};
+
+WFC_API WFC_INLINE int wfc_tiles_add_tile(
+    wfc_tiles *tiles,
+    unsigned int tile_id,
+    wfc_socket_8x07 *tile_direction_sockets,
+    unsigned int tile_rotations)
+{
+  unsigned int i;
+  unsigned int tile_direction_count;
+
+  /* Invalid arguments */
+  if (!tiles || !tiles->tiles_initialized || tiles->tile_capacity == 0 || !tile_direction_sockets ||
+      (tiles->tile_topology != WFC_TOPOLOGY_SQUARE && tiles->tile_direction_count != 6))
+  {
+    return 0;
+  }
+
+  /* not enough space in buffer */
+  if (tiles->tile_count + 1 + tile_rotations > tiles->tile_capacity)
+  {
+    return 0;
+  }
+
+  tile_direction_count = tiles->tile_direction_count;
+
+  /* Add the tile */
+  tiles->tile_asset_ids[tiles->tile_count] = tile_id;
+  tiles->tile_rotations[tiles->tile_count] = 0;
+  tiles->tile_weights[tiles->tile_count] = 1;
+
+  /* Add the sockets for each direction of the tile */
+  for (i = 0; i < tile_direction_count; ++i)
+  {
+    tiles->tile_direction_sockets[(tiles->tile_count * tile_direction_count) + i] = tile_direction_sockets[i];
+  }
+
+  tiles->tile_count++;
+
+  if (tile_rotations > 0)
+  {
+    unsigned int rotation;
+
+    /* Clamp tile_rotations to tile_direction_count -1 (3 for cube tiles, which only rotate within their layer) */
+    if (tile_rotations > tile_direction_count - 1)
+    {
+      tile_rotations = tile_direction_count - 1;
+    }
+
+    if (tiles->tile_topology == WFC_TOPOLOGY_CUBE && tile_rotations > 3)
+    {
+      tile_rotations = 3;
+    }
+
+    /* Rotate the sockets and add new tiles */
+    for (rotation = 0; rotation < tile_rotations; ++rotation)
+    {
+      tiles->tile_asset_ids[tiles->tile_count] = tile_id;
+      tiles->tile_rotations[tiles->tile_count] = rotation + 1;
+      tiles->tile_weights[tiles->tile_count] = 1;
+
+      /* Rotate the socket values clockwise, by one direction step (60 degrees for hex tiles) */
+      {
+        unsigned int src_base = (tiles->tile_count - 1) * tile_direction_count;
+        unsigned int dst_base = tiles->tile_count * tile_direction_count;
+        unsigned int j;
+
+        for (j = 0; j < tile_direction_count; ++j)
+        {
+          unsigned int src_index = tiles->tile_topology == WFC_TOPOLOGY_CUBE ? wfc_cube_rotation_source[j] : (j + (tile_direction_count - 1)) % tile_direction_count;
+
+          tiles->tile_direction_sockets[dst_base + j] = tiles->tile_direction_sockets[src_base + src_index];
+        }
+      }
+
+      tiles->tile_count++;
+    }
+  }
+
+  return 1;
+}
+
+/* Sets the relative frequency of a tile (rotations are separate tiles). Weights must be at least 1 and the
+   weights of all tiles must sum to less than 2^32, or to at most 65536 for grids drawing from the LCG */
+WFC_API WFC_INLINE int wfc_tiles_set_weight(wfc_tiles *tiles, unsigned int tile_index, unsigned int weight)
+{
+  if (!tiles || !tiles->tiles_initialized || !tiles->tile_socket_index || tile_index >= tiles->tile_count || weight == 0)
+  {
+    return 0;
+  }
+
+  tiles->tile_weights[tile_index] = weight;
+
+  return 1;
+}
+
+/* Finds the hash slot holding the tile whose socket in direction dir equals socket, or the empty slot where it belongs */
+WFC_API WFC_INLINE unsigned int wfc_tiles_socket_index_slot(wfc_tiles *tiles, unsigned int *slots, unsigned int slot_count, unsigned int dir, wfc_socket_8x07 socket)
+{
+  unsigned int slot = (socket * 0x9E3779B1u) % slot_count;
+
+  /* Slots store tile + 1, 0 marks an empty slot. There are twice as many slots as tiles so probing always ends */
+  while (slots[slot] != 0 && tiles->tile_direction_sockets[(slots[slot] - 1) * tiles->tile_direction_count + dir] != socket)
+  {
+    slot = (slot + 1 == slot_count) ? 0 : slot + 1;
+  }
+
+  return slot;
+}
+
+/* Buckets the tiles by their socket in direction dir, the first tile of a bucket represents it and owns the mask
+   of the bucket. slots (2 * tile_count entries) keeps the hash index for wfc_tiles_matched_bucket() */
+WFC_API WFC_INLINE void wfc_tiles_bucket_direction(wfc_tiles *tiles, unsigned int dir, unsigned int *slots, unsigned int *representatives)
+{
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int slot_count = tile_count * 2;
+  unsigned int a;
+
+  for (a = 0; a < slot_count; ++a)
+  {
+    slots[a] = 0;
+  }
+
+  for (a = 0; a < tile_count; ++a)
+  {
+    unsigned int slot = wfc_tiles_socket_index_slot(tiles, slots, slot_count, dir, tiles->tile_direction_sockets[a * tiles->tile_direction_count + dir]);
+
+    if (slots[slot] == 0)
+    {
+      slots[slot] = a + 1;
+    }
+
+    representatives[a] = slots[slot] - 1;
+  }
+}
+
+/* Representative + 1 of the bucket of direction dir that tile b fits with its reversed opposite socket, 0 if none */
+WFC_API WFC_INLINE unsigned int wfc_tiles_matched_bucket(wfc_tiles *tiles, unsigned int dir, unsigned int *slots, unsigned int b)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int opp_dir = (dir + dir_count / 2) % dir_count;
+  wfc_socket_8x07 socket_b = wfc_socket_reverse(tiles->tile_direction_sockets[b * dir_count + opp_dir], tiles->tile_direction_socket_count);
+
+  return slots[wfc_tiles_socket_index_slot(tiles, slots, tiles->tile_count * 2, dir, socket_b)];
+}
+
+/* Clears mask words [word_begin, word_end) of the bucket masks of direction dir */
+WFC_API WFC_INLINE void wfc_tiles_clear_bucket_masks(wfc_tiles *tiles, unsigned int dir, unsigned int *representatives, unsigned int word_begin, unsigned int word_end)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = tiles->tile_direction_compatible_masks_words;
+  unsigned int a, w;
+
+  for (a = 0; a < tiles->tile_count; ++a)
+  {
+    if (representatives[a] == a)
+    {
+      unsigned int *mask = &tiles->tile_direction_compatible_masks[(a * dir_count + dir) * mask_words];
+
+      for (w = word_begin; w < word_end; ++w)
+      {
+        mask[w] = 0;
+      }
+    }
+  }
+}
+
+/* Copies the bucket masks of direction dir to the rows of the other tiles in [tile_begin, tile_end) */
+WFC_API WFC_INLINE void wfc_tiles_copy_bucket_masks(wfc_tiles *tiles, unsigned int dir, unsigned int *representatives, unsigned int tile_begin, unsigned int tile_end)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = tiles->tile_direction_compatible_masks_words;
+  unsigned int a, w;
+
+  for (a = tile_begin; a < tile_end; ++a)
+  {
+    if (representatives[a] != a)
+    {
+      unsigned int *mask = &tiles->tile_direction_compatible_masks[(a * dir_count + dir) * mask_words];
+      unsigned int *source = &tiles->tile_direction_compatible_masks[(representatives[a] * dir_count + dir) * mask_words];
+
+      for (w = 0; w < mask_words; ++w)
+      {
+        mask[w] = source[w];
+      }
+    }
+  }
+}
+
+/* For every tile and direction builds the mask of tiles whose reversed socket in the opposite direction matches.
+   Tiles sharing a socket share the same mask, so per direction the tiles are bucketed by socket value in a
+   hash index: each tile's reversed opposite socket is computed once and sets its bit in the mask of the bucket's
+   representative tile, which is then copied to the other tiles of the bucket. */
+WFC_API WFC_INLINE int wfc_tiles_compute_compatible_tiles(wfc_tiles *tiles)
+{
+  unsigned int tile_count;
+  unsigned int dir_count;
+  unsigned int mask_words;
+  unsigned int *slots;
+  unsigned int *representatives;
+
+  unsigned int b, d;
+
+  /* Tiles wired by wfc_tiles_initialize_static (generated headers, serialized buffers) have no scratch index and are already computed */
+  if (!tiles || !tiles->tiles_initialized || !tiles->tile_direction_compatible_masks || !tiles->tile_socket_index)
+  {
+    return 0;
+  }
+
+  tile_count = tiles->tile_count;
+  dir_count = tiles->tile_direction_count;
+
+  tiles->tile_direction_compatible_masks_words = (tile_count + 31) / 32;
+  mask_words = tiles->tile_direction_compatible_masks_words;
+
+  slots = tiles->tile_socket_index;
+  representatives = slots + tiles->tile_capacity * 2;
+
+  for (d = 0; d < dir_count; ++d)
+  {
+    wfc_tiles_bucket_direction(tiles, d, slots, representatives);
+    wfc_tiles_clear_bucket_masks(tiles, d, representatives, 0, mask_words);
+
+    /* Each tile joins the mask of the bucket matching its reversed opposite socket */
+    for (b = 0; b < tile_count; ++b)
+    {
+      unsigned int match = wfc_tiles_matched_bucket(tiles, d, slots, b);
+
+      if (match != 0)
+      {
+        tiles->tile_direction_compatible_masks[((match - 1) * dir_count + d) * mask_words + (b / 32)] |= 1u << (b % 32);
+      }
+    }
+
+    wfc_tiles_copy_bucket_masks(tiles, d, representatives, 0, tile_count);
+  }
+
+  tiles->tiles_compatible_tiles_computed = 1;
+
+  return 1;
+}
+
+/* Scratch memory of the parallel compatible tiles build: per direction 2 hash slots, the representative and the matched bucket of each tile */
+#define WFC_TILES_PARALLEL_MEMORY_SIZE(tile_capacity, tile_direction_count) \
+  ((unsigned int)(sizeof(unsigned int) * (tile_capacity) * (tile_direction_count) * 4))
+
+#define WFC_TILES_PARALLEL_PHASE_INDEX 0   /* One job per direction: bucket the tiles by socket and match the reversed opposite sockets */
+#define WFC_TILES_PARALLEL_PHASE_SCATTER 1 /* One job per slice of mask words: set the matched tiles in the bucket masks */
+#define WFC_TILES_PARALLEL_PHASE_COPY 2    /* One job per range of tiles: copy the bucket masks to the rows of the other tiles */
+#define WFC_TILES_PARALLEL_PHASES 3
+
+/* Runs job (0 .. job_count - 1) of a phase of the parallel compatible tiles build. All jobs of a phase write
+   disjoint memory and may run concurrently, a phase must be complete before the next one starts.
+   The phases split the steps of wfc_tiles_compute_compatible_tiles across directions, mask words and tiles.
+   The index phase works per direction, so at most tile_direction_count jobs have work in it and the others return.
+   wfc_tiles_compute_compatible_tiles_parallel drives it with threads, any other scheduler works as well. */
+WFC_API WFC_INLINE void wfc_tiles_compute_compatible_tiles_job(wfc_tiles *tiles, unsigned int *memory, unsigned int phase, unsigned int job, unsigned int job_count)
+{
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = tiles->tile_direction_compatible_masks_words;
+  unsigned int *masks = tiles->tile_direction_compatible_masks;
+  unsigned int *representatives = memory + tiles->tile_capacity * dir_count * 2;
+  unsigned int *matches = representatives + tiles->tile_capacity * dir_count;
+
+  unsigned int b, d;
+
+  if (phase == WFC_TILES_PARALLEL_PHASE_INDEX)
+  {
+    for (d = job; d < dir_count; d += job_count)
+    {
+      unsigned int *slots = memory + tiles->tile_capacity * 2 * d;
+
+      wfc_tiles_bucket_direction(tiles, d, slots, &representatives[d * tiles->tile_capacity]);
+
+      for (b = 0; b < tile_count; ++b)
+      {
+        matches[d * tiles->tile_capacity + b] = wfc_tiles_matched_bucket(tiles, d, slots, b);
+      }
+    }
+  }
+  else if (phase == WFC_TILES_PARALLEL_PHASE_SCATTER)
+  {
+    unsigned int word_begin = (mask_words * job) / job_count;
+    unsigned int word_end = (mask_words * (job + 1)) / job_count;
+    unsigned int tile_end = word_end * 32 < tile_count ? word_end * 32 : tile_count;
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      wfc_tiles_clear_bucket_masks(tiles, d, &representatives[d * tiles->tile_capacity], word_begin, word_end);
+
+      for (b = word_begin * 32; b < tile_end; ++b)
+      {
+        unsigned int match = matches[d * tiles->tile_capacity + b];
+
+        if (match != 0)
+        {
+          masks[((match - 1) * dir_count + d) * mask_words + (b / 32)] |= 1u << (b % 32);
+        }
+      }
+    }
+  }
+  else
+  {
+    unsigned int tile_begin = (tile_count * job) / job_count;
+    unsigned int tile_end = (tile_count * (job + 1)) / job_count;
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      wfc_tiles_copy_bucket_masks(tiles, d, &representatives[d * tiles->tile_capacity], tile_begin, tile_end);
+    }
+  }
+}
+
+/* Prepares the parallel compatible tiles build. The set counts as uncomputed until
+   wfc_tiles_compute_compatible_tiles_parallel_end is called after all jobs of all phases ran */
+WFC_API WFC_INLINE int wfc_tiles_compute_compatible_tiles_parallel_begin(wfc_tiles *tiles, unsigned int *memory, unsigned int memory_size)
+{
+  /* Read-only sets (wfc_tiles_initialize_static) have no scratch index and are already computed */
+  if (!tiles || !tiles->tiles_initialized || !tiles->tile_direction_compatible_masks || !tiles->tile_socket_index || !memory ||
+      memory_size < WFC_TILES_PARALLEL_MEMORY_SIZE(tiles->tile_capacity, tiles->tile_direction_count))
+  {
+    return 0;
+  }
+
+  tiles->tile_direction_compatible_masks_words = (tiles->tile_count + 31) / 32;
+  tiles->tiles_compatible_tiles_computed = 0;
+
+  return 1;
+}
+
+/* Marks the masks of a parallel build as computed once every job of the last phase has completed */
+WFC_API WFC_INLINE void wfc_tiles_compute_compatible_tiles_parallel_end(wfc_tiles *tiles)
+{
+  tiles->tiles_compatible_tiles_computed = 1;
+}
+
+#ifdef WFC_THREADS
+typedef struct wfc_tiles_compute_job
+{
+  wfc_tiles *tiles;
+  unsigned int *memory;
+  unsigned int phase;
+  unsigned int job;
+  unsigned int job_count;
+} wfc_tiles_compute_job;
+
+static void wfc_tiles_compute_job_run(void *argument)
+{
+  wfc_tiles_compute_job *job = (wfc_tiles_compute_job *)argument;
+  wfc_tiles_compute_compatible_tiles_job(job->tiles, job->memory, job->phase, job->job, job->job_count);
+}
+
+/* Same result as wfc_tiles_compute_compatible_tiles, computed by thread_count threads (the calling thread included).
+   memory needs WFC_TILES_PARALLEL_MEMORY_SIZE bytes. The index phase keeps at most tile_direction_count threads
+   busy, so the speedup past that comes from the scatter and copy phases only. */
+WFC_API WFC_INLINE int wfc_tiles_compute_compatible_tiles_parallel(wfc_tiles *tiles, unsigned int thread_count, unsigned int *memory, unsigned int memory_size)
+{
+  wfc_thread threads[WFC_THREADS_MAX];
+  wfc_tiles_compute_job jobs[WFC_THREADS_MAX];
+  unsigned int phase;
+  unsigned int started;
+  unsigned int i;
+
+  if (thread_count < 1 || thread_count > WFC_THREADS_MAX || !wfc_tiles_compute_compatible_tiles_parallel_begin(tiles, memory, memory_size))
+  {
+    return 0;
+  }
+
+  for (phase = 0; phase < WFC_TILES_PARALLEL_PHASES; ++phase)
+  {
+    started = 1;
+
+    for (i = 0; i < thread_count; ++i)
+    {
+      jobs[i].tiles = tiles;
+      jobs[i].memory = memory;
+      jobs[i].phase = phase;
+      jobs[i].job = i;
+      jobs[i].job_count = thread_count;
+    }
+
+    /* Run jobs that could not get a thread on the calling thread */
+    for (i = 1; i < thread_count; ++i)
+    {
+      if (!wfc_thread_create(&threads[i], wfc_tiles_compute_job_run, &jobs[i]))
+      {
+        break;
+      }
+
+      started++;
+    }
+
+    for (i = started; i < thread_count; ++i)
+    {
+      wfc_tiles_compute_job_run(&jobs[i]);
+    }
+
+    wfc_tiles_compute_job_run(&jobs[0]);
+
+    for (i = 1; i < started; ++i)
+    {
+      wfc_thread_join(&threads[i]);
+    }
+  }
+
+  wfc_tiles_compute_compatible_tiles_parallel_end(tiles);
+
+  return 1;
+}
+#endif /* WFC_THREADS */
+
+/* Wires tiles to computed arrays that are only read from, e.g. static const arrays emitted by
+   wfc_tiles_generate_header or a serialized buffer. The set is full (tile_capacity == tile_count) and
+   already computed, so wfc_tiles_add_tile and wfc_tiles_compute_compatible_tiles refuse it. */
+WFC_API WFC_INLINE int wfc_tiles_initialize_static(
+    wfc_tiles *tiles,
+    unsigned int tile_count,
+    unsigned int tile_direction_count,
+    unsigned int tile_direction_socket_count,
+    const unsigned int *tile_asset_ids,
+    const unsigned int *tile_rotations,
+    const unsigned int *tile_weights,
+    const wfc_socket_8x07 *tile_direction_sockets,
+    const unsigned int *tile_direction_compatible_masks)
+{
+  if (!tiles || tile_direction_count == 0 || !tile_asset_ids || !tile_rotations || !tile_weights || !tile_direction_sockets || !tile_direction_compatible_masks)
+  {
+    return 0;
+  }
+
+  tiles->tile_capacity = tile_count;
+  tiles->tile_count = tile_count;
+  tiles->tile_direction_count = tile_direction_count;
+  tiles->tile_direction_socket_count = tile_direction_socket_count;
+  tiles->tile_direction_compatible_masks_words = (tile_count + 31) / 32;
+
+  /* The arrays are never written through these pointers */
+  tiles->tile_asset_ids = (unsigned int *)tile_asset_ids;
+  tiles->tile_rotations = (unsigned int *)tile_rotations;
+  tiles->tile_weights = (unsigned int *)tile_weights;
+  tiles->tile_direction_sockets = (wfc_socket_8x07 *)tile_direction_sockets;
+  tiles->tile_direction_compatible_masks = (unsigned int *)tile_direction_compatible_masks;
+  tiles->tile_socket_index = (unsigned int *)0;
+
+  tiles->tiles_initialized = 1;
+  tiles->tiles_compatible_tiles_computed = 1;
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Tiles serialization
+ * #############################################################################
+ */
+/* A computed tile set stored as a header followed by the tile arrays packed for tile_count tiles:
+   asset ids, rotations, weights, direction sockets and compatible masks. All fields are native endian unsigned ints
+   and contain no pointers, a buffer from a different endianness fails the magic check. */
+#define WFC_TILES_SERIALIZED_MAGIC 0x54434657u /* "WFCT" */
+#define WFC_TILES_SERIALIZED_VERSION 2 /* 2: tile weights */
+
+typedef struct wfc_tiles_serialized_header
+{
+  unsigned int magic;
+  unsigned int version;
+  unsigned int tile_count;
+  unsigned int tile_direction_count;
+  unsigned int tile_direction_socket_count;
+  unsigned int tile_direction_compatible_masks_words;
+  unsigned int data_size; /* Bytes following the header */
+  unsigned int reserved;
+
+} wfc_tiles_serialized_header;
+
+/* Number of bytes wfc_tiles_serialize writes, 0 if the compatible tiles are not computed yet */
+WFC_API WFC_INLINE unsigned int wfc_tiles_serialized_size(wfc_tiles *tiles)
+{
+  unsigned int tile_count;
+  unsigned int dir_count;
+
+  if (!tiles || !tiles->tiles_initialized || !tiles->tiles_compatible_tiles_computed)
+  {
+    return 0;
+  }
+
+  tile_count = tiles->tile_count;
+  dir_count = tiles->tile_direction_count;
+
+  return (unsigned int)(sizeof(wfc_tiles_serialized_header) +
+                        sizeof(unsigned int) * (tile_count * 3 + tile_count * dir_count + tile_count * dir_count * tiles->tile_direction_compatible_masks_words));
+}
+
+/* Writes the computed tile set into buffer, returns the number of bytes written or 0 on failure */
+WFC_API WFC_INLINE unsigned int wfc_tiles_serialize(wfc_tiles *tiles, unsigned char *buffer, unsigned int buffer_size)
+{
+  wfc_tiles_serialized_header *header = (wfc_tiles_serialized_header *)buffer;
+  unsigned int *data = (unsigned int *)(header + 1);
+  unsigned int size = wfc_tiles_serialized_size(tiles);
+  unsigned int tile_count;
+  unsigned int dir_count;
+  unsigned int i;
+
+  if (size == 0 || !buffer || buffer_size < size)
+  {
+    return 0;
+  }
+
+  tile_count = tiles->tile_count;
+  dir_count = tiles->tile_direction_count;
+
+  header->magic = WFC_TILES_SERIALIZED_MAGIC;
+  header->version = WFC_TILES_SERIALIZED_VERSION;
+  header->tile_count = tile_count;
+  header->tile_direction_count = dir_count;
+  header->tile_direction_socket_count = tiles->tile_direction_socket_count;
+  header->tile_direction_compatible_masks_words = tiles->tile_direction_compatible_masks_words;
+  header->data_size = size - (unsigned int)sizeof(wfc_tiles_serialized_header);
+  header->reserved = 0;
+
+  for (i = 0; i < tile_count; ++i)
+  {
+    *data++ = tiles->tile_asset_ids[i];
+  }
+
+  for (i = 0; i < tile_count; ++i)
+  {
+    *data++ = tiles->tile_rotations[i];
+  }
+
+  for (i = 0; i < tile_count; ++i)
+  {
+    *data++ = tiles->tile_weights[i];
+  }
+
+  for (i = 0; i < tile_count * dir_count; ++i)
+  {
+    *data++ = tiles->tile_direction_sockets[i];
+  }
+
+  for (i = 0; i < tile_count * dir_count * tiles->tile_direction_compatible_masks_words; ++i)
+  {
+    *data++ = tiles->tile_direction_compatible_masks[i];
+  }
+
+  return size;
+}
+
+/* Points tiles into a serialized buffer (e.g. a memory-mapped file) without copying or recomputing anything.
+   The buffer must be 4 byte aligned and outlive the tiles. The loaded set is full (tile_capacity == tile_count)
+   and only read from, so the buffer can be mapped read-only. */
+WFC_API WFC_INLINE int wfc_tiles_deserialize(wfc_tiles *tiles, unsigned char *buffer, unsigned int buffer_size)
+{
+  wfc_tiles_serialized_header *header = (wfc_tiles_serialized_header *)buffer;
+  unsigned int *data;
+
+  if (!tiles || !buffer || buffer_size < sizeof(wfc_tiles_serialized_header))
+  {
+    return 0;
+  }
+
+  /* The size is compared in double precision so that a corrupt header can not wrap the unsigned arithmetic */
+  if (header->magic != WFC_TILES_SERIALIZED_MAGIC ||
+      header->version != WFC_TILES_SERIALIZED_VERSION ||
+      header->tile_direction_count == 0 ||
+      header->tile_direction_compatible_masks_words != (header->tile_count + 31) / 32 ||
+      (double)header->data_size != (double)sizeof(unsigned int) * (double)header->tile_count * (3.0 + (double)header->tile_direction_count * (1.0 + (double)header->tile_direction_compatible_masks_words)) ||
+      buffer_size - sizeof(wfc_tiles_serialized_header) < header->data_size)
+  {
+    return 0;
+  }
+
+  data = (unsigned int *)(header + 1);
+
+  return wfc_tiles_initialize_static(
+      tiles,
+      header->tile_count,
+      header->tile_direction_count,
+      header->tile_direction_socket_count,
+      data,
+      data + header->tile_count,
+      data + header->tile_count * 2,
+      data + header->tile_count * 3,
+      data + header->tile_count * (3 + header->tile_direction_count));
+}
+
+/* #############################################################################
+ * # Tiles header generator
+ * #############################################################################
+ */
+/* Appends text to the generator output. Only what fits into the buffer is written but the position always advances */
+WFC_API WFC_INLINE void wfc_text_append(unsigned char *buffer, unsigned int buffer_size, unsigned int *position, char *text)
+{
+  while (*text)
+  {
+    if (*position < buffer_size)
+    {
+      buffer[*position] = (unsigned char)*text;
+    }
+
+    (*position)++;
+    text++;
+  }
+}
+
+/* Appends the include guard WFC_TILES_<NAME>_H of a generated header */
+WFC_API WFC_INLINE void wfc_text_append_guard(unsigned char *buffer, unsigned int buffer_size, unsigned int *position, char *name)
+{
+  char upper[2];
+
+  upper[1] = '\0';
+
+  wfc_text_append(buffer, buffer_size, position, "WFC_TILES_");
+
+  for (; *name; ++name)
+  {
+    upper[0] = (*name >= 'a' && *name <= 'z') ? (char)(*name - 'a' + 'A') : *name;
+    wfc_text_append(buffer, buffer_size, position, upper);
+  }
+
+  wfc_text_append(buffer, buffer_size, position, "_H");
+}
+
+/* Appends value as a C89 unsigned literal, hex values keep all 8 digits so that mask rows line up */
+WFC_API WFC_INLINE void wfc_text_append_uint(unsigned char *buffer, unsigned int buffer_size, unsigned int *position, unsigned int value, int hex)
+{
+  char digits[16];
+  int i = 15;
+
+  digits[i--] = '\0';
+  digits[i--] = 'u';
+
+  if (hex)
+  {
+    int d;
+
+    for (d = 0; d < 8; ++d)
+    {
+      digits[i--] = "0123456789ABCDEF"[value & 0xF];
+      value >>= 4;
+    }
+
+    digits[i--] = 'x';
+    digits[i--] = '0';
+  }
+  else
+  {
+    do
+    {
+      digits[i--] = (char)('0' + (value % 10));
+      value /= 10;
+    } while (value);
+  }
+
+  wfc_text_append(buffer, buffer_size, position, &digits[i + 1]);
+}
+
+WFC_API WFC_INLINE void wfc_text_append_array(
+    unsigned char *buffer,
+    unsigned int buffer_size,
+    unsigned int *position,
+    char *type,
+    char *name,
+    char *suffix,
+    unsigned int *values,
+    unsigned int count,
+    int hex)
+{
+  unsigned int i;
+
+  wfc_text_append(buffer, buffer_size, position, "static const ");
+  wfc_text_append(buffer, buffer_size, position, type);
+  wfc_text_append(buffer, buffer_size, position, " ");
+  wfc_text_append(buffer, buffer_size, position, name);
+  wfc_text_append(buffer, buffer_size, position, suffix);
+  wfc_text_append(buffer, buffer_size, position, "[");
+  wfc_text_append_uint(buffer, buffer_size, position, count, 0);
+  wfc_text_append(buffer, buffer_size, position, "] = {");
+
+  for (i = 0; i < count; ++i)
+  {
+    wfc_text_append(buffer, buffer_size, position, (i % 8 == 0) ? "\n    " : " ");
+    wfc_text_append_uint(buffer, buffer_size, position, values[i], hex);
+
+    if (i + 1 < count)
+    {
+      wfc_text_append(buffer, buffer_size, position, ",");
+    }
+  }
+
+  wfc_text_append(buffer, buffer_size, position, "};\n\n");
+}
+
+/* Writes a C89 header that holds the computed tile set in static const arrays (asset ids, rotations, weights, sockets
+   and compatible masks) and a <name>_tiles_initialize(wfc_tiles *) function wiring a wfc_tiles to them, so the rule set
+   lives in read-only memory with no startup cost. The generated header expects wfc.h to be included before it.
+   name must be a C identifier. Like snprintf it returns the full length of the header (not null terminated) and
+   writes only what fits into buffer, so calling it with a 0 sized buffer returns the size to allocate.
+   Returns 0 on invalid arguments. */
+WFC_API WFC_INLINE unsigned int wfc_tiles_generate_header(wfc_tiles *tiles, char *name, unsigned char *buffer, unsigned int buffer_size)
+{
+  unsigned int position = 0;
+  unsigned int tile_count;
+  unsigned int dir_count;
+  char *c;
+
+  if (!tiles || !tiles->tiles_initialized || !tiles->tiles_compatible_tiles_computed || tiles->tile_count == 0 || !name || !*name ||
+      (*name >= '0' && *name <= '9'))
+  {
+    return 0;
+  }
+
+  for (c = name; *c; ++c)
+  {
+    if (!((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || *c == '_'))
+    {
+      return 0;
+    }
+  }
+
+  tile_count = tiles->tile_count;
+  dir_count = tiles->tile_direction_count;
+
+  wfc_text_append(buffer, buffer_size, &position, "/* Generated by wfc_tiles_generate_header, do not edit. Include wfc.h before this file. */\n");
+  wfc_text_append(buffer, buffer_size, &position, "#ifndef ");
+  wfc_text_append_guard(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "\n#define ");
+  wfc_text_append_guard(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "\n\n");
+
+  wfc_text_append_array(buffer, buffer_size, &position, "unsigned int", name, "_asset_ids", tiles->tile_asset_ids, tile_count, 0);
+  wfc_text_append_array(buffer, buffer_size, &position, "unsigned int", name, "_rotations", tiles->tile_rotations, tile_count, 0);
+  wfc_text_append_array(buffer, buffer_size, &position, "unsigned int", name, "_weights", tiles->tile_weights, tile_count, 0);
+  wfc_text_append_array(buffer, buffer_size, &position, "wfc_socket_8x07", name, "_sockets", tiles->tile_direction_sockets, tile_count * dir_count, 1);
+  wfc_text_append_array(buffer, buffer_size, &position, "unsigned int", name, "_masks", tiles->tile_direction_compatible_masks,
+                        tile_count * dir_count * tiles->tile_direction_compatible_masks_words, 1);
+
+  wfc_text_append(buffer, buffer_size, &position, "WFC_API WFC_INLINE int ");
+  wfc_text_append(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "_tiles_initialize(wfc_tiles *tiles)\n{\n  return wfc_tiles_initialize_static(tiles, ");
+  wfc_text_append_uint(buffer, buffer_size, &position, tile_count, 0);
+  wfc_text_append(buffer, buffer_size, &position, ", ");
+  wfc_text_append_uint(buffer, buffer_size, &position, dir_count, 0);
+  wfc_text_append(buffer, buffer_size, &position, ", ");
+  wfc_text_append_uint(buffer, buffer_size, &position, tiles->tile_direction_socket_count, 0);
+  wfc_text_append(buffer, buffer_size, &position, ", ");
+  wfc_text_append(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "_asset_ids, ");
+  wfc_text_append(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "_rotations, ");
+  wfc_text_append(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "_weights, ");
+  wfc_text_append(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "_sockets, ");
+  wfc_text_append(buffer, buffer_size, &position, name);
+  wfc_text_append(buffer, buffer_size, &position, "_masks);\n}\n\n#endif\n");
+
+  return position;
+}
+
+/* #############################################################################
+ * # Grid initialization and setup
+ * #############################################################################
+ */
+/* Cell selection strategies used by wfc() to find the next cell to collapse */
+#define WFC_SELECTION_LINEAR_SCAN 0 /* Rescan all cells on every iteration (default, no extra memory) */
+#define WFC_SELECTION_MIN_HEAP 1    /* Indexed min-heap on (entropy count, cell index). Needs WFC_GRID_HEAP_MEMORY_SIZE */
+
+/* Constraint propagation strategies used by wfc() after a cell has been collapsed */
+#define WFC_PROPAGATION_NEIGHBOURS 0 /* Filter the direct neighbours of the collapsed cell only (default) */
+#define WFC_PROPAGATION_WORKLIST 1   /* AC-3 style cascade until a fixpoint. Needs WFC_GRID_WORKLIST_MEMORY_SIZE */
+#define WFC_PROPAGATION_SUPPORT 2    /* AC-4 style support counters, same results as the worklist. Needs WFC_GRID_SUPPORT_MEMORY_SIZE */
+
+/* What lies past the grid edges */
+#define WFC_BOUNDARY_BOUNDED 0  /* Nothing, edge cells have fewer neighbours (default) */
+#define WFC_BOUNDARY_PERIODIC 1 /* The opposite edge: the grid wraps around like a torus, every axis needs at least 2 cells. Needs WFC_GRID_WRAP_MEMORY_SIZE */
+
+/* Neighbour lookup used by the propagation */
+#define WFC_NEIGHBOURS_COMPUTE 0 /* Decode the cell coordinates on every lookup (default, no extra memory) */
+#define WFC_NEIGHBOURS_TABLE 1   /* Precomputed neighbour per cell and direction, a lookup is a single load. Needs WFC_GRID_NEIGHBOUR_MEMORY_SIZE */
+
+/* Most directions a WFC_TOPOLOGY_SQUARE grid has */
+#define WFC_GRID_DIRECTIONS_MAX 8
+
+/* Cell entropy used to order the cells and to choose their tile */
+#define WFC_ENTROPY_COUNT 0   /* Fewest remaining tiles first, every remaining tile is equally likely (default) */
+#define WFC_ENTROPY_SHANNON 1 /* Lowest Shannon entropy of the tile weights first, tiles are chosen by weight. Needs WFC_GRID_ENTROPY_MEMORY_SIZE */
+
+/* Mantissa bits of the log2 table used by WFC_ENTROPY_SHANNON. Weight sums below 2^(bits + 1) are looked up exactly */
+#define WFC_LOG2_TABLE_BITS 8
+#define WFC_LOG2_TABLE_SIZE (1u << WFC_LOG2_TABLE_BITS)
+
+/* Marks a cell that is not in the heap / no cell found */
+#define WFC_CELL_NONE 0xFFFFFFFF
+
+/* Type of the per cell entropy count, it limits the number of tiles a grid can hold.
+   Define WFC_COUNT_TYPE as unsigned char to save memory for sets of at most 255 tiles
+   or as unsigned int for sets above 65535 tiles. */
+#ifndef WFC_COUNT_TYPE
+#define WFC_COUNT_TYPE unsigned short
+#endif
+typedef WFC_COUNT_TYPE wfc_count;
+
+/* Tile sets of up to 32 tiles keep a cell's domain in a single mask word and take dedicated code paths without
+   word loops. Define WFC_NO_SINGLE_WORD to always use the generic multi word code. */
+#ifdef WFC_NO_SINGLE_WORD
+#define WFC_SINGLE_WORD(mask_words) 0
+#else
+#define WFC_SINGLE_WORD(mask_words) ((mask_words) == 1)
+#endif
+
+/* Data-oriented SoA grid struct */
+typedef struct wfc_grid
+{
+  /* Configuration */
+  unsigned int rows;             /* Number of grid rows    */
+  unsigned int cols;             /* Number of grid columns */
+  unsigned int layers;           /* Number of grid layers (WFC_TOPOLOGY_CUBE only, 0 = 1) */
+  unsigned int topology;         /* WFC_TOPOLOGY_SQUARE (default), WFC_TOPOLOGY_CUBE or WFC_TOPOLOGY_HEX */
+  unsigned int boundary;         /* WFC_BOUNDARY_BOUNDED (default) or WFC_BOUNDARY_PERIODIC */
+  unsigned int neighbours;       /* WFC_NEIGHBOURS_COMPUTE (default) or WFC_NEIGHBOURS_TABLE */
+  unsigned int selection;        /* WFC_SELECTION_LINEAR_SCAN (default) or WFC_SELECTION_MIN_HEAP */
+  unsigned int propagation;      /* WFC_PROPAGATION_NEIGHBOURS (default), WFC_PROPAGATION_WORKLIST or WFC_PROPAGATION_SUPPORT */
+  unsigned int entropy;          /* WFC_ENTROPY_COUNT (default) or WFC_ENTROPY_SHANNON */
+  unsigned int trail_capacity;   /* Mask word changes the undo trail can hold. 0 disables backtracking (default) */
+  unsigned int backtrack_budget; /* Backtracks allowed per wfc() run before it gives up and returns 0 (0 = unlimited) */
+  wfc_rng *rng;                  /* Random state owned by this solver. 0 uses the global wfc_seed_lcg (default) */
+  volatile unsigned int *cancel; /* wfc() gives up and returns 0 once *cancel is set, e.g. by another thread (0 = never) */
+
+  /* Runtime information */
+  unsigned int cells_processed;    /* The number of cells already processed */
+  unsigned int cell_index_current; /* The current processed cell */
+  unsigned int decisions;          /* Tiles chosen at random during the last wfc() run */
+  unsigned int backtracks;         /* Decisions undone during the last wfc() run */
+  unsigned int trail_high_water;   /* Most trail entries in use at once during the last wfc() run */
+
+  /* The number of unsigned ints needed to store the bitmask for one cell's entropies */
+  unsigned int cell_entropy_mask_words;
+
+  /* Data arrays */
+  unsigned char *cell_collapsed;     /* Is the current cell collapsed? The extra entry is the always collapsed sentinel cell. Size = rows * cols + 1 */
+  wfc_count *cell_entropy_count;     /* How many entropy/options does the cell have? Size = rows * cols */
+  unsigned int *cell_entropy_masks;  /* The entropy bitmasks. Size = rows * cols * cell_entropy_mask_words */
+
+  /* Min-heap of all non-collapsed cells (WFC_SELECTION_MIN_HEAP only).
+     Ties are broken by the lower cell index so the pick order is identical to the linear scan */
+  unsigned int *heap_cells;     /* Heap ordered cell indices. Size = rows * cols */
+  unsigned int *heap_positions; /* Heap slot of each cell or WFC_CELL_NONE. Size = rows * cols */
+  unsigned int heap_size;
+
+  /* Cell worklist (WFC_PROPAGATION_WORKLIST and WFC_PROPAGATION_SUPPORT) */
+  unsigned int *worklist_cells;   /* Cells whose domain shrank and that still have to be propagated. Size = rows * cols */
+  unsigned int *worklist_union;   /* Scratch mask for one cell. Size = cell_entropy_mask_words */
+  unsigned char *worklist_queued; /* Is the cell currently on the worklist? Size = rows * cols */
+  unsigned int worklist_size;
+
+  /* Support counters (WFC_PROPAGATION_SUPPORT only) */
+  unsigned short *support_counts; /* Compatible tiles left in the neighbour per cell, direction and tile. Size = rows * cols * tile_direction_count * tile_count */
+  unsigned int *support_banned;   /* Tiles removed since the cell was last propagated. Size = rows * cols * cell_entropy_mask_words */
+
+  /* Undo trail (trail_capacity > 0 only). Every mask word change after the first decision is recorded
+     so a contradiction can be rolled back to the last decision instead of restarting the whole grid */
+  unsigned int *trail_indices;  /* Index into cell_entropy_masks of each change. Size = trail_capacity */
+  unsigned int *trail_values;   /* Mask word before the change. Size = trail_capacity */
+  unsigned int trail_size;
+  unsigned int trail_overflow;  /* Set once a change could not be recorded, backtracking is impossible afterwards */
+  unsigned int *decision_marks; /* Trail size when the decision was taken. Size = rows * cols */
+  unsigned int *decision_cells; /* Cell collapsed by the decision. Size = rows * cols */
+  unsigned int *decision_tiles; /* Tile chosen by the decision. Size = rows * cols */
+  unsigned int decision_count;
+
+  /* Reciprocals of cols and rows set by wfc_grid_initialize(), the neighbour lookup decodes the cell coordinates with them */
+  wfc_divisor cols_divisor;
+  wfc_divisor rows_divisor;
+
+  /* Wrap tables (WFC_BOUNDARY_PERIODIC only). Entry c + 1 is the index offset of coordinate c wrapped into the grid,
+     for c from -1 to the size of the axis, so a neighbour is the sum of one entry per axis without modulo or branches */
+  unsigned int *wrap_x; /* Size = cols + 2 */
+  unsigned int *wrap_y; /* Size = rows + 2 */
+  unsigned int *wrap_z; /* Size = layers + 2 */
+
+  /* Neighbour table (WFC_NEIGHBOURS_TABLE only) */
+  unsigned int *cell_neighbours; /* Neighbour per cell and direction, the sentinel cell past the edges. Size = rows * cols * tile_direction_count */
+
+  /* Shannon entropy (WFC_ENTROPY_SHANNON only). The weight sums of a cell shrink with every tile removed from it,
+     so the entropy log2(sum w) - sum(w * log2(w)) / sum w never rescans the mask */
+  unsigned int *tile_weights;     /* The tile weights read at wfc_grid_initialize(). Size = tile_count */
+  double *tile_weight_logs;       /* w * log2(w) of every tile. Size = tile_count */
+  double *log2_table;             /* log2(1 + i / WFC_LOG2_TABLE_SIZE). Size = WFC_LOG2_TABLE_SIZE + 1 */
+  double *cell_weight_log_sums;   /* Sum of w * log2(w) over the remaining tiles. Size = rows * cols */
+  double *cell_shannon_entropy;   /* Entropy of the remaining tiles, -1 for a cell without tiles. Size = rows * cols */
+  unsigned int *cell_weight_sums; /* Sum of the weights of the remaining tiles. Size = rows * cols */
+
+} wfc_grid;
+
+#define WFC_GRID_MEMORY_SIZE(rows, cols, tile_count)                                                      \
+  ((unsigned int)(sizeof(unsigned char) * ((rows) * (cols) + 1) /* cell_collapsed + sentinel cell */        \
+                  + sizeof(wfc_count) * ((rows) * (cols)) /* cell_entropy_count */                         \
+                  + sizeof(unsigned int) * ((rows) * (cols)) * ((tile_count + 31) / 32) /* cell_entropy_masks */))
+
+/* Additional grid memory required for WFC_SELECTION_MIN_HEAP */
+#define WFC_GRID_HEAP_MEMORY_SIZE(rows, cols) \
+  ((unsigned int)(sizeof(unsigned int) * ((rows) * (cols)) * 2 /* heap_cells + heap_positions */))
+
+/* Additional grid memory required for WFC_PROPAGATION_WORKLIST */
+#define WFC_GRID_WORKLIST_MEMORY_SIZE(rows, cols, tile_count)                                           \
+  ((unsigned int)(sizeof(unsigned int) * (((rows) * (cols)) /* worklist_cells */                         \
+                                          + ((tile_count + 31) / 32) /* worklist_union */)               \
+                  + sizeof(unsigned char) * ((rows) * (cols)) /* worklist_queued */))
+
+/* Additional grid memory required for WFC_PROPAGATION_SUPPORT (includes the worklist) */
+#define WFC_GRID_SUPPORT_MEMORY_SIZE(rows, cols, tile_count, tile_direction_count)                                     \
+  ((unsigned int)(WFC_GRID_WORKLIST_MEMORY_SIZE(rows, cols, tile_count) +                                              \
+                  sizeof(unsigned short) * ((rows) * (cols)) * (tile_count) * (tile_direction_count) /* support_counts */ \
+                  + sizeof(unsigned int) * ((rows) * (cols)) * ((tile_count + 31) / 32) /* support_banned */))
+
+/* Additional grid memory required for WFC_BOUNDARY_PERIODIC */
+#define WFC_GRID_WRAP_MEMORY_SIZE(rows, cols, layers) \
+  ((unsigned int)(sizeof(unsigned int) * ((rows) + (cols) + (layers) + 6) /* wrap_x + wrap_y + wrap_z */))
+
+/* Additional grid memory required for WFC_NEIGHBOURS_TABLE */
+#define WFC_GRID_NEIGHBOUR_MEMORY_SIZE(rows, cols, tile_direction_count) \
+  ((unsigned int)(sizeof(unsigned int) * ((rows) * (cols)) * (tile_direction_count) /* cell_neighbours */))
+
+/* Additional grid memory required for WFC_ENTROPY_SHANNON. The grid memory has to be 8 byte aligned */
+#define WFC_GRID_ENTROPY_MEMORY_SIZE(rows, cols, tile_count)                                                                  \
+  ((unsigned int)(sizeof(double) * (((rows) * (cols)) * 2 /* cell_weight_log_sums + cell_shannon_entropy */                  \
+                                    + (tile_count) /* tile_weight_logs */ + WFC_LOG2_TABLE_SIZE + 1 /* log2_table */)         \
+                  + sizeof(unsigned int) * ((rows) * (cols)) /* cell_weight_sums */))
+
+/* Additional grid memory required for backtracking (trail_capacity > 0) */
+#define WFC_GRID_TRAIL_MEMORY_SIZE(rows, cols, trail_capacity)                                  \
+  ((unsigned int)(sizeof(unsigned int) * (trail_capacity) * 2 /* trail_indices + trail_values */ \
+                  + sizeof(unsigned int) * ((rows) * (cols)) * 3 /* decision_marks + decision_cells + decision_tiles */))
+
+/* Number of layers, 1 for 2D grids */
+WFC_API WFC_INLINE unsigned int wfc_grid_layer_count(wfc_grid *grid)
+{
+  return (grid->topology == WFC_TOPOLOGY_CUBE && grid->layers > 1) ? grid->layers : 1;
+}
+
+/* Number of cells over all layers */
+WFC_API WFC_INLINE unsigned int wfc_grid_cell_count(wfc_grid *grid)
+{
+  return grid->rows * grid->cols * wfc_grid_layer_count(grid);
+}
+
+WFC_API WFC_INLINE int wfc_grid_index_at(int x, int y, int cols)
+{
+  return (y * cols + x);
+}
+
+WFC_API WFC_INLINE void wfc_grid_coords_at(int index, int cols, int *x, int *y)
+{
+  if (!x || !y)
+  {
+    return; /* invalid input, no-op */
+  }
+
+  *y = index / cols;
+  *x = index % cols;
+}
+
+/* Directions run clockwise starting at up, so the opposite of d is (d + dir_count / 2) % dir_count.
+   8 directions: up, up-right, right, down-right, down, down-left, left, up-left.
+   4 directions use every second entry: up, right, down, left. */
+static const int wfc_direction_dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const int wfc_direction_dy[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+/* WFC_TOPOLOGY_CUBE directions: up, right, above, down, left, below. Up, right, down and left are the 2D directions
+   within a layer, above is the next layer. The opposite of d is again (d + dir_count / 2) % dir_count */
+static const int wfc_cube_dx[6] = {0, 1, 0, 0, -1, 0};
+static const int wfc_cube_dy[6] = {-1, 0, 0, 1, 0, 0};
+static const int wfc_cube_dz[6] = {0, 0, 1, 0, 0, -1};
+
+/* Returns the cell index of (x, y, z): row after row, layer after layer. 2D grids use z = 0 */
+WFC_API WFC_INLINE unsigned int wfc_grid_cell_index(wfc_grid *grid, unsigned int x, unsigned int y, unsigned int z)
+{
+  return (z * grid->rows + y) * grid->cols + x;
+}
+
+/* Inverse of wfc_grid_cell_index() for an initialized grid, without a divide instruction */
+WFC_API WFC_INLINE void wfc_grid_cell_coords(wfc_grid *grid, unsigned int index, unsigned int *x, unsigned int *y, unsigned int *z)
+{
+  unsigned int row = wfc_divide(&grid->cols_divisor, index); /* Row counted over all layers */
+
+  *x = index - row * grid->cols;
+  *z = wfc_divide(&grid->rows_divisor, row);
+  *y = row - *z * grid->rows;
+}
+
+/* Neighbour of a cell of a WFC_TOPOLOGY_CUBE grid or -1 if there is none */
+WFC_API WFC_INLINE int wfc_grid_neighbour_index_cube(wfc_grid *grid, int index, unsigned int dir)
+{
+  unsigned int x, y, z;
+
+  if (dir >= 6)
+  {
+    return -1;
+  }
+
+  wfc_grid_cell_coords(grid, (unsigned int)index, &x, &y, &z);
+
+  if (grid->boundary == WFC_BOUNDARY_PERIODIC)
+  {
+    return (int)(grid->wrap_x[x + (unsigned int)wfc_cube_dx[dir] + 1] + grid->wrap_y[y + (unsigned int)wfc_cube_dy[dir] + 1] +
+                 grid->wrap_z[z + (unsigned int)wfc_cube_dz[dir] + 1]);
+  }
+
+  /* Stepping below 0 wraps around to a coordinate past the grid */
+  x += (unsigned int)wfc_cube_dx[dir];
+  y += (unsigned int)wfc_cube_dy[dir];
+  z += (unsigned int)wfc_cube_dz[dir];
+
+  if (x >= grid->cols || y >= grid->rows || z >= wfc_grid_layer_count(grid))
+  {
+    return -1;
+  }
+
+  return (int)wfc_grid_cell_index(grid, x, y, z);
+}
+
+/* WFC_TOPOLOGY_HEX grids use odd-r offset coordinates: the hexes of odd rows are shifted half a cell to the right.
+   Directions: up-right, right, down-right, down-left, left, up-left, so the opposite of d is (d + 3) % 6.
+   The column step of the diagonal directions depends on the row parity, so there is one table per parity.
+   The row, and with it the parity, is decoded with the grid's column reciprocal like the square and cube lookups,
+   so a hex lookup costs a wide multiply instead of a divide instruction */
+static const int wfc_hex_dx[2][6] = {{0, 1, 0, -1, -1, -1}, {1, 1, 1, 0, -1, 0}};
+static const int wfc_hex_dy[6] = {-1, 0, 1, 1, 0, -1};
+
+/* Neighbour of a cell of a WFC_TOPOLOGY_HEX grid or -1 if there is none */
+WFC_API WFC_INLINE int wfc_grid_neighbour_index_hex(wfc_grid *grid, int index, unsigned int dir)
+{
+  unsigned int x, y;
+  const int *dx;
+
+  if (dir >= 6)
+  {
+    return -1;
+  }
+
+  y = wfc_divide(&grid->cols_divisor, (unsigned int)index);
+  x = (unsigned int)index - y * grid->cols;
+  dx = wfc_hex_dx[y & 1u];
+
+  if (grid->boundary == WFC_BOUNDARY_PERIODIC)
+  {
+    return (int)(grid->wrap_x[x + (unsigned int)dx[dir] + 1] + grid->wrap_y[y + (unsigned int)wfc_hex_dy[dir] + 1]);
+  }
+
+  /* Stepping below 0 wraps around to a coordinate past the grid */
+  if (x + (unsigned int)dx[dir] >= grid->cols || y + (unsigned int)wfc_hex_dy[dir] >= grid->rows)
+  {
+    return -1;
+  }
+
+  return index + wfc_hex_dy[dir] * (int)grid->cols + dx[dir];
+}
+
+/* Returns the neighbour of a cell of an initialized grid in direction dir or -1 if there is none.
+   The coordinates are decoded with the grid's reciprocals, so a lookup needs no divide instruction and no memory */
+WFC_API WFC_INLINE int wfc_grid_neighbour_index(wfc_grid *grid, int index, unsigned int dir, unsigned int dir_count)
+{
+  unsigned int x, y;
+
+  if (grid->topology == WFC_TOPOLOGY_CUBE)
+  {
+    return wfc_grid_neighbour_index_cube(grid, index, dir);
+  }
+
+  if (grid->topology == WFC_TOPOLOGY_HEX)
+  {
+    return wfc_grid_neighbour_index_hex(grid, index, dir);
+  }
+
+  if (dir_count != 8)
+  {
+    if (dir >= 4)
+    {
+      return -1; /* not handled */
+    }
+
+    dir *= 2;
+  }
+
+  y = wfc_divide(&grid->cols_divisor, (unsigned int)index);
+  x = (unsigned int)index - y * grid->cols;
+
+  if (grid->boundary == WFC_BOUNDARY_PERIODIC)
+  {
+    return (int)(grid->wrap_x[x + (unsigned int)wfc_direction_dx[dir] + 1] + grid->wrap_y[y + (unsigned int)wfc_direction_dy[dir] + 1]);
+  }
+
+  /* Stepping below 0 wraps around to a coordinate past the grid */
+  x += (unsigned int)wfc_direction_dx[dir];
+  y += (unsigned int)wfc_direction_dy[dir];
+
+  if (x >= grid->cols || y >= grid->rows)
+  {
+    return -1;
+  }
+
+  return (int)(y * grid->cols + x);
+}
+
+/* The neighbours of a cell in direction order, the sentinel cell (index rows * cols, always collapsed) past the edges,
+   so the propagation skips edges and collapsed neighbours with a single test. Returns the cell's row of the neighbour
+   table or, with WFC_NEIGHBOURS_COMPUTE, buffer filled with dir_count entries */
+WFC_API WFC_INLINE unsigned int *wfc_grid_cell_neighbours(wfc_grid *grid, unsigned int index, unsigned int dir_count, unsigned int *buffer)
+{
+  unsigned int sentinel;
+  unsigned int d;
+
+  if (grid->neighbours == WFC_NEIGHBOURS_TABLE)
+  {
+    return &grid->cell_neighbours[index * dir_count];
+  }
+
+  sentinel = wfc_grid_cell_count(grid);
+
+  for (d = 0; d < dir_count; ++d)
+  {
+    int neighbour_index = wfc_grid_neighbour_index(grid, (int)index, d, dir_count);
+
+    buffer[d] = neighbour_index < 0 ? sentinel : (unsigned int)neighbour_index;
+  }
+
+  return buffer;
+}
+
+/* log2(x) for x > 0 without libm: x = 2^e * m with m in [1, 2) and log2(m) = 2 / ln(2) * atanh((m - 1) / (m + 1)) */
+WFC_API WFC_INLINE double wfc_log2(double x)
+{
+  double e = 0.0;
+  double z, z2, term;
+  double sum = 0.0;
+  double n;
+
+  while (x >= 2.0)
+  {
+    x *= 0.5;
+    e += 1.0;
+  }
+
+  while (x < 1.0)
+  {
+    x *= 2.0;
+    e -= 1.0;
+  }
+
+  z = (x - 1.0) / (x + 1.0);
+  z2 = z * z;
+  term = z;
+
+  /* z <= 1/3, so 20 terms are below double precision */
+  for (n = 1.0; n < 40.0; n += 2.0)
+  {
+    sum += term / n;
+    term *= z2;
+  }
+
+  return e + 2.8853900817779268 * sum;
+}
+
+/* log2 of a weight sum from the grid's table, linearly interpolated between the mantissa steps */
+WFC_API WFC_INLINE double wfc_grid_log2_uint(wfc_grid *grid, unsigned int x)
+{
+  unsigned int e = 0;
+  unsigned int v = x;
+  unsigned int shift;
+  double *table;
+
+  if (v >> 16)
+  {
+    v >>= 16;
+    e += 16;
+  }
+  if (v >> 8)
+  {
+    v >>= 8;
+    e += 8;
+  }
+  if (v >> 4)
+  {
+    v >>= 4;
+    e += 4;
+  }
+  if (v >> 2)
+  {
+    v >>= 2;
+    e += 2;
+  }
+  if (v >> 1)
+  {
+    e += 1;
+  }
+
+  /* x = 2^e * (1 + fraction / WFC_LOG2_TABLE_SIZE), exact while the fraction fits the table */
+  if (e <= WFC_LOG2_TABLE_BITS)
+  {
+    return (double)e + grid->log2_table[(x - (1u << e)) << (WFC_LOG2_TABLE_BITS - e)];
+  }
+
+  shift = e - WFC_LOG2_TABLE_BITS;
+  table = &grid->log2_table[(x >> shift) & (WFC_LOG2_TABLE_SIZE - 1)];
+
+  return (double)e + table[0] + (table[1] - table[0]) * ((double)(x & ((1u << shift) - 1)) / (double)(1u << shift));
+}
+
+/* Shannon entropy of the remaining tiles of a cell from its weight sums. Cells without tiles sort first */
+WFC_API WFC_INLINE double wfc_grid_shannon_entropy(wfc_grid *grid, unsigned int cell_index, unsigned int entropy_count)
+{
+  unsigned int weight_sum = grid->cell_weight_sums[cell_index];
+
+  if (entropy_count <= 1)
+  {
+    return entropy_count ? 0.0 : -1.0;
+  }
+
+  return wfc_grid_log2_uint(grid, weight_sum) - grid->cell_weight_log_sums[cell_index] / (double)weight_sum;
+}
+
+/* Subtracts the tiles removed from mask word word_index of a cell from its weight sums */
+WFC_API WFC_INLINE void wfc_grid_remove_weights(wfc_grid *grid, unsigned int cell_index, unsigned int word_index, unsigned int removed)
+{
+  while (removed)
+  {
+    unsigned int tile = word_index * 32 + wfc_bit_scan_forward(removed);
+
+    grid->cell_weight_sums[cell_index] -= grid->tile_weights[tile];
+    grid->cell_weight_log_sums[cell_index] -= grid->tile_weight_logs[tile];
+
+    removed &= removed - 1;
+  }
+}
+
+/* Recomputes the weight sums of a cell from its mask, used after masks have been restored */
+WFC_API WFC_INLINE void wfc_grid_recount_weights(wfc_grid *grid, unsigned int cell_index)
+{
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int weight_sum = 0;
+  double weight_log_sum = 0.0;
+  unsigned int k;
+
+  for (k = 0; k < mask_words; ++k)
+  {
+    unsigned int word = grid->cell_entropy_masks[cell_index * mask_words + k];
+
+    while (word)
+    {
+      unsigned int tile = k * 32 + wfc_bit_scan_forward(word);
+
+      weight_sum += grid->tile_weights[tile];
+      weight_log_sum += grid->tile_weight_logs[tile];
+
+      word &= word - 1;
+    }
+  }
+
+  grid->cell_weight_sums[cell_index] = weight_sum;
+  grid->cell_weight_log_sums[cell_index] = weight_log_sum;
+}
+
+/* Seeds the support counters of a grid where every cell still allows every tile.
+   Tiles without any compatible tile towards an existing neighbour are banned right away and
+   propagated by the next wfc() run. */
+WFC_API WFC_INLINE void wfc_grid_initialize_supports(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int grid_size = wfc_grid_cell_count(grid);
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int block_size = tile_count * dir_count;
+  unsigned int i, t, d, k;
+
+  if (!tiles->tiles_compatible_tiles_computed)
+  {
+    wfc_tiles_compute_compatible_tiles(tiles);
+  }
+
+  /* A full neighbour supports tile t in direction d with every tile of its compatible mask */
+  for (t = 0; t < tile_count; ++t)
+  {
+    for (d = 0; d < dir_count; ++d)
+    {
+      unsigned int *compatible_mask = &tiles->tile_direction_compatible_masks[(t * dir_count + d) * mask_words];
+      unsigned int count = 0;
+
+      for (k = 0; k < mask_words; ++k)
+      {
+        count += wfc_popcount(compatible_mask[k]);
+      }
+
+      grid->support_counts[d * tile_count + t] = (unsigned short)count;
+    }
+  }
+
+  for (i = 0; i < grid_size; ++i)
+  {
+    for (k = 0; k < block_size; ++k)
+    {
+      grid->support_counts[i * block_size + k] = grid->support_counts[k];
+    }
+
+    for (k = 0; k < mask_words; ++k)
+    {
+      grid->support_banned[i * mask_words + k] = 0;
+    }
+  }
+
+  for (i = 0; i < grid_size; ++i)
+  {
+    unsigned int *cell_mask = &grid->cell_entropy_masks[i * mask_words];
+    unsigned int removed = 0;
+
+    for (t = 0; t < tile_count; ++t)
+    {
+      for (d = 0; d < dir_count; ++d)
+      {
+        if (grid->support_counts[d * tile_count + t] == 0 && wfc_grid_neighbour_index(grid, (int)i, d, dir_count) >= 0)
+        {
+          cell_mask[t / 32] &= ~(1u << (t % 32));
+          grid->support_banned[i * mask_words + t / 32] |= 1u << (t % 32);
+          removed++;
+          break;
+        }
+      }
+    }
+
+    if (removed)
+    {
+      grid->cell_entropy_count[i] = (wfc_count)(tile_count - removed);
+
+      if (grid->entropy == WFC_ENTROPY_SHANNON)
+      {
+        wfc_grid_recount_weights(grid, i);
+        grid->cell_shannon_entropy[i] = wfc_grid_shannon_entropy(grid, i, tile_count - removed);
+      }
+
+      grid->worklist_queued[i] = 1;
+      grid->worklist_cells[grid->worklist_size++] = i;
+    }
+  }
+}
+
+WFC_API WFC_INLINE unsigned int wfc_grid_memory_size(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int rows = grid->rows * wfc_grid_layer_count(grid); /* The layers are stacked rows */
+  unsigned int size = WFC_GRID_MEMORY_SIZE(rows, grid->cols, tiles->tile_count);
+
+  if (grid->selection == WFC_SELECTION_MIN_HEAP)
+  {
+    size += WFC_GRID_HEAP_MEMORY_SIZE(rows, grid->cols);
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_WORKLIST)
+  {
+    size += WFC_GRID_WORKLIST_MEMORY_SIZE(rows, grid->cols, tiles->tile_count);
+  }
+  else if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    size += WFC_GRID_SUPPORT_MEMORY_SIZE(rows, grid->cols, tiles->tile_count, tiles->tile_direction_count);
+  }
+
+  if (grid->trail_capacity > 0)
+  {
+    size += WFC_GRID_TRAIL_MEMORY_SIZE(rows, grid->cols, grid->trail_capacity);
+  }
+
+  if (grid->boundary == WFC_BOUNDARY_PERIODIC)
+  {
+    size += WFC_GRID_WRAP_MEMORY_SIZE(grid->rows, grid->cols, wfc_grid_layer_count(grid));
+  }
+
+  if (grid->neighbours == WFC_NEIGHBOURS_TABLE)
+  {
+    size += WFC_GRID_NEIGHBOUR_MEMORY_SIZE(rows, grid->cols, tiles->tile_direction_count);
+  }
+
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    size += WFC_GRID_ENTROPY_MEMORY_SIZE(rows, grid->cols, tiles->tile_count);
+  }
+
+  return size;
+}
+
+WFC_API WFC_INLINE int wfc_grid_initialize(wfc_grid *grid, wfc_tiles *tiles, unsigned char *grid_memory, unsigned int grid_memory_size)
+{
+  unsigned char *ptr = grid_memory;
+
+  unsigned int grid_size;
+  unsigned int tile_count;
+  unsigned int weight_sum = 0;
+  double weight_log_sum = 0.0;
+  unsigned int i;
+  unsigned int j;
+
+  if (!grid || !tiles || !grid_memory || grid_memory_size < wfc_grid_memory_size(grid, tiles))
+  {
+    return 0;
+  }
+
+  /* The weight sum of a cell has to fit an unsigned int */
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    for (i = 0; i < tiles->tile_count; ++i)
+    {
+      if (tiles->tile_weights[i] == 0 || weight_sum + tiles->tile_weights[i] < weight_sum)
+      {
+        return 0;
+      }
+
+      weight_sum += tiles->tile_weights[i];
+    }
+
+    /* The LCG range reduction only draws 16 bits, tiles past the first 65536 weights could never be picked */
+    if (weight_sum > 65536 && (!grid->rng || WFC_RNG == WFC_RNG_LCG))
+    {
+      return 0;
+    }
+  }
+
+  /* The entropy count (and the support counters) have to hold every tile */
+  if (tiles->tile_count > (unsigned int)(wfc_count)-1 ||
+      (grid->propagation == WFC_PROPAGATION_SUPPORT && tiles->tile_count > (unsigned int)(unsigned short)-1))
+  {
+    return 0;
+  }
+
+  /* Cube and hex grids need 6 direction tiles, square grids have at most 8 neighbours */
+  if ((grid->topology != WFC_TOPOLOGY_SQUARE && tiles->tile_direction_count != 6) || tiles->tile_direction_count > WFC_GRID_DIRECTIONS_MAX)
+  {
+    return 0;
+  }
+
+  /* A periodic axis of size 1 makes a cell its own neighbour, a constraint the propagation skips as the cell is
+     collapsed by then. Odd rows of hex grids are shifted, so the rows only line up across the wrap for an even row count */
+  if (grid->boundary == WFC_BOUNDARY_PERIODIC &&
+      (grid->cols < 2 || grid->rows < 2 || (grid->topology == WFC_TOPOLOGY_CUBE && wfc_grid_layer_count(grid) < 2) ||
+       (grid->topology == WFC_TOPOLOGY_HEX && grid->rows % 2)))
+  {
+    return 0;
+  }
+
+  grid_size = wfc_grid_cell_count(grid);
+  tile_count = tiles->tile_count;
+
+  grid->cell_entropy_mask_words = (tile_count + 31) / 32;
+
+  wfc_divisor_initialize(&grid->cols_divisor, grid->cols);
+  wfc_divisor_initialize(&grid->rows_divisor, grid->rows);
+
+  /* Double arrays first, then the word sized arrays so they stay aligned regardless of the grid size */
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    grid->cell_weight_log_sums = (double *)ptr;
+    ptr += sizeof(double) * grid_size;
+
+    grid->cell_shannon_entropy = (double *)ptr;
+    ptr += sizeof(double) * grid_size;
+
+    grid->tile_weight_logs = (double *)ptr;
+    ptr += sizeof(double) * tile_count;
+
+    grid->log2_table = (double *)ptr;
+    ptr += sizeof(double) * (WFC_LOG2_TABLE_SIZE + 1);
+
+    grid->cell_weight_sums = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size;
+
+    grid->tile_weights = tiles->tile_weights;
+
+    for (i = 0; i <= WFC_LOG2_TABLE_SIZE; ++i)
+    {
+      grid->log2_table[i] = wfc_log2(1.0 + (double)i / (double)WFC_LOG2_TABLE_SIZE);
+    }
+
+    /* Rounded to multiples of 2^-16 so that the sums are exact and removing tiles in any order leaves no drift */
+    for (i = 0; i < tile_count; ++i)
+    {
+      double weight_log = (double)tiles->tile_weights[i] * wfc_log2((double)tiles->tile_weights[i]) * 65536.0;
+
+      if (weight_log < 4503599627370496.0) /* 2^52 */
+      {
+        weight_log = (weight_log + 4503599627370496.0) - 4503599627370496.0;
+      }
+
+      grid->tile_weight_logs[i] = weight_log / 65536.0;
+      weight_log_sum += grid->tile_weight_logs[i];
+    }
+  }
+
+  grid->cell_entropy_masks = (unsigned int *)ptr;
+  ptr += sizeof(unsigned int) * grid_size * grid->cell_entropy_mask_words;
+
+  if (grid->selection == WFC_SELECTION_MIN_HEAP)
+  {
+    grid->heap_cells = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size;
+
+    grid->heap_positions = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size;
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_WORKLIST || grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    grid->worklist_cells = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size;
+
+    grid->worklist_union = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid->cell_entropy_mask_words;
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    grid->support_banned = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size * grid->cell_entropy_mask_words;
+  }
+
+  if (grid->trail_capacity > 0)
+  {
+    grid->trail_indices = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid->trail_capacity;
+
+    grid->trail_values = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid->trail_capacity;
+
+    grid->decision_marks = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size;
+
+    grid->decision_cells = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size;
+
+    grid->decision_tiles = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size;
+  }
+
+  if (grid->boundary == WFC_BOUNDARY_PERIODIC)
+  {
+    unsigned int layers = wfc_grid_layer_count(grid);
+
+    grid->wrap_x = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * (grid->cols + 2);
+
+    grid->wrap_y = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * (grid->rows + 2);
+
+    grid->wrap_z = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * (layers + 2);
+
+    /* The cell index is a sum of one term per axis, so the offset of an axis is the index with the other axes at 0 */
+    for (i = 0; i < grid->cols + 2; ++i)
+    {
+      grid->wrap_x[i] = wfc_grid_cell_index(grid, (i + grid->cols - 1) % grid->cols, 0, 0);
+    }
+
+    for (i = 0; i < grid->rows + 2; ++i)
+    {
+      grid->wrap_y[i] = wfc_grid_cell_index(grid, 0, (i + grid->rows - 1) % grid->rows, 0);
+    }
+
+    for (i = 0; i < layers + 2; ++i)
+    {
+      grid->wrap_z[i] = wfc_grid_cell_index(grid, 0, 0, (i + layers - 1) % layers);
+    }
+  }
+
+  if (grid->neighbours == WFC_NEIGHBOURS_TABLE)
+  {
+    unsigned int dir_count = tiles->tile_direction_count;
+
+    grid->cell_neighbours = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * grid_size * dir_count;
+
+    for (i = 0; i < grid_size; ++i)
+    {
+      for (j = 0; j < dir_count; ++j)
+      {
+        int neighbour_index = wfc_grid_neighbour_index(grid, (int)i, j, dir_count);
+
+        grid->cell_neighbours[i * dir_count + j] = neighbour_index < 0 ? grid_size : (unsigned int)neighbour_index;
+      }
+    }
+  }
+
+  /* The wider of the two short arrays first */
+  if (sizeof(wfc_count) >= sizeof(unsigned short))
+  {
+    grid->cell_entropy_count = (wfc_count *)ptr;
+    ptr += sizeof(wfc_count) * grid_size;
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    grid->support_counts = (unsigned short *)ptr;
+    ptr += sizeof(unsigned short) * grid_size * tile_count * tiles->tile_direction_count;
+  }
+
+  if (sizeof(wfc_count) < sizeof(unsigned short))
+  {
+    grid->cell_entropy_count = (wfc_count *)ptr;
+    ptr += sizeof(wfc_count) * grid_size;
+  }
+
+  grid->cell_collapsed = ptr;
+  ptr += sizeof(unsigned char) * (grid_size + 1);
+
+  /* The sentinel cell past the edges never takes constraints */
+  grid->cell_collapsed[grid_size] = 1;
+
+  if (grid->propagation == WFC_PROPAGATION_WORKLIST || grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    grid->worklist_queued = ptr;
+    grid->worklist_size = 0;
+
+    for (i = 0; i < grid_size; ++i)
+    {
+      grid->worklist_queued[i] = 0;
+    }
+  }
+
+  /* Initialize cell entropy bitmasks to all 1s (all tiles possible) */
+  for (i = 0; i < grid_size; ++i)
+  {
+    unsigned int base_index = (i * grid->cell_entropy_mask_words);
+
+    for (j = 0; j < grid->cell_entropy_mask_words; ++j)
+    {
+      /* Set all bits to 1, meaning all tiles are initially possible */
+      grid->cell_entropy_masks[base_index + j] = 0xFFFFFFFF;
+    }
+
+    /* Bits past the last tile stay cleared */
+    if (tile_count % 32)
+    {
+      grid->cell_entropy_masks[base_index + grid->cell_entropy_mask_words - 1] = (1u << (tile_count % 32)) - 1;
+    }
+
+    grid->cell_collapsed[i] = 0;
+    grid->cell_entropy_count[i] = (wfc_count)tile_count;
+
+    if (grid->entropy == WFC_ENTROPY_SHANNON)
+    {
+      grid->cell_weight_sums[i] = weight_sum;
+      grid->cell_weight_log_sums[i] = weight_log_sum;
+      grid->cell_shannon_entropy[i] = wfc_grid_shannon_entropy(grid, i, tile_count);
+    }
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    wfc_grid_initialize_supports(grid, tiles);
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Entropy min-heap
+ * #############################################################################
+ */
+/* Heap order: lower entropy count (or Shannon entropy) first, lower cell index on ties */
+WFC_API WFC_INLINE int wfc_grid_heap_less(wfc_grid *grid, unsigned int cell_a, unsigned int cell_b)
+{
+  unsigned int count_a;
+  unsigned int count_b;
+
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    double entropy_a = grid->cell_shannon_entropy[cell_a];
+    double entropy_b = grid->cell_shannon_entropy[cell_b];
+
+    return entropy_a < entropy_b || (entropy_a == entropy_b && cell_a < cell_b);
+  }
+
+  count_a = grid->cell_entropy_count[cell_a];
+  count_b = grid->cell_entropy_count[cell_b];
+
+  return count_a < count_b || (count_a == count_b && cell_a < cell_b);
+}
+
+WFC_API WFC_INLINE void wfc_grid_heap_place(wfc_grid *grid, unsigned int slot, unsigned int cell_index)
+{
+  grid->heap_cells[slot] = cell_index;
+  grid->heap_positions[cell_index] = slot;
+}
+
+WFC_API WFC_INLINE void wfc_grid_heap_sift_up(wfc_grid *grid, unsigned int slot)
+{
+  unsigned int cell_index = grid->heap_cells[slot];
+
+  while (slot > 0)
+  {
+    unsigned int parent = (slot - 1) / 2;
+
+    if (!wfc_grid_heap_less(grid, cell_index, grid->heap_cells[parent]))
+    {
+      break;
+    }
+
+    wfc_grid_heap_place(grid, slot, grid->heap_cells[parent]);
+    slot = parent;
+  }
+
+  wfc_grid_heap_place(grid, slot, cell_index);
+}
+
+WFC_API WFC_INLINE void wfc_grid_heap_sift_down(wfc_grid *grid, unsigned int slot)
+{
+  unsigned int cell_index = grid->heap_cells[slot];
+
+  for (;;)
+  {
+    unsigned int child = slot * 2 + 1;
+
+    if (child >= grid->heap_size)
+    {
+      break;
+    }
+
+    if (child + 1 < grid->heap_size && wfc_grid_heap_less(grid, grid->heap_cells[child + 1], grid->heap_cells[child]))
+    {
+      child++;
+    }
+
+    if (!wfc_grid_heap_less(grid, grid->heap_cells[child], cell_index))
+    {
+      break;
+    }
+
+    wfc_grid_heap_place(grid, slot, grid->heap_cells[child]);
+    slot = child;
+  }
+
+  wfc_grid_heap_place(grid, slot, cell_index);
+}
+
+/* (Re)builds the heap from the current cell state. Called once per wfc() run */
+WFC_API WFC_INLINE void wfc_grid_heap_build(wfc_grid *grid)
+{
+  unsigned int grid_size = wfc_grid_cell_count(grid);
+  unsigned int i;
+
+  grid->heap_size = 0;
+
+  for (i = 0; i < grid_size; ++i)
+  {
+    grid->heap_positions[i] = WFC_CELL_NONE;
+
+    if (!grid->cell_collapsed[i])
+    {
+      wfc_grid_heap_place(grid, grid->heap_size++, i);
+    }
+  }
+
+  i = grid->heap_size / 2;
+
+  while (i-- > 0)
+  {
+    wfc_grid_heap_sift_down(grid, i);
+  }
+}
+
+WFC_API WFC_INLINE void wfc_grid_heap_remove(wfc_grid *grid, unsigned int cell_index)
+{
+  unsigned int slot = grid->heap_positions[cell_index];
+
+  if (slot == WFC_CELL_NONE)
+  {
+    return;
+  }
+
+  grid->heap_positions[cell_index] = WFC_CELL_NONE;
+  grid->heap_size--;
+
+  if (slot < grid->heap_size)
+  {
+    unsigned int moved_cell = grid->heap_cells[grid->heap_size];
+
+    wfc_grid_heap_place(grid, slot, moved_cell);
+    wfc_grid_heap_sift_up(grid, slot);
+    wfc_grid_heap_sift_down(grid, grid->heap_positions[moved_cell]);
+  }
+}
+
+WFC_API WFC_INLINE void wfc_grid_heap_insert(wfc_grid *grid, unsigned int cell_index)
+{
+  unsigned int slot = grid->heap_size++;
+
+  wfc_grid_heap_place(grid, slot, cell_index);
+  wfc_grid_heap_sift_up(grid, slot);
+}
+
+/* Updates the entropy count of a non-collapsed cell and keeps the selection structure in sync.
+   With WFC_ENTROPY_SHANNON the weight sums have to be updated before */
+WFC_API WFC_INLINE void wfc_grid_set_entropy_count(wfc_grid *grid, unsigned int cell_index, unsigned int entropy_count)
+{
+  grid->cell_entropy_count[cell_index] = (wfc_count)entropy_count;
+
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    grid->cell_shannon_entropy[cell_index] = wfc_grid_shannon_entropy(grid, cell_index, entropy_count);
+  }
+
+  if (grid->selection == WFC_SELECTION_MIN_HEAP && grid->heap_positions[cell_index] != WFC_CELL_NONE)
+  {
+    wfc_grid_heap_sift_up(grid, grid->heap_positions[cell_index]);
+    wfc_grid_heap_sift_down(grid, grid->heap_positions[cell_index]);
+  }
+}
+
+WFC_API WFC_INLINE void wfc_worklist_push(wfc_grid *grid, unsigned int cell_index)
+{
+  if (!grid->worklist_queued[cell_index])
+  {
+    grid->worklist_queued[cell_index] = 1;
+    grid->worklist_cells[grid->worklist_size++] = cell_index;
+  }
+}
+
+/* Drops all pending work after a contradiction so the next run starts clean */
+WFC_API WFC_INLINE void wfc_worklist_clear(wfc_grid *grid)
+{
+  while (grid->worklist_size > 0)
+  {
+    unsigned int cell_index = grid->worklist_cells[--grid->worklist_size];
+    unsigned int k;
+
+    grid->worklist_queued[cell_index] = 0;
+
+    if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+    {
+      for (k = 0; k < grid->cell_entropy_mask_words; ++k)
+      {
+        grid->support_banned[cell_index * grid->cell_entropy_mask_words + k] = 0;
+      }
+    }
+  }
+}
+
+/* Saves a mask word before it changes so wfc_backtrack() can restore it */
+WFC_API WFC_INLINE void wfc_trail_record(wfc_grid *grid, unsigned int mask_index)
+{
+  /* Changes made before the first decision are never undone */
+  if (grid->decision_count == 0)
+  {
+    return;
+  }
+
+  if (grid->trail_size == grid->trail_capacity)
+  {
+    grid->trail_overflow = 1;
+    return;
+  }
+
+  grid->trail_indices[grid->trail_size] = mask_index;
+  grid->trail_values[grid->trail_size] = grid->cell_entropy_masks[mask_index];
+  grid->trail_size++;
+
+  if (grid->trail_size > grid->trail_high_water)
+  {
+    grid->trail_high_water = grid->trail_size;
+  }
+}
+
+/* ANDs src into the mask of a cell and returns the number of tiles left */
+WFC_API WFC_INLINE unsigned int wfc_grid_mask_and(wfc_grid *grid, unsigned int cell_index, unsigned int *src)
+{
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int *mask = &grid->cell_entropy_masks[cell_index * mask_words];
+  unsigned int k;
+
+  if (WFC_SINGLE_WORD(mask_words))
+  {
+    unsigned int removed = *mask & ~*src;
+
+    if (removed)
+    {
+      wfc_trail_record(grid, cell_index);
+
+      if (grid->entropy == WFC_ENTROPY_SHANNON)
+      {
+        wfc_grid_remove_weights(grid, cell_index, 0, removed);
+      }
+
+      *mask &= *src;
+    }
+
+    return wfc_popcount(*mask);
+  }
+
+  if (grid->decision_count > 0 || grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    for (k = 0; k < mask_words; ++k)
+    {
+      unsigned int removed = mask[k] & ~src[k];
+
+      if (removed)
+      {
+        wfc_trail_record(grid, cell_index * mask_words + k);
+
+        if (grid->entropy == WFC_ENTROPY_SHANNON)
+        {
+          wfc_grid_remove_weights(grid, cell_index, k, removed);
+        }
+      }
+    }
+  }
+
+  return wfc_mask_and_count(mask, src, mask_words);
+}
+
+/* Collapse the current cell and set the first entropies entry to the desired tile_index entropies entry */
+WFC_API WFC_INLINE void wfc_grid_collapse_current_cell(wfc_grid *grid, unsigned int tile_to_keep)
+{
+  unsigned int i;
+  unsigned int base_mask_index = grid->cell_index_current * grid->cell_entropy_mask_words;
+
+  if (WFC_SINGLE_WORD(grid->cell_entropy_mask_words))
+  {
+    unsigned int *mask = &grid->cell_entropy_masks[base_mask_index];
+    unsigned int bit = 1u << tile_to_keep;
+
+    if (*mask != bit)
+    {
+      wfc_trail_record(grid, base_mask_index);
+    }
+
+    if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+    {
+      grid->support_banned[base_mask_index] |= *mask & ~bit;
+      wfc_worklist_push(grid, grid->cell_index_current);
+    }
+
+    *mask = bit;
+  }
+  else
+  {
+    /* Clear all bits in the cell's entropy mask */
+    for (i = 0; i < grid->cell_entropy_mask_words; ++i)
+    {
+      if (grid->cell_entropy_masks[base_mask_index + i] != (i == tile_to_keep / 32 ? (1u << (tile_to_keep % 32)) : 0))
+      {
+        wfc_trail_record(grid, base_mask_index + i);
+      }
+
+      if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+      {
+        grid->support_banned[base_mask_index + i] |= grid->cell_entropy_masks[base_mask_index + i];
+      }
+
+      grid->cell_entropy_masks[base_mask_index + i] = 0;
+    }
+
+    /* Set the single bit for the chosen tile */
+    grid->cell_entropy_masks[base_mask_index + (tile_to_keep / 32)] = (1u << (tile_to_keep % 32));
+
+    /* Every other tile has been banned and has to withdraw its support from the neighbours */
+    if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+    {
+      grid->support_banned[base_mask_index + (tile_to_keep / 32)] &= ~(1u << (tile_to_keep % 32));
+      wfc_worklist_push(grid, grid->cell_index_current);
+    }
+  }
+
+  if (grid->selection == WFC_SELECTION_MIN_HEAP)
+  {
+    wfc_grid_heap_remove(grid, grid->cell_index_current);
+  }
+
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    grid->cell_weight_sums[grid->cell_index_current] = grid->tile_weights[tile_to_keep];
+    grid->cell_weight_log_sums[grid->cell_index_current] = grid->tile_weight_logs[tile_to_keep];
+    grid->cell_shannon_entropy[grid->cell_index_current] = 0.0;
+  }
+
+  grid->cell_collapsed[grid->cell_index_current] = 1;     /* Mark the cell as collapsed */
+  grid->cell_entropy_count[grid->cell_index_current] = 1; /* A collapsed cell has only 1 option */
+  grid->cells_processed++;
+}
+
+WFC_API WFC_INLINE unsigned int wfc_grid_find_nth_tile_in_mask(wfc_grid *grid, unsigned int cell_index, unsigned int n)
+{
+  unsigned int word_index;
+  unsigned int count = 0;
+  unsigned int base_mask_index = cell_index * grid->cell_entropy_mask_words;
+
+  if (WFC_SINGLE_WORD(grid->cell_entropy_mask_words))
+  {
+    unsigned int word = grid->cell_entropy_masks[cell_index];
+
+    return n < wfc_popcount(word) ? wfc_select_bit(word, n) : (unsigned int)-1;
+  }
+
+  for (word_index = 0; word_index < grid->cell_entropy_mask_words; ++word_index)
+  {
+    unsigned int word = grid->cell_entropy_masks[base_mask_index + word_index];
+    unsigned int bits_in_word = wfc_popcount(word);
+
+    if (count + bits_in_word > n)
+    {
+      /* The Nth bit is in this word */
+      return (word_index * 32) + wfc_select_bit(word, n - count);
+    }
+
+    count += bits_in_word;
+  }
+
+  return (unsigned int)-1; /* Should not be reached if n < entropy_count */
+}
+
+/* Finds the remaining tile of a cell whose range of cumulative weights contains r (r < cell weight sum) */
+WFC_API WFC_INLINE unsigned int wfc_grid_find_weighted_tile_in_mask(wfc_grid *grid, unsigned int cell_index, unsigned int r)
+{
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int k;
+
+  for (k = 0; k < mask_words; ++k)
+  {
+    unsigned int word = grid->cell_entropy_masks[cell_index * mask_words + k];
+
+    while (word)
+    {
+      unsigned int tile = k * 32 + wfc_bit_scan_forward(word);
+
+      if (r < grid->tile_weights[tile])
+      {
+        return tile;
+      }
+
+      r -= grid->tile_weights[tile];
+      word &= word - 1;
+    }
+  }
+
+  return (unsigned int)-1; /* Should not be reached if r < cell weight sum */
+}
+
+/* Removes the tiles of mask word k of a cell that are not in keep. Returns the removed tiles */
+WFC_API WFC_INLINE unsigned int wfc_grid_constrain_word(wfc_grid *grid, unsigned int cell_index, unsigned int k, unsigned int keep)
+{
+  unsigned int mask_index = cell_index * grid->cell_entropy_mask_words + k;
+  unsigned int removed = grid->cell_entropy_masks[mask_index] & ~keep;
+
+  if (removed)
+  {
+    if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+    {
+      grid->support_banned[mask_index] |= removed;
+    }
+
+    if (grid->entropy == WFC_ENTROPY_SHANNON)
+    {
+      wfc_grid_remove_weights(grid, cell_index, k, removed);
+    }
+
+    grid->cell_entropy_masks[mask_index] &= keep;
+  }
+
+  return removed;
+}
+
+/* Stores the entropy of a cell restricted by wfc_grid_constrain_word() and queues it for propagation */
+WFC_API WFC_INLINE void wfc_grid_constrain_update(wfc_grid *grid, unsigned int cell_index, unsigned int entropy_count)
+{
+  /* The heap is rebuilt by wfc(), so only the values are updated */
+  grid->cell_entropy_count[cell_index] = (wfc_count)entropy_count;
+
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    grid->cell_shannon_entropy[cell_index] = wfc_grid_shannon_entropy(grid, cell_index, entropy_count);
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_WORKLIST || grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    wfc_worklist_push(grid, cell_index);
+  }
+}
+
+/* Restricts a cell of an initialized grid to the tiles in mask before wfc() runs, e.g. to the tiles that fit a fixed
+   tile outside the grid. wfc() propagates the restriction first (WFC_PROPAGATION_WORKLIST and _SUPPORT only, the
+   neighbours propagation needs wfc_grid_propagate_constraints() to see it before the cell is collapsed).
+   Returns the number of tiles left, 0 means the grid can not be solved. */
+WFC_API WFC_INLINE unsigned int wfc_grid_constrain(wfc_grid *grid, unsigned int cell_index, unsigned int *mask)
+{
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int entropy_count = 0;
+  unsigned int changed = 0;
+  unsigned int k;
+
+  for (k = 0; k < mask_words; ++k)
+  {
+    changed |= wfc_grid_constrain_word(grid, cell_index, k, mask[k]);
+    entropy_count += wfc_popcount(grid->cell_entropy_masks[cell_index * mask_words + k]);
+  }
+
+  if (changed)
+  {
+    wfc_grid_constrain_update(grid, cell_index, entropy_count);
+  }
+
+  return entropy_count;
+}
+
+/* Pins a cell to a single tile before wfc() runs, like wfc_grid_constrain() with a one tile mask.
+   Returns 1, or 0 if the tile was already ruled out for the cell */
+WFC_API WFC_INLINE unsigned int wfc_grid_pin_tile(wfc_grid *grid, unsigned int cell_index, unsigned int tile)
+{
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int entropy_count;
+  unsigned int changed = 0;
+  unsigned int k;
+
+  for (k = 0; k < mask_words; ++k)
+  {
+    changed |= wfc_grid_constrain_word(grid, cell_index, k, k == tile / 32 ? 1u << (tile % 32) : 0u);
+  }
+
+  entropy_count = (grid->cell_entropy_masks[cell_index * mask_words + tile / 32] >> (tile % 32)) & 1u;
+
+  if (changed)
+  {
+    wfc_grid_constrain_update(grid, cell_index, entropy_count);
+  }
+
+  return entropy_count;
+}
+
+/* Restricts a cell to the tiles that fit next to tile placed outside the grid in direction dir of the cell */
+WFC_API WFC_INLINE unsigned int wfc_grid_constrain_neighbour_tile(wfc_grid *grid, wfc_tiles *tiles, unsigned int cell_index, unsigned int dir, unsigned int tile)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int opp_dir = (dir + dir_count / 2) % dir_count;
+
+  return wfc_grid_constrain(grid, cell_index, &tiles->tile_direction_compatible_masks[(tile * dir_count + opp_dir) * tiles->tile_direction_compatible_masks_words]);
+}
+
+/* #############################################################################
+ * # Wave Function Collapse Algorithm
+ * #############################################################################
+ */
+WFC_API WFC_INLINE void wfc_update_neighbour_entropies(wfc_grid *grid, wfc_tiles *tiles, unsigned int collapsed_index)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int compatible_mask_words = tiles->tile_direction_compatible_masks_words;
+  unsigned int neighbour_buffer[WFC_GRID_DIRECTIONS_MAX];
+  unsigned int *neighbours = wfc_grid_cell_neighbours(grid, collapsed_index, dir_count, neighbour_buffer);
+  unsigned int d;
+
+  /* Since the cell is collapsed, it has only one tile. Find it. */
+  unsigned int collapsed_tile = wfc_grid_find_nth_tile_in_mask(grid, collapsed_index, 0);
+
+  if (WFC_SINGLE_WORD(compatible_mask_words) && collapsed_tile < tile_count)
+  {
+    unsigned int *compatible_masks = &tiles->tile_direction_compatible_masks[collapsed_tile * dir_count];
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      unsigned int neighbour_index = neighbours[d];
+      unsigned int *neighbour_mask;
+
+      if (grid->cell_collapsed[neighbour_index])
+      {
+        continue;
+      }
+
+      neighbour_mask = &grid->cell_entropy_masks[neighbour_index];
+
+      if (*neighbour_mask & ~compatible_masks[d])
+      {
+        wfc_trail_record(grid, neighbour_index);
+
+        if (grid->entropy == WFC_ENTROPY_SHANNON)
+        {
+          wfc_grid_remove_weights(grid, neighbour_index, 0, *neighbour_mask & ~compatible_masks[d]);
+        }
+
+        *neighbour_mask &= compatible_masks[d];
+        wfc_grid_set_entropy_count(grid, neighbour_index, wfc_popcount(*neighbour_mask));
+      }
+    }
+
+    return;
+  }
+
+  /* This should not happen if the logic is correct */
+  if (collapsed_tile > tile_count)
+  {
+    return;
+  }
+
+  for (d = 0; d < dir_count; ++d)
+  {
+    unsigned int neighbour_index = neighbours[d];
+
+    unsigned int *compatible_mask;
+    unsigned int new_entropy_count;
+
+    if (grid->cell_collapsed[neighbour_index])
+    {
+      continue;
+    }
+
+    /* Get the mask of tiles that are compatible with our collapsed tile in this direction */
+    compatible_mask = &tiles->tile_direction_compatible_masks[(collapsed_tile * dir_count + d) * compatible_mask_words];
+
+    /* Filter the neighbor's possibilities by ANDing its mask with the compatibility mask. */
+    new_entropy_count = wfc_grid_mask_and(grid, neighbour_index, compatible_mask);
+
+    wfc_grid_set_entropy_count(grid, neighbour_index, new_entropy_count);
+  }
+}
+
+/* wfc_propagate_worklist() for tile sets that fit a single mask word */
+WFC_API WFC_INLINE int wfc_propagate_worklist_single_word(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int *compatible_masks = tiles->tile_direction_compatible_masks;
+  unsigned int neighbour_buffer[WFC_GRID_DIRECTIONS_MAX];
+
+  while (grid->worklist_size > 0)
+  {
+    unsigned int cell_index = grid->worklist_cells[--grid->worklist_size];
+    unsigned int cell_mask = grid->cell_entropy_masks[cell_index];
+    unsigned int *neighbours = wfc_grid_cell_neighbours(grid, cell_index, dir_count, neighbour_buffer);
+    unsigned int d;
+
+    grid->worklist_queued[cell_index] = 0;
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      unsigned int neighbour_index = neighbours[d];
+      unsigned int *neighbour_mask;
+      unsigned int supported = 0;
+      unsigned int word = cell_mask;
+      unsigned int new_entropy_count;
+
+      if (grid->cell_collapsed[neighbour_index])
+      {
+        continue;
+      }
+
+      while (word)
+      {
+        supported |= compatible_masks[wfc_bit_scan_forward(word) * dir_count + d];
+        word &= word - 1;
+      }
+
+      /* Nothing left for the neighbour, it is a contradiction whatever tiles it still holds */
+      if (!supported)
+      {
+        wfc_worklist_clear(grid);
+        return 0;
+      }
+
+      neighbour_mask = &grid->cell_entropy_masks[neighbour_index];
+
+      if (!(*neighbour_mask & ~supported))
+      {
+        continue;
+      }
+
+      wfc_trail_record(grid, neighbour_index);
+
+      if (grid->entropy == WFC_ENTROPY_SHANNON)
+      {
+        wfc_grid_remove_weights(grid, neighbour_index, 0, *neighbour_mask & ~supported);
+      }
+
+      *neighbour_mask &= supported;
+      new_entropy_count = wfc_popcount(*neighbour_mask);
+      wfc_grid_set_entropy_count(grid, neighbour_index, new_entropy_count);
+
+      if (new_entropy_count == 0)
+      {
+        wfc_worklist_clear(grid);
+        return 0;
+      }
+
+      wfc_worklist_push(grid, neighbour_index);
+    }
+  }
+
+  return 1;
+}
+
+/* AC-3 style propagation. Every cell on the worklist restricts each non-collapsed neighbour to the union of
+   the tiles its remaining tiles support in that direction. Neighbours that shrink are pushed until a fixpoint.
+   Returns 0 if a cell ran out of tiles (contradiction). */
+WFC_API WFC_INLINE int wfc_propagate_worklist(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int *supported = grid->worklist_union;
+  unsigned int neighbour_buffer[WFC_GRID_DIRECTIONS_MAX];
+
+  if (WFC_SINGLE_WORD(mask_words))
+  {
+    return wfc_propagate_worklist_single_word(grid, tiles);
+  }
+
+  while (grid->worklist_size > 0)
+  {
+    unsigned int cell_index = grid->worklist_cells[--grid->worklist_size];
+    unsigned int *cell_mask = &grid->cell_entropy_masks[cell_index * mask_words];
+    unsigned int *neighbours = wfc_grid_cell_neighbours(grid, cell_index, dir_count, neighbour_buffer);
+    unsigned int d, k;
+
+    grid->worklist_queued[cell_index] = 0;
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      unsigned int neighbour_index = neighbours[d];
+      unsigned int new_entropy_count;
+
+      if (grid->cell_collapsed[neighbour_index])
+      {
+        continue;
+      }
+
+      /* OR together what the remaining tiles of this cell allow in direction d */
+      for (k = 0; k < mask_words; ++k)
+      {
+        supported[k] = 0;
+      }
+
+      for (k = 0; k < mask_words; ++k)
+      {
+        unsigned int word = cell_mask[k];
+
+        while (word)
+        {
+          unsigned int tile = k * 32 + wfc_bit_scan_forward(word);
+
+          wfc_mask_or(supported, &tiles->tile_direction_compatible_masks[(tile * dir_count + d) * mask_words], mask_words);
+
+          word &= word - 1;
+        }
+      }
+
+      /* Nothing left for the neighbour, it is a contradiction whatever tiles it still holds */
+      if (wfc_mask_is_empty(supported, mask_words))
+      {
+        wfc_worklist_clear(grid);
+        return 0;
+      }
+
+      /* The domain only shrinks, so an unchanged count means an unchanged mask */
+      new_entropy_count = wfc_grid_mask_and(grid, neighbour_index, supported);
+
+      if (new_entropy_count == grid->cell_entropy_count[neighbour_index])
+      {
+        continue;
+      }
+
+      wfc_grid_set_entropy_count(grid, neighbour_index, new_entropy_count);
+
+      if (new_entropy_count == 0)
+      {
+        wfc_worklist_clear(grid);
+        return 0;
+      }
+
+      wfc_worklist_push(grid, neighbour_index);
+    }
+  }
+
+  return 1;
+}
+
+/* Removes a tile from a cell during support propagation. Returns 0 if the cell ran out of tiles */
+WFC_API WFC_INLINE int wfc_support_ban(wfc_grid *grid, unsigned int cell_index, unsigned int word_index, unsigned int bit)
+{
+  unsigned int new_entropy_count = grid->cell_entropy_count[cell_index] - 1u;
+
+  wfc_trail_record(grid, cell_index * grid->cell_entropy_mask_words + word_index);
+  grid->cell_entropy_masks[cell_index * grid->cell_entropy_mask_words + word_index] &= ~bit;
+  grid->support_banned[cell_index * grid->cell_entropy_mask_words + word_index] |= bit;
+
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    wfc_grid_remove_weights(grid, cell_index, word_index, bit);
+  }
+
+  wfc_grid_set_entropy_count(grid, cell_index, new_entropy_count);
+  wfc_worklist_push(grid, cell_index);
+
+  return new_entropy_count > 0;
+}
+
+/* Recounts the support counters of the neighbour in direction d of a cell from the cell's remaining tiles */
+WFC_API WFC_INLINE void wfc_support_recount(wfc_grid *grid, wfc_tiles *tiles, unsigned int cell_index, unsigned int d, unsigned short *neighbour_supports)
+{
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int *cell_mask = &grid->cell_entropy_masks[cell_index * mask_words];
+  unsigned int t, k, w;
+
+  for (t = 0; t < tile_count; ++t)
+  {
+    neighbour_supports[t] = 0;
+  }
+
+  for (k = 0; k < mask_words; ++k)
+  {
+    unsigned int word = cell_mask[k];
+
+    while (word)
+    {
+      unsigned int *compatible_mask = &tiles->tile_direction_compatible_masks[((k * 32 + wfc_bit_scan_forward(word)) * dir_count + d) * mask_words];
+
+      for (w = 0; w < mask_words; ++w)
+      {
+        unsigned int supported = compatible_mask[w];
+
+        while (supported)
+        {
+          neighbour_supports[w * 32 + wfc_bit_scan_forward(supported)]++;
+          supported &= supported - 1;
+        }
+      }
+
+      word &= word - 1;
+    }
+  }
+}
+
+/* AC-4 style propagation, same fixpoint as wfc_propagate_worklist(). The support counters take
+   rows * cols * directions * tile_count * 2 bytes. Returns 0 on contradiction. */
+WFC_API WFC_INLINE int wfc_propagate_supports(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int *banned = grid->worklist_union;
+
+  while (grid->worklist_size > 0)
+  {
+    unsigned int cell_index = grid->worklist_cells[--grid->worklist_size];
+    unsigned int banned_count = 0;
+    unsigned int single_tile = WFC_CELL_NONE;
+    unsigned int d, k;
+
+    grid->worklist_queued[cell_index] = 0;
+
+    /* A cell down to one tile (e.g. just collapsed) leaves its neighbours exactly the tiles compatible with it.
+       The counters facing it are not updated, only a contradiction or an undo, which recounts them, reads them again */
+    if (grid->cell_entropy_count[cell_index] == 1)
+    {
+      single_tile = wfc_grid_find_nth_tile_in_mask(grid, cell_index, 0);
+    }
+
+    for (k = 0; k < mask_words; ++k)
+    {
+      banned[k] = grid->support_banned[cell_index * mask_words + k];
+      banned_count += wfc_popcount(banned[k]);
+      grid->support_banned[cell_index * mask_words + k] = 0;
+    }
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      int neighbour_index = wfc_grid_neighbour_index(grid, (int)cell_index, d, dir_count);
+      unsigned int opp_dir = (d + dir_count / 2) % dir_count;
+      unsigned int *neighbour_mask;
+      unsigned short *neighbour_supports;
+      unsigned int w;
+
+      if (neighbour_index < 0)
+      {
+        continue;
+      }
+
+      neighbour_mask = &grid->cell_entropy_masks[(unsigned int)neighbour_index * mask_words];
+      neighbour_supports = &grid->support_counts[((unsigned int)neighbour_index * dir_count + opp_dir) * tile_count];
+
+      if (single_tile != WFC_CELL_NONE)
+      {
+        unsigned int *compatible_mask = &tiles->tile_direction_compatible_masks[(single_tile * dir_count + d) * mask_words];
+
+        for (w = 0; w < mask_words; ++w)
+        {
+          unsigned int word = neighbour_mask[w] & ~compatible_mask[w];
+
+          while (word)
+          {
+            if (!wfc_support_ban(grid, (unsigned int)neighbour_index, w, word & (0u - word)))
+            {
+              wfc_worklist_clear(grid);
+              return 0;
+            }
+
+            word &= word - 1;
+          }
+        }
+
+        continue;
+      }
+
+      if (grid->cell_entropy_count[cell_index] < banned_count)
+      {
+        wfc_support_recount(grid, tiles, cell_index, d, neighbour_supports);
+
+        for (w = 0; w < mask_words; ++w)
+        {
+          unsigned int word = neighbour_mask[w];
+
+          while (word)
+          {
+            unsigned int bit = word & (0u - word);
+
+            if (neighbour_supports[w * 32 + wfc_bit_scan_forward(word)] == 0 && !wfc_support_ban(grid, (unsigned int)neighbour_index, w, bit))
+            {
+              wfc_worklist_clear(grid);
+              return 0;
+            }
+
+            word &= word - 1;
+          }
+        }
+
+        continue;
+      }
+
+      for (k = 0; k < mask_words; ++k)
+      {
+        unsigned int word = banned[k];
+
+        while (word)
+        {
+          /* Compatibility is symmetric: the tiles that supported the banned tile from the neighbour's
+             side are exactly the ones in the banned tile's own compatible mask for direction d */
+          unsigned int banned_tile = k * 32 + wfc_bit_scan_forward(word);
+          unsigned int *compatible_mask = &tiles->tile_direction_compatible_masks[(banned_tile * dir_count + d) * mask_words];
+
+          for (w = 0; w < mask_words; ++w)
+          {
+            unsigned int supported = compatible_mask[w];
+
+            while (supported)
+            {
+              unsigned int bit = supported & (0u - supported);
+
+              if (--neighbour_supports[w * 32 + wfc_bit_scan_forward(supported)] == 0 &&
+                  (neighbour_mask[w] & bit) &&
+                  !wfc_support_ban(grid, (unsigned int)neighbour_index, w, bit))
+              {
+                wfc_worklist_clear(grid);
+                return 0;
+              }
+
+              supported &= supported - 1;
+            }
+          }
+
+          word &= word - 1;
+        }
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* Propagates the constraints of a freshly collapsed cell with the configured strategy. Returns 0 on contradiction */
+WFC_API WFC_INLINE int wfc_propagate(wfc_grid *grid, wfc_tiles *tiles, unsigned int collapsed_index)
+{
+  if (grid->propagation == WFC_PROPAGATION_WORKLIST)
+  {
+    wfc_worklist_push(grid, collapsed_index);
+    return wfc_propagate_worklist(grid, tiles);
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    /* The collapse already queued the banned tiles */
+    return wfc_propagate_supports(grid, tiles);
+  }
+
+  wfc_update_neighbour_entropies(grid, tiles, collapsed_index);
+
+  return 1;
+}
+
+/* Word k of the union of the tiles the remaining tiles of a cell support in direction dir */
+WFC_API WFC_INLINE unsigned int wfc_grid_supported_word(wfc_grid *grid, wfc_tiles *tiles, unsigned int cell_index, unsigned int dir, unsigned int k)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int supported = 0;
+  unsigned int j;
+
+  for (j = 0; j < mask_words; ++j)
+  {
+    unsigned int word = grid->cell_entropy_masks[cell_index * mask_words + j];
+
+    while (word)
+    {
+      unsigned int tile = j * 32 + wfc_bit_scan_forward(word);
+
+      supported |= tiles->tile_direction_compatible_masks[(tile * dir_count + dir) * mask_words + k];
+      word &= word - 1;
+    }
+  }
+
+  return supported;
+}
+
+/* Enforces every restriction made with wfc_grid_constrain() and wfc_grid_pin_tile() in one batched pass before
+   wfc() runs, instead of one propagation per constrained cell. The worklist and support propagations cascade from
+   all restricted cells at once. The neighbours propagation has no worklist memory, so it sweeps the grid instead:
+   every restricted cell limits its neighbours to the union of the tiles its remaining tiles support, and the sweeps
+   repeat until one changes nothing, which also carries restrictions to more than one tile across the grid.
+   Returns 0 if a cell is left without tiles, the grid can then not be solved and wfc() would fail on it. */
+WFC_API WFC_INLINE int wfc_grid_propagate_constraints(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int total_cells = wfc_grid_cell_count(grid);
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int tile_count = tiles->tile_count;
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+  unsigned int neighbour_buffer[WFC_GRID_DIRECTIONS_MAX];
+  unsigned int changed;
+  unsigned int i;
+
+  /* The propagations keep the heap in sync with the entropy counts */
+  if (grid->selection == WFC_SELECTION_MIN_HEAP)
+  {
+    wfc_grid_heap_build(grid);
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_WORKLIST)
+  {
+    return wfc_propagate_worklist(grid, tiles);
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+  {
+    return wfc_propagate_supports(grid, tiles);
+  }
+
+  do
+  {
+    changed = 0;
+
+    for (i = 0; i < total_cells; ++i)
+    {
+      unsigned int *neighbours;
+      unsigned int d;
+
+      /* Cells that still hold every tile support everything wfc() itself would allow */
+      if (grid->cell_entropy_count[i] == tile_count)
+      {
+        continue;
+      }
+
+      neighbours = wfc_grid_cell_neighbours(grid, i, dir_count, neighbour_buffer);
+
+      for (d = 0; d < dir_count; ++d)
+      {
+        unsigned int neighbour_index = neighbours[d];
+        unsigned int removed = 0;
+        unsigned int entropy_count = 0;
+        unsigned int k;
+
+        if (grid->cell_collapsed[neighbour_index])
+        {
+          continue;
+        }
+
+        for (k = 0; k < mask_words; ++k)
+        {
+          removed |= wfc_grid_constrain_word(grid, neighbour_index, k, wfc_grid_supported_word(grid, tiles, i, d, k));
+          entropy_count += wfc_popcount(grid->cell_entropy_masks[neighbour_index * mask_words + k]);
+        }
+
+        if (!removed)
+        {
+          continue;
+        }
+
+        wfc_grid_set_entropy_count(grid, neighbour_index, entropy_count);
+
+        if (entropy_count == 0)
+        {
+          return 0;
+        }
+
+        changed = 1;
+      }
+    }
+  } while (changed);
+
+  return 1;
+}
+
+/* Restores every mask word recorded after trail_mark and fixes the entropy counts of the touched cells.
+   With support counters the counters facing the touched cells are recounted from the restored masks */
+WFC_API WFC_INLINE void wfc_trail_undo(wfc_grid *grid, wfc_tiles *tiles, unsigned int trail_mark)
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  unsigned int mask_words = grid->cell_entropy_mask_words;
+
+  while (grid->trail_size > trail_mark)
+  {
+    unsigned int mask_index = grid->trail_indices[--grid->trail_size];
+    unsigned int cell_index = mask_index / mask_words;
+    unsigned int entropy_count = 0;
+    unsigned int k;
+
+    grid->cell_entropy_masks[mask_index] = grid->trail_values[grid->trail_size];
+
+    if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+    {
+      wfc_worklist_push(grid, cell_index); /* Only collects the touched cells */
+      continue;
+    }
+
+    for (k = 0; k < mask_words; ++k)
+    {
+      entropy_count += wfc_popcount(grid->cell_entropy_masks[cell_index * mask_words + k]);
+    }
+
+    if (grid->entropy == WFC_ENTROPY_SHANNON)
+    {
+      wfc_grid_recount_weights(grid, cell_index);
+    }
+
+    wfc_grid_set_entropy_count(grid, cell_index, entropy_count);
+  }
+
+  while (grid->worklist_size > 0)
+  {
+    unsigned int cell_index = grid->worklist_cells[--grid->worklist_size];
+    unsigned int entropy_count = 0;
+    unsigned int d, k;
+
+    grid->worklist_queued[cell_index] = 0;
+
+    for (k = 0; k < mask_words; ++k)
+    {
+      entropy_count += wfc_popcount(grid->cell_entropy_masks[cell_index * mask_words + k]);
+    }
+
+    if (grid->entropy == WFC_ENTROPY_SHANNON)
+    {
+      wfc_grid_recount_weights(grid, cell_index);
+    }
+
+    wfc_grid_set_entropy_count(grid, cell_index, entropy_count);
+
+    for (d = 0; d < dir_count; ++d)
+    {
+      int neighbour_index = wfc_grid_neighbour_index(grid, (int)cell_index, d, dir_count);
+      unsigned int opp_dir = (d + dir_count / 2) % dir_count;
+
+      if (neighbour_index >= 0)
+      {
+        wfc_support_recount(grid, tiles, cell_index, d, &grid->support_counts[((unsigned int)neighbour_index * dir_count + opp_dir) * tiles->tile_count]);
+      }
+    }
+  }
+}
+
+/* Called on a contradiction. Undoes the grid to the state before the last decision, bans the tile chosen there
+   and propagates the ban. If that contradicts as well the next older decision is undone.
+   Returns 0 if there is no decision left, the trail overflowed or the backtrack budget is spent.
+   The caller then has to restart the grid like without backtracking. */
+WFC_API WFC_INLINE int wfc_backtrack(wfc_grid *grid, wfc_tiles *tiles)
+{
+  while (grid->decision_count > 0 && !grid->trail_overflow &&
+         (grid->backtrack_budget == 0 || grid->backtracks < grid->backtrack_budget))
+  {
+    unsigned int decision = --grid->decision_count;
+    unsigned int cell_index = grid->decision_cells[decision];
+    unsigned int tile = grid->decision_tiles[decision];
+    unsigned int mask_index = cell_index * grid->cell_entropy_mask_words + tile / 32;
+    unsigned int bit = 1u << (tile % 32);
+
+    grid->backtracks++;
+
+    wfc_trail_undo(grid, tiles, grid->decision_marks[decision]);
+
+    grid->cell_collapsed[cell_index] = 0;
+    grid->cells_processed--;
+
+    if (grid->selection == WFC_SELECTION_MIN_HEAP)
+    {
+      wfc_grid_heap_insert(grid, cell_index);
+    }
+
+    /* The failed choice is removed as part of the previous decision */
+    wfc_trail_record(grid, mask_index);
+    grid->cell_entropy_masks[mask_index] &= ~bit;
+
+    if (grid->entropy == WFC_ENTROPY_SHANNON)
+    {
+      wfc_grid_remove_weights(grid, cell_index, tile / 32, bit);
+    }
+
+    wfc_grid_set_entropy_count(grid, cell_index, grid->cell_entropy_count[cell_index] - 1u);
+
+    if (grid->cell_entropy_count[cell_index] == 0)
+    {
+      continue;
+    }
+
+    if (grid->propagation == WFC_PROPAGATION_WORKLIST)
+    {
+      wfc_worklist_push(grid, cell_index);
+
+      if (!wfc_propagate_worklist(grid, tiles))
+      {
+        continue;
+      }
+    }
+    else if (grid->propagation == WFC_PROPAGATION_SUPPORT)
+    {
+      grid->support_banned[mask_index] |= bit;
+      wfc_worklist_push(grid, cell_index);
+
+      if (!wfc_propagate_supports(grid, tiles))
+      {
+        continue;
+      }
+    }
+
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Cooperative cancellation, polled once per collapse */
+WFC_API WFC_INLINE int wfc_grid_cancelled(wfc_grid *grid)
+{
+#ifdef WFC_THREADS
+  return grid->cancel && wfc_atomic_load(grid->cancel);
+#else
+  return grid->cancel && *grid->cancel;
+#endif
+}
+
+WFC_API WFC_INLINE int wfc(wfc_grid *grid, wfc_tiles *tiles)
+{
+  unsigned int total_cells;
+
+  if (!grid || !tiles || !tiles->tiles_initialized || grid->rows < 1 || grid->cols < 1 || tiles->tile_count < 1)
+  {
+    return 0;
+  }
+
+  if (!tiles->tiles_compatible_tiles_computed)
+  {
+    wfc_tiles_compute_compatible_tiles(tiles);
+  }
+
+  total_cells = wfc_grid_cell_count(grid);
+  grid->cells_processed = 0;
+  grid->decisions = 0;
+  grid->backtracks = 0;
+  grid->trail_high_water = 0;
+  grid->trail_size = 0;
+  grid->trail_overflow = 0;
+  grid->decision_count = 0;
+
+  if (grid->selection == WFC_SELECTION_MIN_HEAP)
+  {
+    wfc_grid_heap_build(grid);
+  }
+
+  /* Bans found while seeding the support counters and restrictions from wfc_grid_constrain() */
+  if (grid->propagation == WFC_PROPAGATION_SUPPORT && !wfc_propagate_supports(grid, tiles))
+  {
+    return 0;
+  }
+
+  if (grid->propagation == WFC_PROPAGATION_WORKLIST && !wfc_propagate_worklist(grid, tiles))
+  {
+    return 0;
+  }
+
+  /* Repeat until all cells are collapsed. Every iteration either collapses a cell or backtracks */
+  for (;;)
+  {
+    unsigned int lowest_entropy = 0;
+    unsigned int lowest_cell = WFC_CELL_NONE;
+    int contradiction = 0;
+    unsigned int i;
+
+    if (wfc_grid_cancelled(grid))
+    {
+      return 0;
+    }
+
+    /* 1. Find the non-collapsed cell with the lowest entropy */
+    if (grid->selection == WFC_SELECTION_MIN_HEAP)
+    {
+      if (grid->heap_size == 0)
+      {
+        break; /* no cell left */
+      }
+
+      lowest_cell = grid->heap_cells[0];
+
+      lowest_entropy = grid->cell_entropy_count[lowest_cell];
+
+      /* This cell has no valid tiles */
+      contradiction = lowest_entropy == 0;
+    }
+    else
+    {
+      for (i = 0; i < total_cells; ++i)
+      {
+        unsigned int count = grid->cell_entropy_count[i];
+
+        if (!grid->cell_collapsed[i])
+        {
+          if (count == 0)
+          {
+            contradiction = 1; /* This cell has no valid tiles */
+            break;
+          }
+
+          if (lowest_cell == WFC_CELL_NONE ||
+              (grid->entropy == WFC_ENTROPY_SHANNON ? grid->cell_shannon_entropy[i] < grid->cell_shannon_entropy[lowest_cell] : count < lowest_entropy))
+          {
+            lowest_entropy = count;
+            lowest_cell = i;
+
+            if (lowest_entropy == 1)
+            {
+              break; /* can't get lower than 1 */
+            }
+          }
+        }
+      }
+    }
+
+    if (!contradiction)
+    {
+      unsigned int choice_index;
+      unsigned int chosen_tile_index;
+
+      /* no cell found (finished or stuck) */
+      if (lowest_cell == WFC_CELL_NONE)
+      {
+        break;
+      }
+
+      /* 2. Randomly choose one tile from available entropies (weighted by the tile weights with WFC_ENTROPY_SHANNON) */
+      if (grid->entropy == WFC_ENTROPY_SHANNON)
+      {
+        unsigned int weight_sum = grid->cell_weight_sums[lowest_cell];
+
+        choice_index = grid->rng ? wfc_rng_range(grid->rng, 0, weight_sum) : wfc_randi_range(0, weight_sum);
+        chosen_tile_index = wfc_grid_find_weighted_tile_in_mask(grid, lowest_cell, choice_index);
+      }
+      else
+      {
+        choice_index = grid->rng ? wfc_rng_range(grid->rng, 0, lowest_entropy) : wfc_randi_range(0, lowest_entropy);
+
+        /* Find the actual tile index corresponding to the random choice */
+        chosen_tile_index = wfc_grid_find_nth_tile_in_mask(grid, lowest_cell, choice_index);
+      }
+
+      /* This would mean a contradiction or bug */
+      if (chosen_tile_index > tiles->tile_count)
+      {
+        return 0;
+      }
+
+      if (grid->trail_capacity > 0)
+      {
+        grid->decision_marks[grid->decision_count] = grid->trail_size;
+        grid->decision_cells[grid->decision_count] = lowest_cell;
+        grid->decision_tiles[grid->decision_count] = chosen_tile_index;
+        grid->decision_count++;
+      }
+
+      grid->decisions++;
+      grid->cell_index_current = lowest_cell;
+      wfc_grid_collapse_current_cell(grid, chosen_tile_index);
+
+      /* 3. Propagate constraints */
+      contradiction = !wfc_propagate(grid, tiles, grid->cell_index_current);
+    }
+
+    /* Without backtracking (or once it gave up) the grid is unsolvable from here and has to be restarted */
+    if (contradiction && !wfc_backtrack(grid, tiles))
+    {
+      return 0;
+    }
+  }
+
+  return grid->cells_processed == wfc_grid_cell_count(grid);
+}
+
+/* #############################################################################
+ * # Regional re-solve
+ * #############################################################################
+ */
+/* Collapses a cell to tile in place, without propagation. The grid counters and heap are left alone so that
+   separate cells of one grid can be written from several threads */
+WFC_API WFC_INLINE void wfc_grid_set_cell_tile(wfc_grid *grid, unsigned int cell_index, unsigned int tile)
+{
+  unsigned int words = grid->cell_entropy_mask_words;
+  unsigned int k;
+
+  for (k = 0; k < words; ++k)
+  {
+    grid->cell_entropy_masks[cell_index * words + k] = k == tile / 32 ? 1u << (tile % 32) : 0u;
+  }
+
+  if (grid->entropy == WFC_ENTROPY_SHANNON)
+  {
+    grid->cell_weight_sums[cell_index] = grid->tile_weights[tile];
+    grid->cell_weight_log_sums[cell_index] = grid->tile_weight_logs[tile];
+    grid->cell_shannon_entropy[cell_index] = 0.0;
+  }
+
+  grid->cell_entropy_count[cell_index] = 1;
+  grid->cell_collapsed[cell_index] = 1;
+}
+
+/* Solves the rectangle (row, col, rows, cols) of grid again without touching the rest of it. The rectangle is
+   solved from full domains in region, a separate grid configured with the strategies to use whose memory fits
+   rows x cols cells, with the collapsed cells around it as fixed constraints. The work only depends on the size of
+   the rectangle. mask is optional (rows * cols entries): cells with a 0 entry keep their tile and constrain the
+   others. Only one attempt is made, region->rng picks the seed. The grid is written only on success.
+   Returns 1 if solved, 0 on a contradiction (another seed may succeed) and -1 if the fixed cells can not be met.
+   WFC_TOPOLOGY_SQUARE grids only, the rectangle of a WFC_BOUNDARY_PERIODIC grid has to be smaller than the grid. */
+WFC_API WFC_INLINE int wfc_grid_solve_region(wfc_grid *grid, wfc_tiles *tiles, unsigned int row, unsigned int col, unsigned int rows, unsigned int cols, unsigned char *mask,
+                                             wfc_grid *region, unsigned char *region_memory, unsigned int region_memory_size)
+{
+  unsigned int dir_count;
+  unsigned int x, y;
+
+  if (!grid || !tiles || !region || grid->topology != WFC_TOPOLOGY_SQUARE || rows < 1 || cols < 1 || row + rows > grid->rows || col + cols > grid->cols ||
+      (grid->boundary == WFC_BOUNDARY_PERIODIC && (rows == grid->rows || cols == grid->cols)))
+  {
+    return -1;
+  }
+
+  dir_count = tiles->tile_direction_count;
+  region->rows = rows;
+  region->cols = cols;
+  region->boundary = WFC_BOUNDARY_BOUNDED;
+
+  if (!wfc_grid_initialize(region, tiles, region_memory, region_memory_size))
+  {
+    return -1;
+  }
+
+  /* Kept cells inside the rectangle are pinned to their tile */
+  if (mask)
+  {
+    for (y = 0; y < rows * cols; ++y)
+    {
+      if (!mask[y] && !wfc_grid_constrain(region, y, &grid->cell_entropy_masks[((row + y / cols) * grid->cols + col + y % cols) * grid->cell_entropy_mask_words]))
+      {
+        return -1;
+      }
+    }
+  }
+
+  /* Collapsed cells of the grid next to the outermost ring of the rectangle are fixed */
+  for (y = 0; y < rows; ++y)
+  {
+    unsigned int step = (y == 0 || y == rows - 1) ? 1 : (cols > 1 ? cols - 1 : 1);
+
+    for (x = 0; x < cols; x += step)
+    {
+      unsigned int d;
+
+      for (d = 0; d < dir_count; ++d)
+      {
+        int neighbour_index = wfc_grid_neighbour_index(grid, (int)((row + y) * grid->cols + col + x), d, dir_count);
+        unsigned int neighbour = (unsigned int)neighbour_index;
+        unsigned int nx = neighbour % grid->cols;
+        unsigned int ny = neighbour / grid->cols;
+
+        /* Neighbours past a bounded edge are -1, which is past the grid as well */
+        if (neighbour_index < 0 || (nx >= col && nx < col + cols && ny >= row && ny < row + rows))
+        {
+          continue;
+        }
+
+        if (grid->cell_collapsed[neighbour] &&
+            !wfc_grid_constrain_neighbour_tile(region, tiles, y * cols + x, d, wfc_grid_find_nth_tile_in_mask(grid, neighbour, 0)))
+        {
+          return -1;
+        }
+      }
+    }
+  }
+
+  /* The pinned cells and borders restrict their neighbours before the first collapse with every propagation */
+  if (!wfc_grid_propagate_constraints(region, tiles) || !wfc(region, tiles))
+  {
+    return 0;
+  }
+
+  for (y = 0; y < rows; ++y)
+  {
+    for (x = 0; x < cols; ++x)
+    {
+      if (!mask || mask[y * cols + x])
+      {
+        wfc_grid_set_cell_tile(grid, (row + y) * grid->cols + col + x, wfc_grid_find_nth_tile_in_mask(region, y * cols + x, 0));
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Streaming world
+ * #############################################################################
+ */
+#define WFC_CHUNK_EMPTY 0
+#define WFC_CHUNK_SOLVED 1
+#define WFC_CHUNK_FAILED 2 /* Every attempt contradicted, the cell tiles are WFC_CELL_NONE */
+
+typedef struct wfc_world_chunk
+{
+  int x; /* Chunk coordinates, the chunk covers cells [x * chunk_cols, (x + 1) * chunk_cols) */
+  int y;
+  unsigned int state;       /* WFC_CHUNK_EMPTY, WFC_CHUNK_SOLVED or WFC_CHUNK_FAILED */
+  unsigned int *cell_tiles; /* Collapsed tile per cell. Size = chunk_rows * chunk_cols */
+
+} wfc_world_chunk;
+
+/* An unbounded world made of chunks that are generated around a viewer and evicted once out of range.
+   Every chunk is solved on its own with the border tiles of the already generated neighbour chunks imposed as
+   constraints, so the memory is fixed by the window of (2 * radius + 1)^2 chunks however far the viewer travels.
+   A chunk depends on the neighbours present when it is generated, revisited areas can therefore differ. */
+typedef struct wfc_world
+{
+  /* Configuration */
+  unsigned int chunk_rows;  /* Cells per chunk */
+  unsigned int chunk_cols;
+  unsigned int radius;      /* Chunks kept around the viewer chunk in every direction */
+  unsigned int seed;        /* Chunk seeds are derived from it and the chunk coordinates */
+  unsigned int retries_max; /* Restarts allowed per chunk after a contradiction */
+  wfc_grid grid;            /* Settings used to solve each chunk (selection, propagation, entropy, trail). Rows and cols are set by the world */
+
+  /* Runtime information */
+  int viewer_x; /* Chunk the viewer is in */
+  int viewer_y;
+  unsigned int chunks_generated;
+  unsigned int chunks_evicted;
+  unsigned int chunks_failed;
+  unsigned int attempts;
+
+  /* Data arrays */
+  unsigned int chunk_count;  /* (2 * radius + 1)^2 */
+  wfc_world_chunk *chunks;   /* Size = chunk_count */
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  wfc_rng rng;
+
+} wfc_world;
+
+WFC_API WFC_INLINE unsigned int wfc_world_memory_size(wfc_world *world, wfc_tiles *tiles)
+{
+  unsigned int chunk_count = (2 * world->radius + 1) * (2 * world->radius + 1);
+
+  world->grid.rows = world->chunk_rows;
+  world->grid.cols = world->chunk_cols;
+
+  return wfc_grid_memory_size(&world->grid, tiles) +
+         (unsigned int)(sizeof(wfc_world_chunk) * chunk_count + sizeof(unsigned int) * chunk_count * world->chunk_rows * world->chunk_cols);
+}
+
+WFC_API WFC_INLINE int wfc_world_initialize(wfc_world *world, wfc_tiles *tiles, unsigned char *world_memory, unsigned int world_memory_size)
+{
+  unsigned char *ptr = world_memory;
+  unsigned int i;
+
+  if (!world || !tiles || !tiles->tiles_initialized || !world_memory || world->chunk_rows < 1 || world->chunk_cols < 1 ||
+      world->grid.topology != WFC_TOPOLOGY_SQUARE || world->grid.boundary != WFC_BOUNDARY_BOUNDED ||
+      world_memory_size < wfc_world_memory_size(world, tiles))
+  {
+    return 0;
+  }
+
+  if (!tiles->tiles_compatible_tiles_computed && !wfc_tiles_compute_compatible_tiles(tiles))
+  {
+    return 0;
+  }
+
+  world->chunk_count = (2 * world->radius + 1) * (2 * world->radius + 1);
+  world->chunks_generated = 0;
+  world->chunks_evicted = 0;
+  world->chunks_failed = 0;
+  world->attempts = 0;
+  world->grid.rng = &world->rng;
+
+  /* The grid memory first, it keeps the alignment of the world memory */
+  world->grid_memory = ptr;
+  world->grid_memory_size = wfc_grid_memory_size(&world->grid, tiles);
+  ptr += world->grid_memory_size;
+
+  world->chunks = (wfc_world_chunk *)ptr;
+  ptr += sizeof(wfc_world_chunk) * world->chunk_count;
+
+  for (i = 0; i < world->chunk_count; ++i)
+  {
+    world->chunks[i].state = WFC_CHUNK_EMPTY;
+    world->chunks[i].cell_tiles = (unsigned int *)ptr;
+    ptr += sizeof(unsigned int) * world->chunk_rows * world->chunk_cols;
+  }
+
+  return 1;
+}
+
+/* Floor division, chunk coordinates are negative left of and above the origin */
+WFC_API WFC_INLINE int wfc_world_floor_div(int a, int b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/* Returns the loaded chunk at chunk coordinates (x, y) or 0 */
+WFC_API WFC_INLINE wfc_world_chunk *wfc_world_chunk_at(wfc_world *world, int x, int y)
+{
+  unsigned int i;
+
+  for (i = 0; i < world->chunk_count; ++i)
+  {
+    if (world->chunks[i].state != WFC_CHUNK_EMPTY && world->chunks[i].x == x && world->chunks[i].y == y)
+    {
+      return &world->chunks[i];
+    }
+  }
+
+  return (wfc_world_chunk *)0;
+}
+
+/* Returns the tile at world cell (x, y) or WFC_CELL_NONE if its chunk is not loaded or failed */
+WFC_API WFC_INLINE unsigned int wfc_world_tile_at(wfc_world *world, int x, int y)
+{
+  int chunk_x = wfc_world_floor_div(x, (int)world->chunk_cols);
+  int chunk_y = wfc_world_floor_div(y, (int)world->chunk_rows);
+  wfc_world_chunk *chunk = wfc_world_chunk_at(world, chunk_x, chunk_y);
+
+  if (!chunk)
+  {
+    return WFC_CELL_NONE;
+  }
+
+  return chunk->cell_tiles[(unsigned int)(y - chunk_y * (int)world->chunk_rows) * world->chunk_cols + (unsigned int)(x - chunk_x * (int)world->chunk_cols)];
+}
+
+/* Restricts the border cells of the chunk grid to the tiles that fit the generated neighbour chunks.
+   Returns 0 if a cell is left without tiles */
+WFC_API WFC_INLINE int wfc_world_constrain_borders(wfc_world *world, wfc_tiles *tiles, wfc_world_chunk *neighbours[3][3])
+{
+  unsigned int dir_count = tiles->tile_direction_count;
+  int rows = (int)world->chunk_rows;
+  int cols = (int)world->chunk_cols;
+  int x, y;
+
+  for (y = 0; y < rows; ++y)
+  {
+    /* Only the outermost ring of cells touches other chunks */
+    int step = (y == 0 || y == rows - 1) ? 1 : (cols > 1 ? cols - 1 : 1);
+
+    for (x = 0; x < cols; x += step)
+    {
+      unsigned int d;
+
+      for (d = 0; d < dir_count; ++d)
+      {
+        unsigned int dir = dir_count == 8 ? d : d * 2;
+        int nx = x + wfc_direction_dx[dir];
+        int ny = y + wfc_direction_dy[dir];
+        int offset_x = nx < 0 ? -1 : (nx >= cols ? 1 : 0);
+        int offset_y = ny < 0 ? -1 : (ny >= rows ? 1 : 0);
+        wfc_world_chunk *neighbour = neighbours[offset_y + 1][offset_x + 1];
+        unsigned int tile;
+
+        if ((offset_x == 0 && offset_y == 0) || !neighbour || neighbour->state != WFC_CHUNK_SOLVED)
+        {
+          continue;
+        }
+
+        tile = neighbour->cell_tiles[(unsigned int)(ny - offset_y * rows) * world->chunk_cols + (unsigned int)(nx - offset_x * cols)];
+
+        if (!wfc_grid_constrain_neighbour_tile(&world->grid, tiles, (unsigned int)(y * cols + x), d, tile))
+        {
+          return 0;
+        }
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* Generates the chunk at (x, y) into slot chunk */
+WFC_API WFC_INLINE void wfc_world_generate_chunk(wfc_world *world, wfc_tiles *tiles, wfc_world_chunk *chunk, int x, int y)
+{
+  wfc_world_chunk *neighbours[3][3];
+  unsigned int cell_count = world->chunk_rows * world->chunk_cols;
+  unsigned int chunk_seed = world->seed + (unsigned int)x * 0x9E3779B1u + (unsigned int)y * 0x85EBCA77u;
+  unsigned int attempt;
+  unsigned int i;
+  int ox, oy;
+
+  chunk_seed = wfc_splitmix32_next(&chunk_seed);
+
+  for (oy = -1; oy <= 1; ++oy)
+  {
+    for (ox = -1; ox <= 1; ++ox)
+    {
+      neighbours[oy + 1][ox + 1] = wfc_world_chunk_at(world, x + ox, y + oy);
+    }
+  }
+
+  chunk->x = x;
+  chunk->y = y;
+  chunk->state = WFC_CHUNK_FAILED;
+
+  for (attempt = 0; attempt <= world->retries_max; ++attempt)
+  {
+    wfc_rng_seed(&world->rng, chunk_seed + attempt);
+    world->attempts++;
+
+    /* Borders that can not be met stay unmet on every attempt */
+    if (!wfc_grid_initialize(&world->grid, tiles, world->grid_memory, world->grid_memory_size) ||
+        !wfc_world_constrain_borders(world, tiles, neighbours))
+    {
+      break;
+    }
+
+    if (wfc(&world->grid, tiles))
+    {
+      chunk->state = WFC_CHUNK_SOLVED;
+      break;
+    }
+  }
+
+  for (i = 0; i < cell_count; ++i)
+  {
+    chunk->cell_tiles[i] = chunk->state == WFC_CHUNK_SOLVED ? wfc_grid_find_nth_tile_in_mask(&world->grid, i, 0) : WFC_CELL_NONE;
+  }
+
+  world->chunks_generated++;
+  world->chunks_failed += chunk->state == WFC_CHUNK_FAILED ? 1u : 0u;
+}
+
+/* Moves the viewer to world cell (x, y): evicts the chunks out of range and generates the missing ones, nearest
+   first. Returns the number of chunks generated */
+WFC_API WFC_INLINE unsigned int wfc_world_update(wfc_world *world, wfc_tiles *tiles, int x, int y)
+{
+  int radius = (int)world->radius;
+  unsigned int generated = 0;
+  unsigned int i;
+  int ring;
+
+  world->viewer_x = wfc_world_floor_div(x, (int)world->chunk_cols);
+  world->viewer_y = wfc_world_floor_div(y, (int)world->chunk_rows);
+
+  for (i = 0; i < world->chunk_count; ++i)
+  {
+    wfc_world_chunk *chunk = &world->chunks[i];
+
+    if (chunk->state != WFC_CHUNK_EMPTY &&
+        (chunk->x < world->viewer_x - radius || chunk->x > world->viewer_x + radius ||
+         chunk->y < world->viewer_y - radius || chunk->y > world->viewer_y + radius))
+    {
+      chunk->state = WFC_CHUNK_EMPTY;
+      world->chunks_evicted++;
+    }
+  }
+
+  for (ring = 0; ring <= radius; ++ring)
+  {
+    int cx, cy;
+
+    for (cy = world->viewer_y - ring; cy <= world->viewer_y + ring; ++cy)
+    {
+      for (cx = world->viewer_x - ring; cx <= world->viewer_x + ring; ++cx)
+      {
+        /* Cells on the ring only */
+        if (cy != world->viewer_y - ring && cy != world->viewer_y + ring && cx != world->viewer_x - ring && cx != world->viewer_x + ring)
+        {
+          continue;
+        }
+
+        if (wfc_world_chunk_at(world, cx, cy))
+        {
+          continue;
+        }
+
+        /* The window always has a free slot for every missing chunk */
+        for (i = 0; i < world->chunk_count; ++i)
+        {
+          if (world->chunks[i].state == WFC_CHUNK_EMPTY)
+          {
+            wfc_world_generate_chunk(world, tiles, &world->chunks[i], cx, cy);
+            generated++;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  return generated;
+}
+
+#ifdef WFC_THREADS
+/* #############################################################################
+ * # Batch solving
+ * #############################################################################
+ */
+#define WFC_BATCH_PENDING 0
+#define WFC_BATCH_SOLVED 1
+#define WFC_BATCH_FAILED 2 /* Every attempt contradicted or the grid memory was too small */
+
+/* One grid of a batch. Every job needs its own grid and grid memory, only the tiles are shared */
+typedef struct wfc_batch_job
+{
+  /* Input */
+  wfc_grid *grid;                /* Configured grid (rows, cols, strategies). Its rng is set to the job's own state */
+  unsigned char *grid_memory;    /* Size: wfc_grid_memory_size(grid, tiles) */
+  unsigned int grid_memory_size;
+  unsigned int seed;             /* Attempt n is seeded with seed + n, so the result does not depend on the scheduling */
+  unsigned int retries_max;      /* Restarts allowed after a contradiction (0 = a single attempt) */
+
+  /* Output */
+  unsigned int status;   /* WFC_BATCH_SOLVED or WFC_BATCH_FAILED */
+  unsigned int attempts; /* wfc() runs used */
+  unsigned int worker;   /* Worker that ran the job */
+  unsigned int stolen;   /* 1 if the job was taken from the queue of another worker */
+  double time_start;     /* Nanoseconds from the batch start until the job started (batch clock, 0 without) */
+  double time;           /* Nanoseconds the job took (batch clock, 0 without) */
+
+  /* Internal */
+  volatile unsigned int claimed;
+  wfc_rng rng;
+
+} wfc_batch_job;
+
+/* Queue of one worker: the contiguous job range [front, back). The owner takes jobs from the front, idle workers
+   steal from the back, so they only meet on the last job of the range which the job claim settles */
+typedef struct wfc_batch_worker
+{
+  volatile unsigned int front;
+  volatile unsigned int back;
+  unsigned int index;
+  struct wfc_batch *batch;
+  unsigned char padding[64]; /* Keeps the counters of two workers off the same cache line */
+
+} wfc_batch_worker;
+
+typedef struct wfc_batch
+{
+  wfc_tiles *tiles;
+  wfc_batch_job *jobs;
+  unsigned int worker_count;
+  double (*clock)(void);
+  double time_start;
+  wfc_batch_worker workers[WFC_THREADS_MAX];
+
+} wfc_batch;
+
+WFC_API WFC_INLINE void wfc_batch_run_job(wfc_batch *batch, wfc_batch_worker *worker, unsigned int job_index, unsigned int stolen)
+{
+  wfc_batch_job *job = &batch->jobs[job_index];
+  double time_start;
+
+  /* Owner and thief can reach the same job once, only one of them runs it */
+  if (wfc_atomic_cas(&job->claimed, 0, 1) != 0)
+  {
+    return;
+  }
+
+  time_start = batch->clock ? batch->clock() : 0.0;
+
+  job->worker = worker->index;
+  job->stolen = stolen;
+  job->attempts = 0;
+  job->status = WFC_BATCH_FAILED;
+  job->grid->rng = &job->rng;
+
+  while (job->attempts <= job->retries_max)
+  {
+    wfc_rng_seed(&job->rng, job->seed + job->attempts);
+
+    if (!wfc_grid_initialize(job->grid, batch->tiles, job->grid_memory, job->grid_memory_size))
+    {
+      break;
+    }
+
+    job->attempts++;
+
+    if (wfc(job->grid, batch->tiles))
+    {
+      job->status = WFC_BATCH_SOLVED;
+      break;
+    }
+  }
+
+  job->time_start = batch->clock ? time_start - batch->time_start : 0.0;
+  job->time = batch->clock ? batch->clock() - time_start : 0.0;
+}
+
+static void wfc_batch_worker_run(void *argument)
+{
+  wfc_batch_worker *worker = (wfc_batch_worker *)argument;
+  wfc_batch *batch = worker->batch;
+  unsigned int i;
+
+  /* Own queue first, front to back */
+  for (;;)
+  {
+    unsigned int job_index = wfc_atomic_add(&worker->front, 1);
+
+    if (job_index >= wfc_atomic_load(&worker->back))
+    {
+      break;
+    }
+
+    wfc_batch_run_job(batch, worker, job_index, 0);
+  }
+
+  /* Then steal single jobs from the back of the other queues. Queues never grow, so one pass drains them all */
+  for (i = 1; i < batch->worker_count; ++i)
+  {
+    wfc_batch_worker *victim = &batch->workers[(worker->index + i) % batch->worker_count];
+
+    for (;;)
+    {
+      unsigned int back = wfc_atomic_load(&victim->back);
+
+      if (wfc_atomic_load(&victim->front) >= back)
+      {
+        break;
+      }
+
+      if (wfc_atomic_cas(&victim->back, back, back - 1) == back)
+      {
+        wfc_batch_run_job(batch, worker, back - 1, 1);
+      }
+    }
+  }
+}
+
+/* Solves job_count independent grids on thread_count threads (the calling thread included) that share one
+   read-only tile set. Every worker starts on its own contiguous share of the jobs and steals from the others
+   once it runs dry, so uneven grid sizes and retries do not leave threads idle.
+   clock is optional and returns nanoseconds for the job timings. Returns the number of solved jobs. */
+WFC_API WFC_INLINE unsigned int wfc_batch_solve(wfc_tiles *tiles, wfc_batch_job *jobs, unsigned int job_count, unsigned int thread_count, double (*clock)(void))
+{
+  wfc_thread threads[WFC_THREADS_MAX];
+  wfc_batch batch;
+  unsigned int started = 1;
+  unsigned int solved = 0;
+  unsigned int i;
+
+  if (!tiles || !tiles->tiles_initialized || !jobs || thread_count < 1 || thread_count > WFC_THREADS_MAX)
+  {
+    return 0;
+  }
+
+  /* wfc() would compute them on first use, which is a write to the shared tiles */
+  if (!tiles->tiles_compatible_tiles_computed && !wfc_tiles_compute_compatible_tiles(tiles))
+  {
+    return 0;
+  }
+
+  batch.tiles = tiles;
+  batch.jobs = jobs;
+  batch.worker_count = thread_count;
+  batch.clock = clock;
+  batch.time_start = clock ? clock() : 0.0;
+
+  for (i = 0; i < job_count; ++i)
+  {
+    jobs[i].status = WFC_BATCH_PENDING;
+    jobs[i].attempts = 0;
+    jobs[i].claimed = 0;
+  }
+
+  for (i = 0; i < thread_count; ++i)
+  {
+    batch.workers[i].front = job_count / thread_count * i + (i < job_count % thread_count ? i : job_count % thread_count);
+    batch.workers[i].back = batch.workers[i].front + job_count / thread_count + (i < job_count % thread_count ? 1u : 0u);
+    batch.workers[i].index = i;
+    batch.workers[i].batch = &batch;
+  }
+
+  /* Queues of workers that could not get a thread are drained by stealing */
+  for (i = 1; i < thread_count; ++i)
+  {
+    if (!wfc_thread_create(&threads[i], wfc_batch_worker_run, &batch.workers[i]))
+    {
+      break;
+    }
+
+    started++;
+  }
+
+  wfc_batch_worker_run(&batch.workers[0]);
+
+  for (i = 1; i < started; ++i)
+  {
+    wfc_thread_join(&threads[i]);
+  }
+
+  for (i = 0; i < job_count; ++i)
+  {
+    solved += jobs[i].status == WFC_BATCH_SOLVED;
+  }
+
+  return solved;
+}
+
+/* #############################################################################
+ * # Speculative seed race
+ * #############################################################################
+ */
+#define WFC_RACE_FIRST 0        /* The first attempt to succeed wins, the result depends on the scheduling */
+#define WFC_RACE_LOWEST_SEED 1  /* The lowest succeeding seed wins, the same grid as the serial retry loop */
+
+/* One grid buffer of a race. All lanes must be configured with the same grid settings */
+typedef struct wfc_race_lane
+{
+  /* Input */
+  wfc_grid *grid;
+  unsigned char *grid_memory; /* Size: wfc_grid_memory_size(grid, tiles) */
+  unsigned int grid_memory_size;
+
+  /* Output */
+  unsigned int attempts;  /* Attempts started in this lane */
+  unsigned int cancelled; /* 1 if the lane's last attempt was cancelled */
+
+  /* Internal */
+  volatile unsigned int attempt; /* Attempt currently running, WFC_CELL_NONE before the first one */
+  volatile unsigned int cancel;
+  unsigned int solved_attempt;
+  wfc_rng rng;
+  struct wfc_race *race;
+  unsigned char padding[64]; /* Keeps the flags of two lanes off the same cache line */
+
+} wfc_race_lane;
+
+typedef struct wfc_race
+{
+  wfc_tiles *tiles;
+  wfc_race_lane *lanes;
+  unsigned int lane_count;
+  unsigned int mode;
+  unsigned int seed;
+  unsigned int retries_max;
+  volatile unsigned int next_attempt;
+  volatile unsigned int best_attempt; /* Winning attempt so far or WFC_CELL_NONE */
+
+} wfc_race;
+
+/* Publishes a solved attempt. Returns 1 if it is the best so far and cancels the attempts it makes pointless */
+WFC_API WFC_INLINE int wfc_race_publish(wfc_race *race, wfc_race_lane *lane, unsigned int attempt)
+{
+  unsigned int i;
+
+  for (;;)
+  {
+    unsigned int best = wfc_atomic_load(&race->best_attempt);
+
+    if ((race->mode == WFC_RACE_FIRST && best != WFC_CELL_NONE) || attempt >= best)
+    {
+      return 0;
+    }
+
+    if (wfc_atomic_cas(&race->best_attempt, best, attempt) == best)
+    {
+      break;
+    }
+  }
+
+  /* Attempts with a higher seed can not win anymore (in WFC_RACE_FIRST mode nothing can) */
+  for (i = 0; i < race->lane_count; ++i)
+  {
+    wfc_race_lane *other = &race->lanes[i];
+
+    if (other != lane && (race->mode == WFC_RACE_FIRST || wfc_atomic_load(&other->attempt) > attempt))
+    {
+      wfc_atomic_add(&other->cancel, 1);
+    }
+  }
+
+  return 1;
+}
+
+static void wfc_race_lane_run(void *argument)
+{
+  wfc_race_lane *lane = (wfc_race_lane *)argument;
+  wfc_race *race = lane->race;
+
+  for (;;)
+  {
+    unsigned int attempt = wfc_atomic_add(&race->next_attempt, 1);
+    unsigned int best;
+
+    /* Announced before checking the best attempt so that a concurrent publish either sees it or is seen */
+    wfc_atomic_store(&lane->attempt, attempt);
+    best = wfc_atomic_load(&race->best_attempt);
+
+    if (attempt > race->retries_max || wfc_atomic_load(&lane->cancel) ||
+        (race->mode == WFC_RACE_FIRST ? best != WFC_CELL_NONE : attempt > best))
+    {
+      break;
+    }
+
+    wfc_rng_seed(&lane->rng, race->seed + attempt);
+
+    if (!wfc_grid_initialize(lane->grid, race->tiles, lane->grid_memory, lane->grid_memory_size))
+    {
+      break;
+    }
+
+    lane->attempts++;
+
+    if (wfc(lane->grid, race->tiles))
+    {
+      /* A solved lane keeps its grid, later attempts could only lose */
+      if (wfc_race_publish(race, lane, attempt))
+      {
+        lane->solved_attempt = attempt;
+      }
+
+      break;
+    }
+
+    if (wfc_atomic_load(&lane->cancel))
+    {
+      lane->cancelled = 1;
+      break;
+    }
+  }
+}
+
+/* Runs the attempts of one grid (seed, seed + 1, ... seed + retries_max) on lane_count threads (the calling thread
+   included), each lane solving into its own grid buffer. Attempts that can no longer win are cancelled
+   cooperatively through grid->cancel. Returns the index of the lane holding the solved grid or -1 if no attempt
+   succeeded, *seed_used receives the winning seed. */
+WFC_API WFC_INLINE int wfc_race_solve(wfc_tiles *tiles, wfc_race_lane *lanes, unsigned int lane_count, unsigned int mode, unsigned int seed, unsigned int retries_max, unsigned int *seed_used)
+{
+  wfc_thread threads[WFC_THREADS_MAX];
+  wfc_race race;
+  unsigned int started = 1;
+  unsigned int i;
+  int winner = -1;
+
+  if (!tiles || !tiles->tiles_initialized || !lanes || lane_count < 1 || lane_count > WFC_THREADS_MAX || retries_max == WFC_CELL_NONE)
+  {
+    return -1;
+  }
+
+  if (!tiles->tiles_compatible_tiles_computed && !wfc_tiles_compute_compatible_tiles(tiles))
+  {
+    return -1;
+  }
+
+  race.tiles = tiles;
+  race.lanes = lanes;
+  race.lane_count = lane_count;
+  race.mode = mode;
+  race.seed = seed;
+  race.retries_max = retries_max;
+  race.next_attempt = 0;
+  race.best_attempt = WFC_CELL_NONE;
+
+  for (i = 0; i < lane_count; ++i)
+  {
+    lanes[i].attempts = 0;
+    lanes[i].cancelled = 0;
+    lanes[i].attempt = WFC_CELL_NONE;
+    lanes[i].cancel = 0;
+    lanes[i].solved_attempt = WFC_CELL_NONE;
+    lanes[i].race = &race;
+    lanes[i].grid->rng = &lanes[i].rng;
+    lanes[i].grid->cancel = &lanes[i].cancel;
+  }
+
+  for (i = 1; i < lane_count; ++i)
+  {
+    if (!wfc_thread_create(&threads[i], wfc_race_lane_run, &lanes[i]))
+    {
+      break;
+    }
+
+    started++;
+  }
+
+  wfc_race_lane_run(&lanes[0]);
+
+  for (i = 1; i < started; ++i)
+  {
+    wfc_thread_join(&threads[i]);
+  }
+
+  for (i = 0; i < lane_count; ++i)
+  {
+    lanes[i].grid->cancel = (volatile unsigned int *)0;
+
+    if (race.best_attempt != WFC_CELL_NONE && lanes[i].solved_attempt == race.best_attempt)
+    {
+      winner = (int)i;
+    }
+  }
+
+  if (winner >= 0 && seed_used)
+  {
+    *seed_used = seed + race.best_attempt;
+  }
+
+  return winner;
+}
+
+/* #############################################################################
+ * # Domain-decomposed solving
+ * #############################################################################
+ */
+#define WFC_PARALLEL_PHASE_BLOCKS 0            /* Blocks, separated by the seams, are independent */
+#define WFC_PARALLEL_PHASE_VERTICAL_SEAMS 1    /* Seams between horizontally adjacent blocks */
+#define WFC_PARALLEL_PHASE_HORIZONTAL_SEAMS 2  /* Seams between vertically adjacent blocks */
+#define WFC_PARALLEL_PHASE_CROSSINGS 3         /* Where the seams meet */
+#define WFC_PARALLEL_PHASE_COUNT 4
+
+/* Scratch grid of one thread, regions are solved in it and copied into the large grid */
+typedef struct wfc_parallel_worker
+{
+  wfc_grid grid;
+  unsigned char *grid_memory;
+  unsigned int grid_memory_size;
+  wfc_rng rng;
+  struct wfc_parallel *parallel;
+
+  /* Counters summed up once the solve ends */
+  unsigned int attempts;
+  unsigned int block_failures;
+  unsigned int seam_failures;
+  unsigned char padding[64]; /* Keeps the counters of two workers off the same cache line */
+
+} wfc_parallel_worker;
+
+/* Solves one large grid on several threads. The grid is split into blocks of block_rows x block_cols cells with
+   seam cells between them. The blocks are solved concurrently first, then the seams with the tiles of the blocks
+   around them as fixed constraints, in three phases so that the regions of one phase never touch (vertical seams,
+   horizontal seams, crossings). A region that still contradicts after its retries is re-solved by the calling
+   thread together with a margin of repair_margin cells of its neighbours, growing on every repair.
+   Region seeds only depend on the seed and the region position, so the result is the same for any thread count. */
+typedef struct wfc_parallel
+{
+  /* Configuration */
+  unsigned int block_rows;
+  unsigned int block_cols;
+  unsigned int seam;          /* Width of the strips between blocks (>= 1) */
+  unsigned int thread_count;  /* Threads including the calling one */
+  unsigned int seed;
+  unsigned int retries_max;   /* Restarts allowed per region after a contradiction */
+  unsigned int repairs_max;   /* Local re-solves of a failed region, each with repair_margin more cells around it */
+  unsigned int repair_margin;
+  wfc_grid grid;              /* Settings used to solve each region (selection, propagation, entropy, trail). Rows and cols are set per region */
+
+  /* Runtime information */
+  unsigned int block_count;
+  unsigned int seam_count;     /* Seam and crossing regions */
+  unsigned int block_failures; /* Blocks that failed every retry */
+  unsigned int seam_failures;  /* Seams and crossings that failed every retry with the blocks fixed */
+  unsigned int repairs;        /* Local re-solves run */
+  unsigned int repairs_failed; /* Failed regions not even the largest margin could repair */
+  unsigned int attempts;
+
+  /* Internal */
+  wfc_tiles *tiles;
+  wfc_grid *target;
+  wfc_parallel_worker *workers;
+  unsigned int phase;
+  unsigned int blocks_x;
+  unsigned int blocks_y;
+  volatile unsigned int next_region;
+
+} wfc_parallel;
+
+/* Grid memory of one worker, large enough for a block or seam with the largest repair margin around it */
+WFC_API WFC_INLINE unsigned int wfc_parallel_grid_memory_size(wfc_parallel *parallel, wfc_tiles *tiles)
+{
+  unsigned int margin = 2 * parallel->repair_margin * parallel->repairs_max;
+
+  parallel->grid.rows = (parallel->block_rows > parallel->seam ? parallel->block_rows : parallel->seam) + margin;
+  parallel->grid.cols = (parallel->block_cols > parallel->seam ? parallel->block_cols : parallel->seam) + margin;
+
+  /* Rounded up so that every worker's grid memory stays 8 byte aligned */
+  return (wfc_grid_memory_size(&parallel->grid, tiles) + 7u) & ~7u;
+}
+
+WFC_API WFC_INLINE unsigned int wfc_parallel_memory_size(wfc_parallel *parallel, wfc_tiles *tiles)
+{
+  return (wfc_parallel_grid_memory_size(parallel, tiles) + (unsigned int)sizeof(wfc_parallel_worker)) * parallel->thread_count;
+}
+
+/* Rectangle of region index in the given phase. Returns 0 if the region is empty (at the right or bottom border) */
+WFC_API WFC_INLINE int wfc_parallel_region(wfc_parallel *parallel, unsigned int phase, unsigned int index, unsigned int *row, unsigned int *col, unsigned int *rows, unsigned int *cols)
+{
+  unsigned int block_x = index % parallel->blocks_x;
+  unsigned int block_y = index / parallel->blocks_x;
+  unsigned int start_col = block_x * (parallel->block_cols + parallel->seam);
+  unsigned int start_row = block_y * (parallel->block_rows + parallel->seam);
+  unsigned int size_cols = parallel->block_cols;
+  unsigned int size_rows = parallel->block_rows;
+
+  if (phase == WFC_PARALLEL_PHASE_VERTICAL_SEAMS || phase == WFC_PARALLEL_PHASE_CROSSINGS)
+  {
+    start_col += parallel->block_cols;
+    size_cols = parallel->seam;
+  }
+
+  if (phase == WFC_PARALLEL_PHASE_HORIZONTAL_SEAMS || phase == WFC_PARALLEL_PHASE_CROSSINGS)
+  {
+    start_row += parallel->block_rows;
+    size_rows = parallel->seam;
+  }
+
+  if (start_col >= parallel->target->cols || start_row >= parallel->target->rows)
+  {
+    return 0;
+  }
+
+  *row = start_row;
+  *col = start_col;
+  *rows = start_row + size_rows > parallel->target->rows ? parallel->target->rows - start_row : size_rows;
+  *cols = start_col + size_cols > parallel->target->cols ? parallel->target->cols - start_col : size_cols;
+
+  return 1;
+}
+
+/* Returns 1 if every cell of the rectangle is collapsed */
+WFC_API WFC_INLINE int wfc_parallel_region_solved(wfc_grid *grid, unsigned int row, unsigned int col, unsigned int rows, unsigned int cols)
+{
+  unsigned int x, y;
+
+  for (y = row; y < row + rows; ++y)
+  {
+    for (x = col; x < col + cols; ++x)
+    {
+      if (!grid->cell_collapsed[y * grid->cols + x])
+      {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* Solves the rectangle of the large grid in the worker's grid and collapses it in the large grid. Returns 0 if
+   every attempt contradicted */
+WFC_API WFC_INLINE int wfc_parallel_solve_region(wfc_parallel *parallel, wfc_parallel_worker *worker, unsigned int row, unsigned int col, unsigned int rows, unsigned int cols)
+{
+  unsigned int region_seed = parallel->seed + row * 0x9E3779B1u + col * 0x85EBCA77u;
+  unsigned int attempt;
+
+  region_seed = wfc_splitmix32_next(&region_seed);
+
+  worker->grid = parallel->grid;
+  worker->grid.rng = &worker->rng;
+
+  for (attempt = 0; attempt <= parallel->retries_max; ++attempt)
+  {
+    int result;
+
+    wfc_rng_seed(&worker->rng, region_seed + attempt);
+    worker->attempts++;
+
+    result = wfc_grid_solve_region(parallel->target, parallel->tiles, row, col, rows, cols, (unsigned char *)0,
+                                   &worker->grid, worker->grid_memory, worker->grid_memory_size);
+
+    /* Fixed borders that can not be met stay unmet on every attempt */
+    if (result != 0)
+    {
+      return result == 1;
+    }
+  }
+
+  return 0;
+}
+
+static void wfc_parallel_worker_run(void *argument)
+{
+  wfc_parallel_worker *worker = (wfc_parallel_worker *)argument;
+  wfc_parallel *parallel = worker->parallel;
+  unsigned int region_count = parallel->blocks_x * parallel->blocks_y;
+
+  for (;;)
+  {
+    unsigned int index = wfc_atomic_add(&parallel->next_region, 1);
+    unsigned int row, col, rows, cols;
+
+    if (index >= region_count)
+    {
+      break;
+    }
+
+    if (wfc_parallel_region(parallel, parallel->phase, index, &row, &col, &rows, &cols) &&
+        !wfc_parallel_solve_region(parallel, worker, row, col, rows, cols))
+    {
+      if (parallel->phase == WFC_PARALLEL_PHASE_BLOCKS)
+      {
+        worker->block_failures++;
+      }
+      else
+      {
+        worker->seam_failures++;
+      }
+    }
+  }
+}
+
+/* Collapses every cell of an initialized grid (any strategies, only its masks, entropy counts and collapsed flags
+   are written) using thread_count threads. memory holds the worker grids, size: wfc_parallel_memory_size().
+   Returns 1 if the whole grid is solved. */
+WFC_API WFC_INLINE int wfc_parallel_solve(wfc_parallel *parallel, wfc_grid *grid, wfc_tiles *tiles, unsigned char *memory, unsigned int memory_size)
+{
+  wfc_thread threads[WFC_THREADS_MAX];
+  unsigned int grid_memory_size;
+  unsigned int phase;
+  unsigned int i;
+
+  if (!parallel || !grid || !tiles || !tiles->tiles_initialized || !memory || parallel->block_rows < 1 || parallel->block_cols < 1 ||
+      parallel->seam < 1 || parallel->thread_count < 1 || parallel->thread_count > WFC_THREADS_MAX ||
+      grid->rows < 1 || grid->cols < 1 || grid->topology != WFC_TOPOLOGY_SQUARE || grid->boundary != WFC_BOUNDARY_BOUNDED ||
+      memory_size < wfc_parallel_memory_size(parallel, tiles))
+  {
+    return 0;
+  }
+
+  /* wfc() would compute them on first use, which is a write to the shared tiles */
+  if (!tiles->tiles_compatible_tiles_computed && !wfc_tiles_compute_compatible_tiles(tiles))
+  {
+    return 0;
+  }
+
+  grid_memory_size = wfc_parallel_grid_memory_size(parallel, tiles);
+
+  parallel->tiles = tiles;
+  parallel->target = grid;
+  parallel->blocks_x = (grid->cols + parallel->block_cols + parallel->seam - 1) / (parallel->block_cols + parallel->seam);
+  parallel->blocks_y = (grid->rows + parallel->block_rows + parallel->seam - 1) / (parallel->block_rows + parallel->seam);
+  parallel->block_count = 0;
+  parallel->seam_count = 0;
+  parallel->block_failures = 0;
+  parallel->seam_failures = 0;
+  parallel->repairs = 0;
+  parallel->repairs_failed = 0;
+  parallel->attempts = 0;
+
+  /* The worker grid memories first, they keep the alignment of memory */
+  parallel->workers = (wfc_parallel_worker *)(memory + grid_memory_size * parallel->thread_count);
+
+  for (i = 0; i < parallel->thread_count; ++i)
+  {
+    parallel->workers[i].grid_memory = memory + grid_memory_size * i;
+    parallel->workers[i].grid_memory_size = grid_memory_size;
+    parallel->workers[i].parallel = parallel;
+    parallel->workers[i].attempts = 0;
+    parallel->workers[i].block_failures = 0;
+    parallel->workers[i].seam_failures = 0;
+  }
+
+  for (i = 0; i < grid->rows * grid->cols; ++i)
+  {
+    grid->cell_collapsed[i] = 0;
+  }
+
+  for (phase = 0; phase < WFC_PARALLEL_PHASE_COUNT; ++phase)
+  {
+    unsigned int started = 1;
+    unsigned int row, col, rows, cols;
+
+    parallel->phase = phase;
+    parallel->next_region = 0;
+
+    for (i = 1; i < parallel->thread_count; ++i)
+    {
+      if (!wfc_thread_create(&threads[i], wfc_parallel_worker_run, &parallel->workers[i]))
+      {
+        break;
+      }
+
+      started++;
+    }
+
+    wfc_parallel_worker_run(&parallel->workers[0]);
+
+    for (i = 1; i < started; ++i)
+    {
+      wfc_thread_join(&threads[i]);
+    }
+
+    /* Regions left uncollapsed are re-solved one at a time with a growing margin of their neighbours */
+    for (i = 0; i < parallel->blocks_x * parallel->blocks_y; ++i)
+    {
+      unsigned int repair;
+
+      if (!wfc_parallel_region(parallel, phase, i, &row, &col, &rows, &cols))
+      {
+        continue;
+      }
+
+      if (phase == WFC_PARALLEL_PHASE_BLOCKS)
+      {
+        parallel->block_count++;
+      }
+      else
+      {
+        parallel->seam_count++;
+      }
+
+      /* A repair of an earlier region may have covered this one partly */
+      for (repair = 1; repair <= parallel->repairs_max && !wfc_parallel_region_solved(grid, row, col, rows, cols); ++repair)
+      {
+        unsigned int margin = repair * parallel->repair_margin;
+        unsigned int repair_row = row > margin ? row - margin : 0;
+        unsigned int repair_col = col > margin ? col - margin : 0;
+        unsigned int repair_rows = row + rows + margin < grid->rows ? row + rows + margin - repair_row : grid->rows - repair_row;
+        unsigned int repair_cols = col + cols + margin < grid->cols ? col + cols + margin - repair_col : grid->cols - repair_col;
+
+        /* The whole rectangle is solved from full domains with the collapsed cells around it fixed, and only written on
+           success, so a failed repair leaves the margin as it was */
+        parallel->repairs++;
+        wfc_parallel_solve_region(parallel, &parallel->workers[0], repair_row, repair_col, repair_rows, repair_cols);
+      }
+
+      if (!wfc_parallel_region_solved(grid, row, col, rows, cols))
+      {
+        parallel->repairs_failed++;
+      }
+    }
+  }
+
+  grid->cells_processed = 0;
+
+  for (i = 0; i < grid->rows * grid->cols; ++i)
+  {
+    grid->cells_processed += grid->cell_collapsed[i];
+  }
+
+  for (i = 0; i < parallel->thread_count; ++i)
+  {
+    parallel->attempts += parallel->workers[i].attempts;
+    parallel->block_failures += parallel->workers[i].block_failures;
+    parallel->seam_failures += parallel->workers[i].seam_failures;
+  }
+
+  return grid->cells_processed == grid->rows * grid->cols;
+}
+#endif /* WFC_THREADS */
+
+#endif /* WFC_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/